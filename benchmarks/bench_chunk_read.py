@@ -0,0 +1,35 @@
+"""
+Chunked and time windowed reads of a whole recording.
+"""
+
+from utils import best_time, get_parser, get_recording, print_result
+
+from expelliarmus import Wizard
+
+
+def read_all(wizard, generator):
+    wizard.reset()
+    return sum(len(arr) for arr in generator())
+
+
+if __name__ == "__main__":
+    parser = get_parser(__doc__)
+    parser.add_argument("--chunk-size", default=512, type=int)
+    parser.add_argument("--time-window", default=1000, type=int)
+    args = parser.parse_args()
+    fpath = get_recording(args)
+    wizard = Wizard(
+        encoding=args.encoding,
+        fpath=fpath,
+        chunk_size=args.chunk_size,
+        time_window=args.time_window,
+    )
+    print(f"{fpath} ({fpath.stat().st_size/2**20:.1f} MB)")
+    print_result(
+        f"chunks of {args.chunk_size} events",
+        best_time(lambda: read_all(wizard, wizard.read_chunk), args.runs),
+    )
+    print_result(
+        f"time windows of {args.time_window} us",
+        best_time(lambda: read_all(wizard, wizard.read_time_window), args.runs),
+    )
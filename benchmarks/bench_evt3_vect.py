@@ -0,0 +1,86 @@
+"""
+EVT3 decoding of synthetic streams with low and high density of vector events (VECT_12, VECT_8).
+"""
+
+import pathlib
+import tempfile
+
+import numpy as np
+from utils import best_time, get_parser, print_result
+
+from expelliarmus import Wizard
+
+# EVT3 word types.
+ADDR_Y, ADDR_X, VECT_BASE_X, VECT_12, VECT_8, TIME_LOW, TIME_HIGH = (
+    0x0,
+    0x2,
+    0x3,
+    0x4,
+    0x5,
+    0x6,
+    0x8,
+)
+
+
+def make_stream(vect: bool, nsteps: int, seed: int = 0) -> pathlib.Path:
+    """
+    Generates an EVT3 recording with nsteps TIME_LOW words. Each step carries
+    either 8 ADDR_X events (low density) or a row of 44 pixels encoded by three
+    VECT_12 and one VECT_8 words with random masks (high density).
+    """
+    rng = np.random.default_rng(seed)
+    steps = np.arange(nsteps)
+    if vect:
+        block = np.empty((nsteps, 7), dtype=np.uint16)
+        block[:, 0] = (TIME_LOW << 12) | (steps & 0xFFF)
+        block[:, 1] = (ADDR_Y << 12) | rng.integers(0, 720, nsteps)
+        block[:, 2] = (VECT_BASE_X << 12) | rng.integers(0, 1280 - 44, nsteps)
+        block[:, 3:6] = (VECT_12 << 12) | rng.integers(0, 1 << 12, (nsteps, 3))
+        block[:, 6] = (VECT_8 << 12) | rng.integers(0, 1 << 8, nsteps)
+    else:
+        block = np.empty((nsteps, 10), dtype=np.uint16)
+        block[:, 0] = (TIME_LOW << 12) | (steps & 0xFFF)
+        block[:, 1] = (ADDR_Y << 12) | rng.integers(0, 720, nsteps)
+        block[:, 2:] = (ADDR_X << 12) | rng.integers(0, 1 << 12, (nsteps, 8)) % 1280
+    # A TIME_HIGH word every time TIME_LOW wraps.
+    time_high = (TIME_HIGH << 12) | ((steps >> 12) & 0xFFF)
+    words = np.concatenate((time_high[:, None], block), axis=1)
+    keep = np.ones(words.shape, dtype=bool)
+    keep[:, 0] = (steps & 0xFFF) == 0
+    fpath = pathlib.Path(tempfile.gettempdir()).joinpath(
+        f"expelliarmus_bench_evt3_{'high' if vect else 'low'}.raw"
+    )
+    with open(fpath, "wb") as fp:
+        fp.write(b"% evt 3.0\n")
+        fp.write(words[keep].astype("<u2").tobytes())
+    return fpath
+
+
+if __name__ == "__main__":
+    parser = get_parser(__doc__)
+    parser.add_argument("--steps", default=2**20, type=int)
+    parser.add_argument("--time-window", default=100, type=int)
+    args = parser.parse_args()
+    for vect in (False, True):
+        fpath = make_stream(vect, args.steps)
+        wizard = Wizard(
+            encoding="evt3",
+            fpath=fpath,
+            io_mode="mmap",
+            time_window=args.time_window,
+        )
+        nevents = len(wizard.read())
+        density = "high" if vect else "low"
+        print(f"{density} vector density: {nevents} events")
+        value = best_time(wizard.read, args.runs)
+        print_result(f"read ({nevents/value/1e6:.0f} Mev/s)", value)
+
+        def read_windows():
+            wizard.reset()
+            return sum(len(arr) for arr in wizard.read_time_window())
+
+        value = best_time(read_windows, args.runs)
+        print_result(f"read_time_window ({nevents/value/1e6:.0f} Mev/s)", value)
+        fpath_out = fpath.with_suffix(".cut.raw")
+        value = best_time(lambda: wizard.cut(fpath_out, 2**40), args.runs)
+        print_result(f"cut ({nevents/value/1e6:.0f} Mev/s)", value)
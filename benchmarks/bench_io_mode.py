@@ -0,0 +1,50 @@
+"""
+Full and chunked reads with the "fread", "mmap" and "prefetch" I/O modes, on cold and warm page cache.
+"""
+
+import os
+
+from utils import best_time, get_parser, get_recording, print_result
+
+from expelliarmus import Wizard
+
+
+def drop_cache(fpath):
+    # Evicting the file pages from the page cache (Linux only).
+    fd = os.open(fpath, os.O_RDONLY)
+    os.fsync(fd)
+    os.posix_fadvise(fd, 0, 0, os.POSIX_FADV_DONTNEED)
+    os.close(fd)
+
+
+def read_chunks(wizard):
+    wizard.reset()
+    return sum(len(arr) for arr in wizard.read_chunk())
+
+
+if __name__ == "__main__":
+    parser = get_parser(__doc__)
+    parser.add_argument("--chunk-size", default=65536, type=int)
+    args = parser.parse_args()
+    fpath = get_recording(args)
+    print(f"{fpath} ({fpath.stat().st_size/2**20:.1f} MB)")
+    cold = hasattr(os, "posix_fadvise")
+    for label, fn in (("full", Wizard.read), ("chunked", read_chunks)):
+        ref = None
+        for io_mode in ("fread", "mmap", "prefetch"):
+            wizard = Wizard(
+                encoding=args.encoding,
+                fpath=fpath,
+                chunk_size=args.chunk_size,
+                io_mode=io_mode,
+            )
+            fn(wizard)
+            warm = best_time(lambda: fn(wizard), args.runs)
+            print_result(f"{label}, {io_mode}, warm", warm, ref)
+            if cold:
+                times = []
+                for _ in range(args.runs):
+                    drop_cache(fpath)
+                    times.append(best_time(lambda: fn(wizard), 1))
+                print_result(f"{label}, {io_mode}, cold", min(times))
+            ref = warm if ref is None else ref
@@ -0,0 +1,26 @@
+"""
+Full file read with an increasing number of threads.
+"""
+
+import os
+
+from utils import best_time, get_parser, get_recording, print_result
+
+from expelliarmus import Wizard
+
+if __name__ == "__main__":
+    parser = get_parser(__doc__)
+    parser.add_argument("--io-mode", choices=("fread", "mmap"), default="mmap")
+    parser.add_argument("--max-threads", default=os.cpu_count(), type=int)
+    args = parser.parse_args()
+    fpath = get_recording(args)
+    print(f"{fpath} ({fpath.stat().st_size/2**20:.1f} MB)")
+    wizard = Wizard(encoding=args.encoding, fpath=fpath, io_mode=args.io_mode)
+    ref = None
+    nthreads = 1
+    while nthreads <= args.max_threads:
+        wizard.set_nthreads(nthreads)
+        value = best_time(wizard.read, args.runs)
+        print_result(f"{nthreads} threads", value, ref)
+        ref = value if ref is None else ref
+        nthreads *= 2
@@ -0,0 +1,40 @@
+"""
+Full file read: two passes (measure_* + read_*) against the single pass read used by Wizard.read().
+"""
+
+from ctypes import byref
+
+from numpy import empty
+from utils import best_time, get_parser, get_recording, print_result
+
+from expelliarmus import Wizard
+from expelliarmus.utils import _DEFAULT_BUFF_SIZE
+from expelliarmus.wizard.clib import (
+    c_cargos_t,
+    c_measure_fns,
+    c_read_fns,
+    event_t,
+    events_cargo_t,
+)
+from expelliarmus.wizard.wizard_wrapper import c_reader_wrapper
+
+
+def two_pass_read(encoding, fpath, buff_size=_DEFAULT_BUFF_SIZE):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    with c_reader_wrapper(encoding, fpath, buff_size, "fread") as reader:
+        c_measure_fns[encoding](reader, byref(cargo))
+    arr = empty((cargo.events_info.dim,), dtype=event_t)
+    with c_reader_wrapper(encoding, fpath, buff_size, "fread") as reader:
+        c_read_fns[encoding](reader, arr, byref(cargo))
+    return arr
+
+
+if __name__ == "__main__":
+    args = get_parser(__doc__).parse_args()
+    fpath = get_recording(args)
+    wizard = Wizard(encoding=args.encoding, fpath=fpath)
+    nevents = len(wizard.read())
+    print(f"{fpath} ({fpath.stat().st_size/2**20:.1f} MB, {nevents} events)")
+    ref = best_time(lambda: two_pass_read(args.encoding, fpath), args.runs)
+    print_result("two passes", ref)
+    print_result("single pass", best_time(wizard.read, args.runs), ref)
@@ -0,0 +1,62 @@
+"""
+Single thread throughput of each instruction set supported by the CPU: decoding (read), counting (measure_*) and time window boundaries (read_time_window).
+"""
+
+from ctypes import byref
+
+from expelliarmus import Wizard
+from expelliarmus.utils import _SIMD_LEVELS
+from expelliarmus.wizard.clib import (
+    c_cargos_t,
+    c_measure_fns,
+    c_set_simd,
+    events_cargo_t,
+)
+from expelliarmus.wizard.wizard_wrapper import c_reader_wrapper
+
+from utils import best_time, get_parser, get_recording, print_result
+
+
+def measure(encoding, fpath):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    with c_reader_wrapper(encoding, fpath, 4096, "mmap") as reader:
+        c_measure_fns[encoding](reader, byref(cargo))
+    return cargo.events_info.dim
+
+
+def read_windows(wizard):
+    wizard.reset()
+    return sum(len(arr) for arr in wizard.read_time_window())
+
+
+if __name__ == "__main__":
+    parser = get_parser(__doc__)
+    parser.add_argument("--time-window", default=1000, type=int)
+    args = parser.parse_args()
+    fpath = get_recording(args)
+    size = fpath.stat().st_size
+    # Memory mapping the file, so that the measure is not dominated by copies.
+    wizard = Wizard(
+        encoding=args.encoding,
+        fpath=fpath,
+        io_mode="mmap",
+        time_window=args.time_window,
+    )
+    nevents = len(wizard.read())
+    print(f"{fpath} ({size/2**20:.1f} MB, {nevents} events)")
+    best = c_set_simd(max(_SIMD_LEVELS.values()))
+    for label, fn in (
+        ("read", wizard.read),
+        ("measure", lambda: measure(args.encoding, fpath)),
+        ("read_time_window", lambda: read_windows(wizard)),
+    ):
+        ref = None
+        for simd_label, simd in _SIMD_LEVELS.items():
+            if simd > best:
+                continue
+            c_set_simd(simd)
+            value = best_time(fn, args.runs)
+            rate = f"{size/value/2**30:.1f} GB/s"
+            print_result(f"{label} {simd_label} ({rate})", value, ref)
+            ref = value if ref is None else ref
+    c_set_simd(best)
@@ -0,0 +1,75 @@
+import argparse
+import pathlib
+import tempfile
+import timeit
+from typing import Callable
+
+import numpy as np
+
+from expelliarmus import Wizard
+
+SAMPLES_PATH = (
+    pathlib.Path(__file__).resolve().parent.parent.joinpath("tests", "sample-files")
+)
+SAMPLES = dict(
+    dat=("evt2_sample.raw", "evt2"),
+    evt2=("evt2_sample.raw", "evt2"),
+    evt3=("evt3_sample.raw", "evt3"),
+)
+
+
+def get_parser(description: str) -> argparse.ArgumentParser:
+    parser = argparse.ArgumentParser(description=description)
+    parser.add_argument(
+        "--encoding", choices=("dat", "evt2", "evt3"), default="evt3", type=str
+    )
+    parser.add_argument(
+        "--fpath",
+        default=None,
+        type=str,
+        help="recording to be used; a synthetic one is generated if not provided.",
+    )
+    parser.add_argument(
+        "--repeat",
+        default=50,
+        type=int,
+        help="number of times the sample recording is tiled in the synthetic one.",
+    )
+    parser.add_argument("--runs", default=5, type=int)
+    return parser
+
+
+def make_recording(encoding: str, repeat: int) -> pathlib.Path:
+    """
+    Generates a large recording by tiling one of the test samples in time.
+    """
+    fname, sample_encoding = SAMPLES[encoding]
+    arr = Wizard(encoding=sample_encoding).read(SAMPLES_PATH.joinpath(fname))
+    duration = int(arr["t"][-1] - arr["t"][0]) + 1
+    tiles = []
+    for k in range(repeat):
+        tile = arr.copy()
+        tile["t"] += k * duration
+        tiles.append(tile)
+    fpath = pathlib.Path(tempfile.gettempdir()).joinpath(
+        f"expelliarmus_bench_{encoding}.{'dat' if encoding == 'dat' else 'raw'}"
+    )
+    Wizard(encoding=encoding).save(fpath, np.concatenate(tiles))
+    return fpath
+
+
+def get_recording(args: argparse.Namespace) -> pathlib.Path:
+    if args.fpath is not None:
+        return pathlib.Path(args.fpath)
+    return make_recording(args.encoding, args.repeat)
+
+
+def best_time(fn: Callable, runs: int) -> float:
+    return min(timeit.repeat(fn, number=1, repeat=runs))
+
+
+def print_result(label: str, value: float, ref: float = None) -> None:
+    line = f"{label:<32} {value*1e3:10.2f} ms"
+    if ref is not None:
+        line += f"  ({ref/value:.2f}x)"
+    print(line)
@@ -3,85 +3,163 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "threads.h"
+#include "simd.h"
+#include "output.h"
+#include "index.h"
 
 #define LOOP_CONDITION(window, last_t, ovfs, first_t) (window > \
         (((ovfs << 32) | last_t) - first_t))
 
-DLLEXPORT void measure_dat( const char* fpath, 
-                            dat_cargo_t* cargo,
-                            size_t buff_size ){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
-	
+/** Signature of the kernels that skip the events of a time window that cannot
+ *  end it.
+ *
+ *  @param[in]  words       The words to be skipped.
+ *  @param[in]  num_words   The number of words available.
+ *  @param[out] last_t      The lower 32 bits of the last timestamp skipped, 
+ *                          updated in place.
+ *  @param[in]  time_ovfs   The number of overflows of the timestamp.
+ *  @param[in]  end_t       The timestamp that ends the time window.
+ *
+ *  @return     num_words   The number of words skipped. The kernel stops 
+ *                          before the first block of words in which the 
+ *                          timestamp overflows or reaches end_t, and before 
+ *                          the last incomplete block: the remaining words are 
+ *                          left to the caller.
+ */
+typedef size_t (*dat_skip_kernel_t)(const uint64_t*, size_t, uint64_t*, 
+                                    uint64_t, uint64_t);
+
+#ifdef SIMD_X86
+/** AVX2 kernel skipping the events in blocks of 4 words.
+ */
+TARGET_AVX2
+static size_t skip_dat_window_avx2(const uint64_t* words, 
+                                   size_t num_words, 
+                                   uint64_t* last_t, 
+                                   uint64_t time_ovfs, 
+                                   uint64_t end_t){
+	// Largest lower 32 bits of a timestamp before end_t.
+	if (end_t <= (time_ovfs << 32))
+		return 0; 
+	uint64_t max_t = end_t - (time_ovfs << 32) - 1; 
+	if (max_t > 0xFFFFFFFFU)
+		max_t = 0xFFFFFFFFU; 
+	const __m256i mask_32b = _mm256_set1_epi64x(0xFFFFFFFF); 
+	const __m256i end = _mm256_set1_epi64x((int64_t)max_t); 
+	__m256i prev_t = _mm256_set1_epi64x((int64_t)*last_t); 
+	__m256i t, shifted; 
+	size_t i=0; 
+	for (i=0; i + 4 <= num_words; i += 4){
+		t = _mm256_and_si256(
+                _mm256_loadu_si256((const __m256i*)(words + i)), mask_32b); 
+		// Each timestamp is compared with the previous one to detect overflows.
+		shifted = _mm256_blend_epi32(
+                    _mm256_permute4x64_epi64(t, 0x90), prev_t, 0x03); 
+		if (!_mm256_testz_si256(
+                _mm256_or_si256(_mm256_cmpgt_epi64(shifted, t), 
+                                _mm256_cmpgt_epi64(t, end)), 
+                _mm256_set1_epi64x(-1)))
+			break; 
+		prev_t = _mm256_permute4x64_epi64(t, 0xFF); 
+	}
+	if (i > 0)
+		*last_t = words[i-1] & 0xFFFFFFFFU; 
+	return i; 
+}
+#endif
+
+/** Function that selects the kernel used to skip the events of a time window.
+ *
+ *  @return     kernel      The AVX2 kernel if supported, NULL otherwise: the
+ *                          words are then processed by the scalar code.
+ */
+static dat_skip_kernel_t get_dat_skip_kernel(void){
+#ifdef SIMD_X86
+	if (get_simd() >= SIMD_AVX2)
+		return skip_dat_window_avx2; 
+#endif
+	return NULL; 
+}
+
+// Decoder used to count the events passing a filter.
+static int read_dat_staging(reader_t*, event_t*, void*); 
+
+DLLEXPORT void measure_dat(reader_t* reader, dat_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_dat_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 0) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
 		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)),
-                                cargo );
+                                    reader_jump_header(reader)), cargo );
 		// Jumping two bytes.
-		MEAS_CHECK_FSEEK(fseek(fp, 2, SEEK_CUR), cargo); 
 		cargo->events_info.start_byte += 2; 
-	} else {
-		MEAS_CHECK_FSEEK(fseek( fp, 
-                                (long)cargo->events_info.start_byte, SEEK_SET), 
-                                cargo ); 
 	}
 
-	// Buffer to read binary data.
-	uint64_t* buff = (uint64_t*) malloc(buff_size * sizeof(uint64_t));
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
-	
-	size_t dim=0, values_read=0, j=0; 
-	
-	// Reading the file.
-	while ((values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0)
-		dim += values_read; 
-
-	free(buff); 
-	fclose(fp); 
-	cargo->events_info.dim = dim; 
-	if (values_read==0)
-		cargo->events_info.finished = 1;
+	// Each event is encoded in a single word, so the number of events follows
+	// from the file size and the file does not need to be read.
+	const size_t file_size = reader_size(reader); 
+	cargo->events_info.dim = (file_size > cargo->events_info.start_byte) ? 
+        (file_size - cargo->events_info.start_byte) / sizeof(uint64_t) : 0; 
+	cargo->events_info.finished = 1;
 	return;
 }
 
-DLLEXPORT void get_time_window_dat( const char* fpath, 
-                                    dat_cargo_t* cargo, 
-                                    size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
-	
+DLLEXPORT void get_time_window_dat(reader_t* reader, dat_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_dat_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 
+                           (timestamp_t) cargo->events_info.time_window) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
 		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)), 
-                                cargo );
+                                    reader_jump_header(reader)), cargo );
 		// Jumping two bytes.
-		MEAS_CHECK_FSEEK(fseek(fp, 2, SEEK_CUR), cargo); 
 		cargo->events_info.start_byte += 2; 
-	} else {
-		MEAS_CHECK_FSEEK(fseek( fp, 
-                                (long)cargo->events_info.start_byte, SEEK_SET), 
-                                cargo); 
 	}
+	MEAS_CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte), 
+                        cargo); 
 
 	// Buffer to read binary data.
-	uint64_t* buff = (uint64_t*) malloc(buff_size * sizeof(uint64_t));
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
+	const uint64_t* buff; 
 	
 	size_t dim=0, values_read=0, j=0; 
 	uint64_t first_t = 0, last_t = 0, time_ovfs = cargo->time_ovfs; 	
 	uint64_t time_window = (uint64_t) cargo->events_info.time_window, t=0; 
 	uint8_t first_run=1, is_time_window = cargo->events_info.is_time_window; 
 	const uint64_t mask_32b=0xFFFFFFFFU;
+	// Kernel skipping the events and index of the next word from which it is
+	// tried.
+	const dat_skip_kernel_t skip_events = get_dat_skip_kernel(); 
+	size_t next_skip=0; 
 	
 	// Reading the file.
 	while ( LOOP_CONDITION(time_window, last_t, time_ovfs, first_t) && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0 ){
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0 ){
+		next_skip = 0; 
 		for (j=0;
             LOOP_CONDITION(time_window, last_t, time_ovfs, first_t) && 
                 j < values_read; 
             j++){
+			// The events far from the end of the time window are skipped.
+			if (skip_events != NULL && j == next_skip){
+				if (!first_run)
+					j += skip_events(buff + j, values_read - j, &last_t, 
+                                     time_ovfs, first_t + time_window); 
+				next_skip = j + 4; 
+				if (j == values_read)
+					break; 
+			}
 			t = buff[j] & mask_32b; 
 			if (t < last_t)
 				time_ovfs++; 
@@ -91,36 +169,28 @@ DLLEXPORT void get_time_window_dat( const char* fpath,
 				first_run = 0; 
 			}
 		}
+		reader_consume(reader, j*sizeof(*buff)); 
 		dim += j; 
 	}
-	free(buff); 
-	fclose(fp); 
 	cargo->events_info.dim = dim; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return;
 }
 
-DLLEXPORT int read_dat( const char* fpath, 
+DLLEXPORT int read_dat(reader_t* reader, 
                         event_t* arr, 
-                        dat_cargo_t* cargo, 
-                        size_t buff_size ){
-	FILE* fp = fopen(fpath, "rb"); 
-	CHECK_FILE(fp, fpath); 
-
+                        dat_cargo_t* cargo){
 	if (cargo->events_info.start_byte == 0){
-		CHECK_JUMP_HEADER(  (cargo->events_info.start_byte = 
-                                jump_header(fp, NULL, 0U))); 
-		CHECK_FSEEK(fseek(fp, 2, SEEK_CUR));
-		cargo->events_info.start_byte += 2;
-	} else {
-		CHECK_FSEEK(fseek(fp, (long)cargo->events_info.start_byte, SEEK_SET)); 
+		CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
+                                    reader_jump_header(reader)) );
+		// Jumping two bytes.
+		cargo->events_info.start_byte += 2; 
 	}
-	size_t byte_pt = cargo->events_info.start_byte; 
+	CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte)); 
 
 	// Buffer to read binary data.
-	uint64_t* buff = (uint64_t*) malloc(buff_size * sizeof(uint64_t));
-	CHECK_BUFF_ALLOCATION(buff); 
+	const uint64_t* buff; 
 
 	// Indices to keep track of how many items are read from the file.
 	size_t values_read=0, j=0, i=0, dim=cargo->events_info.dim; 
@@ -129,10 +199,12 @@ DLLEXPORT int read_dat( const char* fpath,
 	const uint64_t mask_4b=0xFU, mask_14b=0x3FFFU, mask_32b=0xFFFFFFFFU;
 	uint64_t lower=0, upper=0; 
     uint8_t tsWarning = 0; 
+	const filter_t* filter = cargo->events_info.filter; 
 	
 	// Reading the file.
 	while ( i < dim && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0 ){
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0 ){
 		for (j=0; i < dim && j < values_read; j++){
 			// Event timestamp.
 			lower = buff[j] & mask_32b; 
@@ -151,23 +223,471 @@ DLLEXPORT int read_dat( const char* fpath,
 			// Event y address.
 			arr[i].y = (address_t) ((upper >> 14) & mask_14b); 
 			// Event polarity.
-			arr[i++].p = (polarity_t) ((upper >> 28) & mask_4b); 
+			arr[i].p = (polarity_t) ((upper >> 28) & mask_4b); 
+			// The event is overwritten by the next one if it is filtered out.
+			if (filter == NULL || filter_event(filter, arr + i))
+				i++; 
 		}
-		byte_pt += j*sizeof(*buff); 
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
 
     if (tsWarning)
         fprintf(stderr, "WARNING: The timestamps are not monotonic.\n"); 
-	free(buff); 
-	fclose(fp); 
 
-	cargo->events_info.start_byte = byte_pt; 
+	cargo->events_info.start_byte = reader_tell(reader); 
 	cargo->events_info.dim = i; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return 0; 
 }	
 
+/** Function that adapts read_dat() to the read_fn_t signature used by 
+ *  read_columns().
+ */
+static int read_dat_staging(reader_t* reader, event_t* arr, void* cargo){
+	return read_dat(reader, arr, (dat_cargo_t*) cargo); 
+}
+
+DLLEXPORT int read_dat_columns(reader_t* reader, 
+                               columns_t* columns, 
+                               dat_cargo_t* cargo){
+	return read_columns(reader, columns, read_dat_staging, cargo, 
+                        &cargo->events_info); 
+}
+
+DLLEXPORT int read_dat_frames(reader_t* reader, 
+                               frames_t* frames, 
+                               dat_cargo_t* cargo){
+	return read_frames(reader, frames, read_dat_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_dat_frames_parallel(reader_t* reader, 
+                                       frames_t* frames, 
+                                       dat_cargo_t* cargos, 
+                                       size_t nsegments){
+	return read_frames_parallel(reader, frames, read_dat_staging, cargos, 
+                                sizeof(*cargos), nsegments); 
+}
+
+DLLEXPORT int profile_dat(reader_t* reader, 
+                          uint32_t* counts, 
+                          size_t width, 
+                          size_t height, 
+                          dat_cargo_t* cargo){
+	return count_pixels(reader, counts, width, height, read_dat_staging, 
+                        cargo, &cargo->events_info); 
+}
+
+DLLEXPORT int index_dat(reader_t* reader, 
+                        index_t* index, 
+                        dat_cargo_t* cargo){
+	return build_index(reader, index, read_dat_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_dat_range(reader_t* reader, 
+                             event_t* arr, 
+                             range_t* range, 
+                             dat_cargo_t* cargo){
+	return read_range(reader, arr, range, read_dat_staging, cargo, 
+                      &cargo->events_info); 
+}
+
+/** Function that writes the preamble of a portion of a DAT file: since each
+ *  word is an event, it is empty.
+ */
+static size_t dat_preamble(const void* cargo, void* words){
+	(void) cargo; 
+	(void) words; 
+	return 0; 
+}
+
+DLLEXPORT int cut_dat_span(reader_t* reader, 
+                           const char* fpath_out, 
+                           dat_cargo_t* start, 
+                           dat_cargo_t* end, 
+                           timestamp_t t_start, 
+                           timestamp_t t_end){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	// Jumping two bytes.
+	data_start += 2; 
+	int status = locate_time(reader, read_dat_staging, start, sizeof(*start), 
+                             &start->events_info, t_start); 
+	if (status == 0)
+		status = locate_time(reader, read_dat_staging, end, sizeof(*end), 
+                             &end->events_info, t_end); 
+	if (status != 0)
+		return status; 
+	return write_span(reader, fpath_out, data_start, 
+                      start->events_info.start_byte, end->events_info.start_byte,
+                      dat_preamble, start); 
+}
+
+DLLEXPORT int split_dat(reader_t* reader, 
+                        split_t* split, 
+                        dat_cargo_t* cargo){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	// Jumping two bytes.
+	data_start += 2; 
+	return split_file(reader, split, data_start, read_dat_staging, 
+                      dat_preamble, cargo, sizeof(*cargo), 
+                      &cargo->events_info); 
+}
+
+/** Function that reads the lower 32 bits of the timestamp of the k-th word
+ *  of the file, counted from the data beginning.
+ */
+static int read_dat_raw_t(reader_t* reader, size_t data_start, size_t k, 
+                          uint64_t* raw_t){
+	const uint64_t* buff; 
+	if (reader_seek(reader, data_start + k*sizeof(*buff)) != 0)
+		return -1; 
+	if (reader_fetch(reader, (const void**)&buff, sizeof(*buff)) == 0)
+		return -1; 
+	*raw_t = buff[0] & UINT32_MAX; 
+	return 0; 
+}
+
+/** Structure of a word sampled by seek_time_dat().
+ *
+ *  @field  k       The position of the word, counted from the data beginning.
+ *  @field  raw_t   The lower 32 bits of its timestamp.
+ *  @field  ovfs    The number of timestamp overflows up to the word.
+ */
+typedef struct {
+	size_t k; 
+	uint64_t raw_t; 
+	uint64_t ovfs; 
+} dat_sample_t; 
+
+/** Structure of the growing array of the words sampled by seek_time_dat().
+ *
+ *  @field  arr     The samples, sorted by position.
+ *  @field  num     The number of samples.
+ *  @field  dim     The capacity of arr.
+ */
+typedef struct {
+	dat_sample_t* arr; 
+	size_t num; 
+	size_t dim; 
+} dat_samples_t; 
+
+/** Function that appends a word to the samples. Its timestamp has overflowed
+ *  once with respect to the previous sample if it is smaller than the latter.
+ */
+static int push_dat_sample(dat_samples_t* samples, size_t k, uint64_t raw_t){
+	if (samples->num == samples->dim){
+		const size_t dim = samples->dim > 0 ? 2*samples->dim : 
+                           DAT_SEEK_SAMPLES + 1; 
+		dat_sample_t* arr = (dat_sample_t*) realloc(samples->arr, 
+                                                    dim * sizeof(*arr)); 
+		if (arr == NULL)
+			return -1; 
+		samples->arr = arr; 
+		samples->dim = dim; 
+	}
+	dat_sample_t* sample = samples->arr + samples->num; 
+	sample->k = k; 
+	sample->raw_t = raw_t; 
+	sample->ovfs = 0; 
+	if (samples->num > 0)
+		sample->ovfs = sample[-1].ovfs + (raw_t < sample[-1].raw_t ? 1 : 0); 
+	samples->num++; 
+	return 0; 
+}
+
+/** Function that appends the k-th word to the samples, preceded by the words
+ *  needed for consecutive samples to be either adjacent or less than 
+ *  DAT_SEEK_MAX_SPAN apart: the span from the last sample is split in half 
+ *  until it is short enough, or until it has less than SEEK_LINEAR_WORDS 
+ *  words, that are all sampled.
+ */
+static int sample_dat_words(reader_t* reader, 
+                            size_t data_start, 
+                            dat_samples_t* samples, 
+                            size_t k, 
+                            uint64_t raw_t){
+	const dat_sample_t* last = samples->arr + samples->num - 1; 
+	const size_t first = last->k; 
+	// The span modulo 2^32: any overflow more is missed.
+	const uint64_t span = (raw_t - last->raw_t) & UINT32_MAX; 
+	uint64_t mid_t=0; 
+	size_t j=0; 
+	if (k - first > 1 && span >= DAT_SEEK_MAX_SPAN){
+		if (k - first <= SEEK_LINEAR_WORDS){
+			for (j=first+1; j < k; j++){
+				if (read_dat_raw_t(reader, data_start, j, &mid_t) != 0 || 
+                    push_dat_sample(samples, j, mid_t) != 0)
+					return -1; 
+			}
+		} else {
+			j = first + (k - first)/2; 
+			if (read_dat_raw_t(reader, data_start, j, &mid_t) != 0 || 
+                sample_dat_words(reader, data_start, samples, j, mid_t) != 0)
+				return -1; 
+			return sample_dat_words(reader, data_start, samples, k, raw_t); 
+		}
+	}
+	return push_dat_sample(samples, k, raw_t); 
+}
+
+/** Function that returns the timestamp of a word following a sample, not 
+ *  further than the next one.
+ */
+static timestamp_t get_dat_sample_t(const dat_sample_t* sample, uint64_t raw_t){
+	const uint64_t ovfs = sample->ovfs + (raw_t < sample->raw_t ? 1 : 0); 
+	return (timestamp_t)((ovfs << 32) | raw_t); 
+}
+
+DLLEXPORT int seek_time_dat(reader_t* reader, 
+                            dat_cargo_t* cargo, 
+                            timestamp_t t){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	// Jumping two bytes.
+	data_start += 2; 
+	const size_t file_size = reader_size(reader); 
+	const size_t nwords = (file_size > data_start) ? 
+        (file_size - data_start) / sizeof(uint64_t) : 0; 
+
+	cargo->events_info.start_byte = 0; 
+	cargo->events_info.finished = 0; 
+	cargo->last_t = 0; 
+	cargo->time_ovfs = 0; 
+	if (nwords == 0 || t <= 0)
+		return 0; 
+
+	// Counting the overflows on the samples.
+	dat_samples_t samples = {NULL, 0, 0}; 
+	const size_t nsamples = (nwords - 1 < DAT_SEEK_SAMPLES) ? 
+                            nwords - 1 : DAT_SEEK_SAMPLES; 
+	uint64_t raw_t=0; 
+	size_t s=0, lo=0, hi=0, mid=0; 
+	int status = read_dat_raw_t(reader, data_start, 0, &raw_t); 
+	if (status == 0)
+		status = push_dat_sample(&samples, 0, raw_t); 
+	for (s=1; status == 0 && s <= nsamples; s++){
+		const size_t k = (nwords - 1) / nsamples * s + 
+                         (nwords - 1) % nsamples * s / nsamples; 
+		status = read_dat_raw_t(reader, data_start, k, &raw_t); 
+		if (status == 0)
+			status = sample_dat_words(reader, data_start, &samples, k, raw_t); 
+	}
+	if (status != 0){
+		free(samples.arr); 
+		fprintf(stderr, "ERROR: the DAT file could not be sampled.\n"); 
+		return -1; 
+	}
+
+	// The first sample with timestamp not smaller than t.
+	lo = 0; 
+	hi = samples.num; 
+	while (lo < hi){
+		mid = lo + (hi - lo)/2; 
+		const dat_sample_t* sample = samples.arr + mid; 
+		if ((timestamp_t)((sample->ovfs << 32) | sample->raw_t) < t)
+			lo = mid + 1; 
+		else 
+			hi = mid; 
+	}
+	if (lo == 0){
+		free(samples.arr); 
+		return 0; 
+	}
+	// The bisection of the words following the previous sample, with at most
+	// one overflow in between.
+	const dat_sample_t prev = samples.arr[lo - 1]; 
+	hi = (lo < samples.num) ? samples.arr[lo].k : nwords; 
+	lo = prev.k + 1; 
+	free(samples.arr); 
+	while (lo < hi){
+		mid = lo + (hi - lo)/2; 
+		CHECK_SEEK(read_dat_raw_t(reader, data_start, mid, &raw_t)); 
+		if (get_dat_sample_t(&prev, raw_t) < t)
+			lo = mid + 1; 
+		else 
+			hi = mid; 
+	}
+	// lo is the first word with timestamp not smaller than t.
+	cargo->events_info.start_byte = data_start + lo*sizeof(uint64_t); 
+	if (lo == nwords){
+		cargo->events_info.finished = 1; 
+		return 0; 
+	}
+	CHECK_SEEK(read_dat_raw_t(reader, data_start, lo, &raw_t)); 
+	cargo->last_t = raw_t; 
+	cargo->time_ovfs = (uint64_t)(get_dat_sample_t(&prev, raw_t) >> 32); 
+	return 0; 
+}
+
+/** Structure holding the portion of the file decoded by a thread in
+ *  read_dat_parallel().
+ *
+ *  @field  reader          The reader of the thread, limited to the segment.
+ *  @field  cargo           The decoder state at the segment beginning.
+ *  @field  arr             Where the events of the segment are written.
+ *  @field  dim             The number of events in the segment.
+ *  @field  first_t         The lower 32 bits of the first timestamp in the 
+ *                          segment.
+ *  @field  last_t          The lower 32 bits of the last timestamp in the 
+ *                          segment.
+ *  @field  time_ovfs       The timestamp overflows after the first event of 
+ *                          the segment.
+ *  @field  status          A flag that when different from 0, indicates that 
+ *                          there has been some error in the segment.
+ */
+typedef struct {
+	reader_t* reader; 
+	dat_cargo_t cargo; 
+	event_t* arr; 
+	size_t dim; 
+	uint64_t first_t; 
+	uint64_t last_t; 
+	uint64_t time_ovfs; 
+	int status; 
+} dat_segment_t;
+
+/** Function that counts the timestamp overflows in a segment. Executed by 
+ *  each thread in the first pass of read_dat_parallel().
+ *
+ *  @param[in]  arg     Pointer to the dat_segment_t structure.
+ */
+static void* count_dat_segment(void* arg){
+	dat_segment_t* segment = (dat_segment_t*) arg; 
+	if (reader_seek(segment->reader, 
+                    segment->cargo.events_info.start_byte) != 0){
+		segment->status = -1; 
+		return NULL; 
+	}
+
+	// Buffer to read binary data.
+	const uint64_t* buff; 
+	size_t values_read=0, j=0; 
+	uint64_t t=0, last_t=0, time_ovfs=0; 
+	const uint64_t mask_32b=0xFFFFFFFFU;
+	uint8_t first_run=1; 
+
+	while ((values_read = reader_fetch(segment->reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		if (first_run){
+			segment->first_t = last_t = buff[0] & mask_32b; 
+			first_run = 0; 
+		}
+		for (j=0; j < values_read; j++){
+			t = buff[j] & mask_32b; 
+			if (t < last_t) // Overflow.
+				time_ovfs++; 
+			last_t = t; 
+		}
+		reader_consume(segment->reader, j*sizeof(*buff)); 
+	}
+	segment->last_t = last_t; 
+	segment->time_ovfs = time_ovfs; 
+	return NULL; 
+}
+
+/** Function that decodes a segment to its slice of the output array, starting
+ *  from the overflows count found after the first pass. Executed by each 
+ *  thread in the second pass of read_dat_parallel().
+ *
+ *  @param[in]  arg     Pointer to the dat_segment_t structure.
+ */
+static void* decode_dat_segment(void* arg){
+	dat_segment_t* segment = (dat_segment_t*) arg; 
+	segment->cargo.events_info.dim = segment->dim; 
+	if (segment->dim > 0)
+		segment->status = read_dat(segment->reader, segment->arr, 
+                                    &segment->cargo); 
+	return NULL; 
+}
+
+DLLEXPORT int read_dat_parallel(reader_t* reader, 
+                                event_t* arr, 
+                                dat_cargo_t* cargo, 
+                                size_t nthreads){
+	if (cargo->events_info.start_byte == 0){
+		CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
+                                    reader_jump_header(reader)) );
+		// Jumping two bytes.
+		cargo->events_info.start_byte += 2; 
+	}
+	const size_t word_size = sizeof(uint64_t); 
+	const size_t file_size = reader_size(reader); 
+	const size_t first_byte = cargo->events_info.start_byte; 
+	const size_t num_words = (file_size > first_byte) ? 
+                                (file_size - first_byte) / word_size : 0; 
+
+	// Each word is an event: if the array is too small, there is no need to 
+	// read the file.
+	if (num_words > cargo->events_info.dim){
+		cargo->events_info.dim = num_words; 
+		return 0; 
+	}
+
+	const size_t nsegments = get_num_segments(num_words * word_size, nthreads); 
+	dat_segment_t* segments = (dat_segment_t*) calloc(nsegments, 
+                                                    sizeof(dat_segment_t)); 
+	CHECK_BUFF_ALLOCATION(segments); 
+
+	// Splitting the file in segments made of whole words.
+	size_t k=0, dim=0; 
+	int status=0; 
+	for (k=0; k < nsegments; k++){
+		segments[k].dim = num_words * (k+1) / nsegments - 
+                            num_words * k / nsegments; 
+		segments[k].cargo.events_info.start_byte = first_byte + 
+                                    (num_words * k / nsegments) * word_size; 
+		segments[k].reader = reader_clone(reader); 
+		if (segments[k].reader == NULL)
+			status = -1; 
+		else 
+			reader_set_end(segments[k].reader, first_byte + 
+                            (num_words * (k+1) / nsegments) * word_size); 
+	}
+
+	// First pass: counting the overflows in each segment.
+	if (status == 0)
+		run_threads(count_dat_segment, segments, sizeof(*segments), nsegments); 
+
+	// Exclusive scan of the overflows, so that each segment knows the 
+	// overflows occurred before its first event.
+	uint64_t last_t = cargo->last_t, time_ovfs = cargo->time_ovfs; 
+	for (k=0; status == 0 && k < nsegments; k++){
+		status = segments[k].status; 
+		segments[k].cargo.last_t = last_t; 
+		segments[k].cargo.time_ovfs = time_ovfs; 
+		segments[k].arr = arr + dim; 
+		dim += segments[k].dim; 
+		if (segments[k].dim > 0){
+			if (segments[k].first_t < last_t) // Overflow.
+				time_ovfs++; 
+			time_ovfs += segments[k].time_ovfs; 
+			last_t = segments[k].last_t; 
+		}
+	}
+
+	// Second pass: decoding the segments.
+	if (status == 0){
+		run_threads(decode_dat_segment, segments, sizeof(*segments), nsegments); 
+		for (k=0; k < nsegments; k++)
+			if (segments[k].status != 0)
+				status = segments[k].status; 
+		cargo->last_t = last_t; 
+		cargo->time_ovfs = time_ovfs; 
+		cargo->events_info.start_byte = first_byte + num_words * word_size; 
+		cargo->events_info.finished = 1; 
+	}
+	cargo->events_info.dim = dim; 
+
+	for (k=0; k < nsegments; k++)
+		close_reader(segments[k].reader); 
+	free(segments); 
+	return status; 
+}
+
 DLLEXPORT int save_dat( const char* fpath, 
                         event_t* arr, 
                         dat_cargo_t* cargo, 
@@ -5,12 +5,26 @@
 
 #include "events.h"
 #include "wizard.h"
+#include "reader.h"
+#include "output.h"
+#include "index.h"
+#include "filter.h"
+#include "frame.h"
 
 // DAT format constants.
 #define DAT_EVENT_2D 0x0U
 #define DAT_EVENT_CD 0x0C
 #define DAT_EVENT_EXT_TRIGGER 0x0E
 
+// Number of words sampled at evenly spaced positions by seek_time_dat() to 
+// count the timestamp overflows of the recording.
+#define DAT_SEEK_SAMPLES 1024U
+// Largest timestamp span [us] between two consecutive samples of 
+// seek_time_dat(): wider spans might hide an overflow, so the words between 
+// the samples are sampled again, down to SEEK_LINEAR_WORDS words, that are 
+// read one by one.
+#define DAT_SEEK_MAX_SPAN (1ULL<<30)
+
 /** Wrap structure for the cargo information about the events tuned for the 
  *  DAT encoding format.
  *      
@@ -31,13 +45,15 @@ typedef struct {
  *  type event_t, so that the file is re-opened successively to fill the 
  *  externally allocated array. 
  *  The size of the external array to be allocated is written to 
- *  cargo->events_info.dim.
+ *  cargo->events_info.dim. Since every event takes 8 bytes, it is computed 
+ *  from the file size, without reading the file, unless a filter is set in 
+ *  cargo->events_info.filter: in that case, only the events that pass it are 
+ *  counted, decoding the file.
  *
- *  @param[in]  fpath       The path to the input file.
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] cargo       The pointer to the information cargo structure.
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
  */
-DLLEXPORT void measure_dat(const char*, dat_cargo_t*, size_t); 
+DLLEXPORT void measure_dat(reader_t*, dat_cargo_t*); 
 
 /** Function that counts the number of events to be read in the time window 
  *  duration specified.
@@ -45,30 +61,210 @@ DLLEXPORT void measure_dat(const char*, dat_cargo_t*, size_t);
  *  type event_t, filled in a successive file reading. The file is read starting
  *  from the byte number stored in cargo->events_info.start_byte.
  *  The time window duration is read from cargo->events_info.time_window. 
- *  The size of the array to be allocated is saved to cargo->events_info.dim.
+ *  The size of the array to be allocated is saved to cargo->events_info.dim;
+ *  if a filter is set in cargo->events_info.filter, only the events that pass
+ *  it are counted.
  *
- *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] cargo       The pointer to the information cargo structure. 
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
  */
-DLLEXPORT void get_time_window_dat(const char*, dat_cargo_t*, size_t); 
+DLLEXPORT void get_time_window_dat(reader_t*, dat_cargo_t*); 
 
 /** Function that fills the array provided with the events from the binary file.
  *  arr is supposed to be an array of size cargo->events_info.dim and type
  *  event_t.
  *  When the entire file has been read, cargo->events_info.finished is set to 1.
  *
- *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] arr         The event array, passed as a pointer to event_t 
+ *                          structures. Allocated externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while filling the input 
+ *                          array or reading the file.
+ */
+DLLEXPORT int read_dat(reader_t*, event_t*, dat_cargo_t*); 
+
+/** Function that fills the columns provided with the events from the binary 
+ *  file in the layout set in columns->layout (LAYOUT_SOA, LAYOUT_COMPACT or 
+ *  LAYOUT_PACKED, see "output.h"). The events are decoded by read_dat() to a
+ *  staging array and then narrowed to the columns.
+ *  The columns are supposed to have size cargo->events_info.dim.
+ *  When the entire file has been read, cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] columns     The pointer to the output arrays. Allocated 
+ *                          externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while filling the 
+ *                          columns or reading the file.
+ */
+DLLEXPORT int read_dat_columns(reader_t*, columns_t*, dat_cargo_t*);
+
+/** Function that fills the frames provided with the events from the binary 
+ *  file (see "frame.h"). The events are decoded by read_dat() to a staging 
+ *  array and scattered to the frames, without being stored.
+ *  When the entire file has been read, cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure. The frames 
+ *                          are allocated externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_dat_frames(reader_t*, frames_t*, dat_cargo_t*);
+
+/** Function that fills the frames provided as read_dat_frames(), splitting
+ *  them among nsegments threads (see read_frames_parallel() in "frame.h").
+ *  The k-th run of frames is decoded from cargos[k], that must precede its 
+ *  first event; on return, cargos[0] holds the state following the frames.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure. The frames 
+ *                          are allocated externally.
+ *  @param[in]  cargos      The array of information cargo structures.
+ *  @param[in]  nsegments   The number of runs of frames, one for each thread.
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_dat_frames_parallel(reader_t*, frames_t*, 
+                                       dat_cargo_t*, size_t);
+
+/** Function that counts the events of each pixel of the binary file, from 
+ *  the state stored in cargo to the file end, ignoring the filter (see 
+ *  count_pixels() in "filter.h"). Used to find the hot pixels of the sensor.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] counts      The counts of the pixels, of size width*height. 
+ *                          Allocated externally.
+ *  @param[in]  width       The width of counts.
+ *  @param[in]  height      The height of counts.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int profile_dat(reader_t*, uint32_t*, size_t, size_t, 
+                          dat_cargo_t*);
+
+/** Function that adds to the index provided the resume points of the binary 
+ *  file, from the state stored in cargo; see build_index() in "index.h".
+ *  Each entry is followed by a copy of the cargo at that point, that can be 
+ *  passed to read_dat() to decode the file from there.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] index       The pointer to the index being built.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int index_dat(reader_t*, index_t*, dat_cargo_t*);
+
+/** Function that fills the array provided with the events of a range, from 
+ *  the state stored in cargo (e.g. an index entry); see read_range() in 
+ *  "index.h". The events outside of the range are dropped while decoding.
+ *  arr is supposed to have size cargo->events_info.dim plus STAGING_SLACK; 
+ *  the number of events written is saved to cargo->events_info.dim.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] arr         The event array, passed as a pointer to event_t 
+ *                          structures. Allocated externally.
+ *  @param[in]  range       The pointer to the range structure.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_dat_range(reader_t*, event_t*, range_t*, dat_cargo_t*);
+
+/** Function that writes the events with a timestamp in [t_start, t_end) to 
+ *  a new file, without decoding most of them: the cargos are moved to the 
+ *  first event of the span and past its last one by locate_time(), and the 
+ *  bytes in between are copied after the header (see write_span()). No 
+ *  preamble is needed, since each word is an event; the timestamp overflows
+ *  are not encoded in the words, so the timestamps of a span following one 
+ *  are decoded modulo 2^32.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[in]  fpath_out   Path to the output file.
+ *  @param[in]  start       The cargo preceding the first event of the span
+ *                          (e.g. from seek_time_dat() or an index entry). 
+ *  @param[in]  end         The cargo preceding the first event after the 
+ *                          span.
+ *  @param[in]  t_start     The first timestamp of the span [us].
+ *  @param[in]  t_end       The timestamp ending the span, excluded [us].
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while cutting the file.
+ */
+DLLEXPORT int cut_dat_span(reader_t*, const char*, dat_cargo_t*, 
+                           dat_cargo_t*, timestamp_t, timestamp_t);
+
+/** Function that splits the binary file in clips of split->duration 
+ *  microseconds in a single pass, writing each one to a file of 
+ *  split->fpaths that can be decoded on its own (see split_file()). The timestamp
+ *  overflows are not encoded in the words, so the timestamps of the clips 
+ *  following one are decoded modulo 2^32.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] split       The state of the split.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while splitting the file.
+ */
+DLLEXPORT int split_dat(reader_t*, split_t*, dat_cargo_t*);
+
+/** Function that moves the cargo to the first event with timestamp t or 
+ *  larger, without decoding the file: since every event takes 8 bytes, a 
+ *  binary search over the events reads O(log(number of events)) words. 
+ *  The words hold the lower 32 bits of the timestamps, so the overflows are
+ *  counted first on DAT_SEEK_SAMPLES evenly spaced words: a timestamp 
+ *  smaller than the one of the previous sample has overflowed once, which
+ *  holds as long as the samples are less than DAT_SEEK_MAX_SPAN apart, and
+ *  the wider spans are sampled again down to adjacent words, where the 
+ *  overflows are counted as read_dat() does. The bisection then runs 
+ *  between the two samples enclosing t. 
+ *  The cargo can then be passed to read_dat() or read_dat_range().
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] cargo       The pointer to the information cargo structure. 
+ *  @param[in]  t           The timestamp to be reached [us].
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int seek_time_dat(reader_t*, dat_cargo_t*, timestamp_t);
+
+/** Function that fills the array provided with all the events in the binary 
+ *  file, splitting the file among many threads. Each thread counts the 
+ *  timestamp overflows in its segment; an exclusive scan of these counts gives
+ *  the overflows before each segment, which is then decoded in parallel to its
+ *  slice of the array.
+ *  arr is supposed to be an array of size cargo->events_info.dim; if it is too
+ *  small, nothing is decoded and the number of events needed is written to
+ *  cargo->events_info.dim, with cargo->events_info.finished left to 0. 
+ *  Otherwise, the number of events read is written to cargo->events_info.dim
+ *  and cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] arr         The event array, passed as a pointer to event_t 
  *                          structures. Allocated externally.
  *  @param[in]  cargo       The pointer to the information cargo structure. 
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
+ *  @param[in]  nthreads    The number of threads used.
  *
  *  @return     status      A flag that when different from 0, indicates that 
  *                          there has been some error while filling the input 
  *                          array or reading the file.
  */
-DLLEXPORT int read_dat(const char*, event_t*, dat_cargo_t*, size_t); 
+DLLEXPORT int read_dat_parallel(reader_t*, event_t*, dat_cargo_t*, size_t);
 
 /** Function that writes to a binary file the array provided in input using 
  *  DAT encoding.
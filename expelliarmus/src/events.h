@@ -27,6 +27,32 @@ typedef struct event_s {
 	polarity_t p; 
 } event_t; 
 
+/** Structure of an external trigger event.
+ *
+ *  @field  t       Timestamp.
+ *  @field  id      Channel of the trigger.
+ *  @field  value   Edge of the trigger: 1 for rising, 0 for falling.
+ */
+typedef struct trigger_s {
+	timestamp_t t; 
+	uint8_t id; 
+	uint8_t value; 
+} trigger_t; 
+
+/** Structure of the array the external trigger events are collected to, 
+ *  while the events are decoded. The decoders stop when it is full, so that
+ *  it can be emptied or grown before they are called again.
+ *
+ *  @field  arr     The trigger events. Allocated externally.
+ *  @field  dim     The size of arr.
+ *  @field  num     The number of trigger events in arr.
+ */
+typedef struct triggers_s {
+	trigger_t* arr; 
+	size_t dim; 
+	size_t num; 
+} triggers_t; 
+
 /** Structure that holds additional information about the event stream.
  *
  *  @field  dim             The number of events in the recording.
@@ -41,6 +67,10 @@ typedef struct event_s {
  *                          be used with fseek() to reopen the file from the 
  *                          point where it was left off.
  *  @field  finished        Flag to indicate that the entire file has been read.
+ *  @field  filter          The filter of the events decoded; NULL to keep all
+ *                          of them. See "filter.h".
+ *  @field  triggers        The array the external trigger events are 
+ *                          collected to; NULL to drop them.
  */
 typedef struct {
 	size_t dim;
@@ -49,6 +79,8 @@ typedef struct {
 	uint8_t is_time_window; 
 	size_t start_byte;
 	uint8_t finished; 
+	const struct filter_s* filter; 
+	triggers_t* triggers; 
 } event_cargo_t; 
 
 // Macro to check that the event stream is monotonic in the timestamps.
@@ -58,4 +90,10 @@ inline int check_timestamps(timestamp_t t, timestamp_t prev_t) {
     return 0; 
 }
 
+// Function to check that there is room for a trigger event, if they are 
+// collected.
+static inline int has_trigger_room(const triggers_t* triggers){
+	return triggers == NULL || triggers->num < triggers->dim; 
+}
+
 #endif
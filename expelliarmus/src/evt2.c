@@ -3,36 +3,121 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "threads.h"
+#include "simd.h"
+#include "output.h"
+#include "index.h"
+
+// Bit masks of the event types that stop the counting kernels: the types not
+// recognised, that have to be reported by the scalar code, and the TIME_HIGH
+// words, that change the timestamp of the following events.
+#define EVT2_UNKNOWN_TYPES (0xFFFFU & ~((1U<<EVT2_CD_OFF) | (1U<<EVT2_CD_ON) |\
+            (1U<<EVT2_TIME_HIGH) | (1U<<EVT2_EXT_TRIGGER) | (1U<<EVT2_OTHERS) |\
+            (1U<<EVT2_CONTINUED)))
+#define EVT2_TIME_TYPES (1U<<EVT2_TIME_HIGH)
+
+/** Signature of the kernels that count the CD words in a stream.
+ *
+ *  @param[in]  words       The words to be counted.
+ *  @param[in]  num_words   The number of words available.
+ *  @param[in]  stop_types  Bit mask of the event types that stop the kernel.
+ *  @param[out] dim         The number of CD words, incremented in place.
+ *
+ *  @return     num_words   The number of words counted. The kernel stops 
+ *                          before the first block of words containing one of 
+ *                          the stop types, and before the last incomplete 
+ *                          block: the remaining words are left to the caller.
+ */
+typedef size_t (*evt2_count_kernel_t)(const uint32_t*, size_t, uint32_t, 
+                                      size_t*);
+
+#ifdef SIMD_X86
+/** AVX2 kernel counting the CD words in blocks of 8 words.
+ */
+TARGET_AVX2
+static size_t count_evt2_cd_avx2(const uint32_t* words, 
+                                 size_t num_words, 
+                                 uint32_t stop_types, 
+                                 size_t* dim){
+	const __m256i one = _mm256_set1_epi32(1); 
+	const __m256i stop = _mm256_set1_epi32((int)stop_types); 
+	const __m256i zero = _mm256_setzero_si256(); 
+	__m256i block, count; 
+	size_t i=0, k=0; 
+	uint8_t stopped=0; 
+	while (!stopped && i + 8 <= num_words){
+		// The lanes are summed every 2^24 blocks, before they can overflow.
+		count = zero; 
+		for (k=0; k < (1U<<24) && i + 8 <= num_words; k++, i += 8){
+			block = _mm256_loadu_si256((const __m256i*)(words + i)); 
+			if (!_mm256_testz_si256(
+                    _mm256_sllv_epi32(one, _mm256_srli_epi32(block, 28)), 
+                    stop)){
+				stopped = 1; 
+				break; 
+			}
+			// CD_OFF (0x0) and CD_ON (0x1) words have the 3 MSBs cleared.
+			count = _mm256_sub_epi32(count, _mm256_cmpeq_epi32(
+                                        _mm256_srli_epi32(block, 29), zero)); 
+		}
+		*dim += sum_epu32_avx2(count); 
+	}
+	return i; 
+}
+#endif
+
+/** Function that selects the kernel used to count the CD words.
+ *
+ *  @return     kernel      The AVX2 kernel if supported, NULL otherwise: the
+ *                          words are then counted by the scalar code.
+ */
+static evt2_count_kernel_t get_evt2_count_kernel(void){
+#ifdef SIMD_X86
+	if (get_simd() >= SIMD_AVX2)
+		return count_evt2_cd_avx2; 
+#endif
+	return NULL; 
+}
 
-DLLEXPORT void measure_evt2(const char* fpath, 
-                            evt2_cargo_t* cargo, 
-                            size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
+// Decoder used to count the events passing a filter.
+static int read_evt2_staging(reader_t*, event_t*, void*); 
 
+DLLEXPORT void measure_evt2(reader_t* reader, evt2_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_evt2_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 0) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
 		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)), 
+                                    reader_jump_header(reader)), 
                                 cargo ); 	
 	} else {
-		MEAS_CHECK_FSEEK(fseek( fp, 
-                                (long)cargo->events_info.start_byte, SEEK_SET), 
-                                cargo ); 
+		MEAS_CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte), 
+                        cargo); 
 	}
 
 	// Buffer to read the file.
-	uint32_t* buff = (uint32_t*) malloc(buff_size * sizeof(uint32_t)); 
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
+	const uint32_t* buff; 
 
 	// The byte that identifies the event type.
 	uint8_t event_type; 
 	// Indices to access the input file.
 	size_t j=0, values_read=0, dim=0; 
+	// Kernel counting the CD words.
+	const evt2_count_kernel_t count_cd = get_evt2_count_kernel(); 
 
 	// Reading the file.
-	while ((values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0){
-		for (j=0; j < values_read; j++){
+	while ((values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		// The vectorized kernel counts as many words as possible; the rest, 
+		// including the words of unknown type, goes through the switch.
+		j = (count_cd != NULL) ? 
+                count_cd(buff, values_read, EVT2_UNKNOWN_TYPES, &dim) : 0; 
+		for (; j < values_read; j++){
 			// Getting the event type. 
 			event_type = (uint8_t) (buff[j] >> 28); 
 			switch (event_type){
@@ -51,35 +136,35 @@ DLLEXPORT void measure_evt2(const char* fpath,
 					MEAS_EVENT_TYPE_NOT_RECOGNISED(event_type, cargo); 
 			}
 		}
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
-	fclose(fp); 
-	free(buff); 
 	cargo->events_info.dim = dim; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return; 
 }
 
-DLLEXPORT void get_time_window_evt2(const char* fpath, 
-                                    evt2_cargo_t* cargo, 
-                                    size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
-
+DLLEXPORT void get_time_window_evt2(reader_t* reader, evt2_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_evt2_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 
+                           (timestamp_t) cargo->events_info.time_window) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
 		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)), 
+                                    reader_jump_header(reader)), 
                                 cargo); 	
 	} else {
-		MEAS_CHECK_FSEEK(fseek( fp, 
-                                (long)cargo->events_info.start_byte, SEEK_SET), 
-                                cargo ); 
+		MEAS_CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte), 
+                        cargo); 
 	}
 
 	// Buffer to read the file.
-	uint32_t* buff = (uint32_t*) malloc(buff_size * sizeof(uint32_t)); 
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
+	const uint32_t* buff; 
 
 	// The byte that identifies the event type.
 	uint8_t event_type; 
@@ -91,11 +176,28 @@ DLLEXPORT void get_time_window_evt2(const char* fpath,
    	uint64_t time_high = cargo->time_high; 	
 	const uint32_t mask_6b=0x3FU, mask_28b=0xFFFFFFFU; 
 	uint8_t first_run=1, loop_condition_flag=1; 
+	// Kernel counting the CD words and index of the next word from which it
+	// is tried.
+	const evt2_count_kernel_t count_cd = get_evt2_count_kernel(); 
+	size_t next_count=0; 
 
 	// Reading the file.
 	while ( loop_condition_flag && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0 ){
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0 ){
+		next_count = 0; 
 		for (j=0; loop_condition_flag && j < values_read; j++){
+			// While no CD event can end the time window, the words are just 
+			// counted, up to the next TIME_HIGH word.
+			if (count_cd != NULL && j == next_count){
+				if (!first_run && 
+                        ((time_high << 6) | mask_6b) < first_t + time_window)
+					j += count_cd(buff + j, values_read - j, 
+                                  EVT2_UNKNOWN_TYPES | EVT2_TIME_TYPES, &dim); 
+				next_count = j + 8; 
+				if (j == values_read)
+					break; 
+			}
 			// Getting the event type. 
 			event_type = (uint8_t) (buff[j] >> 28); 
 			switch (event_type){
@@ -124,68 +226,182 @@ DLLEXPORT void get_time_window_evt2(const char* fpath,
 					MEAS_EVENT_TYPE_NOT_RECOGNISED(event_type, cargo); 
 			}
 		}
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
-	fclose(fp); 
-	free(buff); 
 	cargo->events_info.dim = dim; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return; 
 }
 
-DLLEXPORT int read_evt2(const char* fpath, 
-                        event_t* arr, 
-                        evt2_cargo_t* cargo, 
-                        size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	CHECK_FILE(fp, fpath); 
+/** Signature of the kernels that decode a run of CD words.
+ *
+ *  @param[in]  words       The words to be decoded.
+ *  @param[in]  num_words   The maximum number of words decoded.
+ *  @param[out] arr         Where the events are written.
+ *  @param[in]  time_high   The upper 28 bits of the timestamp.
+ *  @param[out] last_t      The last timestamp decoded, updated in place.
+ *  @param[out] ts_warning  Set to 1 if the timestamps are not monotonic.
+ *
+ *  @return     num_events  The number of CD words decoded, i.e. the length of
+ *                          the run, at most num_words.
+ */
+typedef size_t (*evt2_cd_kernel_t)(const uint32_t*, size_t, event_t*, uint64_t,
+                                   timestamp_t*, uint8_t*);
+
+static size_t decode_evt2_cd_scalar(const uint32_t* words, 
+                                    size_t num_words, 
+                                    event_t* arr, 
+                                    uint64_t time_high, 
+                                    timestamp_t* last_t, 
+                                    uint8_t* ts_warning){
+	// Masks to extract bits.
+	const uint32_t mask_6b=0x3FU, mask_11b=0x7FFU;
+	timestamp_t timestamp=0; 
+	uint8_t event_type; 
+	size_t i=0; 
+	for (i=0; i < num_words; i++){
+		event_type = (uint8_t) (words[i] >> 28); 
+		if (event_type != EVT2_CD_ON && event_type != EVT2_CD_OFF)
+			break; 
+		// Getting 6LSBs of the time stamp. 
+		timestamp = (timestamp_t)((time_high << 6) | 
+                                    ((words[i] >> 22) & mask_6b)); 
+		if (!*ts_warning)
+			*ts_warning = check_timestamps(timestamp, *last_t);
+		arr[i].t = timestamp; 
+		*last_t = timestamp; 
+		// Getting event addresses.
+		arr[i].x = (address_t) ((words[i] >> 11) & mask_11b); 
+		arr[i].y = (address_t) (words[i] & mask_11b); 
+		// Getting event polarity.
+		arr[i].p = (polarity_t) event_type; 
+	}
+	return i; 
+}
+
+#ifdef SIMD_X86
+/** AVX2 kernel decoding 8 CD words at a time. Each word is widened to 64 bits
+ *  and split into the timestamp and a second lane holding x, y and p, so that
+ *  two 256 bits stores write four event_t structures. The words after the 
+ *  last block of 8 CD words are left to the scalar kernel.
+ */
+TARGET_AVX2
+static size_t decode_evt2_cd_avx2(const uint32_t* words, 
+                                  size_t num_words, 
+                                  event_t* arr, 
+                                  uint64_t time_high, 
+                                  timestamp_t* last_t, 
+                                  uint8_t* ts_warning){
+	const __m256i mask_6b = _mm256_set1_epi64x(0x3F); 
+	const __m256i mask_11b = _mm256_set1_epi64x(0x7FF); 
+	const __m256i t_high = _mm256_set1_epi64x((int64_t)(time_high << 6)); 
+	__m256i prev_t = _mm256_set1_epi64x((int64_t)*last_t); 
+	__m256i not_monotonic = _mm256_setzero_si256(); 
+	__m256i block, w, t, xyp, lo, hi, shifted; 
+	size_t i=0, h=0; 
+	for (i=0; i + 8 <= num_words; i += 8){
+		block = _mm256_loadu_si256((const __m256i*)(words + i)); 
+		// All the words have to be CD_OFF (0x0) or CD_ON (0x1).
+		w = _mm256_srli_epi32(block, 29); 
+		if (!_mm256_testz_si256(w, w))
+			break; 
+		for (h=0; h < 8; h += 4){
+			// Widening 4 words to 64 bits lanes.
+			w = _mm256_cvtepu32_epi64(h ? _mm256_extracti128_si256(block, 1) : 
+                                          _mm256_castsi256_si128(block)); 
+			t = _mm256_or_si256(t_high, 
+                    _mm256_and_si256(_mm256_srli_epi64(w, 22), mask_6b)); 
+			xyp = _mm256_or_si256(
+                    _mm256_and_si256(_mm256_srli_epi64(w, 11), mask_11b), 
+                    _mm256_or_si256(
+                        _mm256_slli_epi64(_mm256_and_si256(w, mask_11b), 16), 
+                        _mm256_slli_epi64(_mm256_srli_epi64(w, 28), 32))); 
+			// Checking the timestamps against the previous ones.
+			shifted = _mm256_blend_epi32(
+                        _mm256_permute4x64_epi64(t, 0x90), prev_t, 0x03); 
+			not_monotonic = _mm256_or_si256(not_monotonic, 
+                                _mm256_cmpgt_epi64(shifted, t)); 
+			prev_t = _mm256_permute4x64_epi64(t, 0xFF); 
+			// Interleaving the timestamps and the addresses.
+			lo = _mm256_unpacklo_epi64(t, xyp); 
+			hi = _mm256_unpackhi_epi64(t, xyp); 
+			_mm256_storeu_si256((__m256i*)(arr + i + h), 
+                                _mm256_permute2x128_si256(lo, hi, 0x20)); 
+			_mm256_storeu_si256((__m256i*)(arr + i + h + 2), 
+                                _mm256_permute2x128_si256(lo, hi, 0x31)); 
+		}
+	}
+	if (i > 0){
+		*last_t = arr[i-1].t; 
+		if (!_mm256_testz_si256(not_monotonic, not_monotonic))
+			*ts_warning = 1; 
+	}
+	return i + decode_evt2_cd_scalar(words + i, num_words - i, arr + i, 
+                                     time_high, last_t, ts_warning); 
+}
+#endif
+
+/** Function that selects the kernel used to decode CD words.
+ *
+ *  @return     kernel      The AVX2 kernel if supported, the scalar one 
+ *                          otherwise.
+ */
+static evt2_cd_kernel_t get_evt2_cd_kernel(void){
+#ifdef SIMD_X86
+	if (get_simd() >= SIMD_AVX2)
+		return decode_evt2_cd_avx2; 
+#endif
+	return decode_evt2_cd_scalar; 
+}
 
+DLLEXPORT int read_evt2(reader_t* reader, 
+                        event_t* arr, 
+                        evt2_cargo_t* cargo){
 	if (cargo->events_info.start_byte == 0){
 		CHECK_JUMP_HEADER(  (cargo->events_info.start_byte = 
-                            jump_header(fp, NULL, 0U)) ); 
+                            reader_jump_header(reader)) ); 
 	} else {
-		CHECK_FSEEK(fseek(fp, (long)cargo->events_info.start_byte, SEEK_SET)); 
+		CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte)); 
 	}
-	size_t byte_pt = cargo->events_info.start_byte; 
 
 	// Buffer to read the file.
-	uint32_t* buff = (uint32_t*) malloc(buff_size * sizeof(uint32_t)); 
-	CHECK_BUFF_ALLOCATION(buff); 
+	const uint32_t* buff; 
 
 	// The byte that identifies the event type.
 	uint8_t event_type; 
 	// Indices to access the input file.
-	size_t i=0, j=0, values_read=0, dim=cargo->events_info.dim; 
+	size_t i=0, j=0, values_read=0, dim=cargo->events_info.dim, num_events=0; 
 	// Masks to extract bits.
-	const uint32_t mask_6b=0x3FU, mask_11b=0x7FFU, mask_28b=0xFFFFFFFU;
-	// Values to handle overflows.
-	uint64_t time_low=0;
-	timestamp_t timestamp=0; 
+	const uint32_t mask_28b=0xFFFFFFFU;
+	// Kernel decoding the CD words.
+	const evt2_cd_kernel_t decode_cd = get_evt2_cd_kernel(); 
     uint8_t tsWarning = 0; 
+	const filter_t* filter = cargo->events_info.filter; 
+	// Array of the trigger events, if they are collected.
+	triggers_t* triggers = cargo->events_info.triggers; 
+	const uint32_t mask_6b=0x3FU, mask_5b=0x1FU; 
 
 	// Reading the file.
-	while ( i < dim && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0){
-		for (j=0; i < dim && j < values_read; j++){
+	while ( i < dim && has_trigger_room(triggers) && 
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		for (j=0; i < dim && has_trigger_room(triggers) && j < values_read; 
+                j++){
 			// Getting the event type. 
 			event_type = (uint8_t) (buff[j] >> 28); 
 			switch (event_type){
 				case EVT2_CD_ON:
 				case EVT2_CD_OFF:
-					// Getting 6LSBs of the time stamp. 
-					time_low = ((uint64_t)((buff[j] >> 22) & mask_6b)); 
-					timestamp = (timestamp_t)(
-                                (cargo->time_high << 6) | time_low
-                                );
-                    if (!tsWarning)
-					    tsWarning = check_timestamps(timestamp, cargo->last_t);
-					arr[i].t = timestamp; 
-					cargo->last_t = timestamp; 
-					// Getting event addresses.
-					arr[i].x = (address_t) ((buff[j] >> 11) & mask_11b); 
-					arr[i].y = (address_t) (buff[j] & mask_11b); 
-					// Getting event polarity.
-					arr[i++].p = (polarity_t) event_type; 
+					// Decoding the whole run of CD words starting here.
+					num_events = decode_cd(buff + j, (values_read - j < dim - i) ? 
+                                            values_read - j : dim - i, 
+                                           arr + i, cargo->time_high, 
+                                           &cargo->last_t, &tsWarning); 
+					j += num_events - 1; 
+					// The events filtered out are overwritten by the next ones.
+					i += (filter == NULL) ? num_events : 
+                            filter_events(filter, arr + i, num_events); 
 					break; 
 
 				case EVT2_TIME_HIGH:
@@ -194,6 +410,17 @@ DLLEXPORT int read_evt2(const char* fpath,
 					break; 
 
 				case EVT2_EXT_TRIGGER:
+					if (triggers != NULL){
+						triggers->arr[triggers->num].t = (timestamp_t)(
+                            (cargo->time_high << 6) | 
+                            ((buff[j] >> 22) & mask_6b)); 
+						triggers->arr[triggers->num].id = 
+                            (uint8_t) ((buff[j] >> 8) & mask_5b); 
+						triggers->arr[triggers->num++].value = 
+                            (uint8_t) (buff[j] & 0x1U); 
+					}
+					break; 
+
 				case EVT2_OTHERS:
 				case EVT2_CONTINUED:
 					break; 
@@ -202,20 +429,370 @@ DLLEXPORT int read_evt2(const char* fpath,
 					EVENT_TYPE_NOT_RECOGNISED(event_type); 
 			}
 		}
-		byte_pt += j*sizeof(*buff); 
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
     if (tsWarning)
         fprintf(stderr, "WARNING: The timestamps are not monotonic.\n"); 
-	fclose(fp); 
-	free(buff); 
 
-	cargo->events_info.start_byte = byte_pt; 
+	cargo->events_info.start_byte = reader_tell(reader); 
 	cargo->events_info.dim = i; 
 	if (values_read==0)
 		cargo->events_info.finished = 1; 
 	return 0; 
 }
 
+/** Function that adapts read_evt2() to the read_fn_t signature used by 
+ *  read_columns().
+ */
+static int read_evt2_staging(reader_t* reader, event_t* arr, void* cargo){
+	return read_evt2(reader, arr, (evt2_cargo_t*) cargo); 
+}
+
+DLLEXPORT int read_evt2_columns(reader_t* reader, 
+                                columns_t* columns, 
+                                evt2_cargo_t* cargo){
+	return read_columns(reader, columns, read_evt2_staging, cargo, 
+                        &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt2_frames(reader_t* reader, 
+                               frames_t* frames, 
+                               evt2_cargo_t* cargo){
+	return read_frames(reader, frames, read_evt2_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt2_frames_parallel(reader_t* reader, 
+                                        frames_t* frames, 
+                                        evt2_cargo_t* cargos, 
+                                        size_t nsegments){
+	return read_frames_parallel(reader, frames, read_evt2_staging, cargos, 
+                                sizeof(*cargos), nsegments); 
+}
+
+DLLEXPORT int profile_evt2(reader_t* reader, 
+                           uint32_t* counts, 
+                           size_t width, 
+                           size_t height, 
+                           evt2_cargo_t* cargo){
+	return count_pixels(reader, counts, width, height, read_evt2_staging, 
+                        cargo, &cargo->events_info); 
+}
+
+DLLEXPORT int index_evt2(reader_t* reader, 
+                         index_t* index, 
+                         evt2_cargo_t* cargo){
+	return build_index(reader, index, read_evt2_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt2_range(reader_t* reader, 
+                              event_t* arr, 
+                              range_t* range, 
+                              evt2_cargo_t* cargo){
+	return read_range(reader, arr, range, read_evt2_staging, cargo, 
+                      &cargo->events_info); 
+}
+
+/** Function that writes the preamble of a portion of an EVT2 file: a 
+ *  TIME_HIGH word restoring the upper bits of the timestamp. If its first 
+ *  byte is HEADER_START, the word would be taken for a header line: an 
+ *  EVT2_OTHERS word, that is skipped by the decoder, is put before it.
+ */
+static size_t evt2_preamble(const void* cargo, void* words){
+	const evt2_cargo_t* state = (const evt2_cargo_t*) cargo; 
+	uint32_t* preamble = (uint32_t*) words; 
+	size_t k=0; 
+	if ((uint8_t) state->time_high == (uint8_t) HEADER_START)
+		preamble[k++] = ((uint32_t) EVT2_OTHERS) << 28; 
+	preamble[k++] = (((uint32_t) EVT2_TIME_HIGH) << 28) | 
+                    ((uint32_t) state->time_high & 0xFFFFFFFU); 
+	return k*sizeof(*preamble); 
+}
+
+DLLEXPORT int cut_evt2_span(reader_t* reader, 
+                            const char* fpath_out, 
+                            evt2_cargo_t* start, 
+                            evt2_cargo_t* end, 
+                            timestamp_t t_start, 
+                            timestamp_t t_end){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	int status = locate_time(reader, read_evt2_staging, start, sizeof(*start), 
+                             &start->events_info, t_start); 
+	if (status == 0)
+		status = locate_time(reader, read_evt2_staging, end, sizeof(*end), 
+                             &end->events_info, t_end); 
+	if (status != 0)
+		return status; 
+	return write_span(reader, fpath_out, data_start, 
+                      start->events_info.start_byte, end->events_info.start_byte,
+                      evt2_preamble, start); 
+}
+
+DLLEXPORT int split_evt2(reader_t* reader, 
+                         split_t* split, 
+                         evt2_cargo_t* cargo){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	return split_file(reader, split, data_start, read_evt2_staging, 
+                      evt2_preamble, cargo, sizeof(*cargo), 
+                      &cargo->events_info); 
+}
+
+/** Function that finds the first TIME_HIGH word among the words in [from, to)
+ *  of the file, counted from the data beginning.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[in]  data_start  The byte where the words begin.
+ *  @param[in]  from        The first word examined.
+ *  @param[in]  to          The word where the search stops (excluded).
+ *  @param[out] time_high   The upper 28 bits of the timestamp in the word.
+ *
+ *  @return     word        The word found, or to if there is none.
+ */
+static size_t find_time_high(reader_t* reader, size_t data_start, size_t from, 
+                             size_t to, uint64_t* time_high){
+	const uint32_t* buff; 
+	size_t k=from, j=0, values_read=0; 
+	if (reader_seek(reader, data_start + from*sizeof(*buff)) != 0)
+		return to; 
+	while (k < to && (values_read = reader_fetch(reader, (const void**)&buff, 
+                                                 sizeof(*buff))) > 0){
+		for (j=0; j < values_read && k < to; j++, k++){
+			if ((buff[j] >> 28) == EVT2_TIME_HIGH){
+				*time_high = (uint64_t) (buff[j] & 0xFFFFFFFU); 
+				return k; 
+			}
+		}
+		reader_consume(reader, j*sizeof(*buff)); 
+	}
+	return to; 
+}
+
+DLLEXPORT int seek_time_evt2(reader_t* reader, 
+                             evt2_cargo_t* cargo, 
+                             timestamp_t t){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	const size_t nwords = (reader_size(reader) - data_start) / sizeof(uint32_t); 
+
+	// The resume point is the last TIME_HIGH word such that all the events 
+	// following it up to the next one precede t, so that all the events before 
+	// it precede t as well. The bisection probes the first TIME_HIGH word 
+	// after the middle word, and the last span is scanned linearly.
+	size_t lo=0, hi=nwords, mid=0, word=0, best=nwords; 
+	uint64_t time_high=0, best_time_high=0; 
+	while (hi - lo > SEEK_LINEAR_WORDS){
+		mid = lo + (hi - lo)/2; 
+		word = find_time_high(reader, data_start, mid, hi, &time_high); 
+		if (word < hi && (timestamp_t)((time_high + 1) << 6) <= t){
+			best = word; 
+			best_time_high = time_high; 
+			lo = word + 1; 
+		} else {
+			hi = mid; 
+		}
+	}
+	while ((word = find_time_high(reader, data_start, lo, hi, &time_high)) < hi
+           && (timestamp_t)((time_high + 1) << 6) <= t){
+		best = word; 
+		best_time_high = time_high; 
+		lo = word + 1; 
+	}
+
+	cargo->events_info.finished = 0; 
+	if (best == nwords){
+		// t precedes the first TIME_HIGH word: the file is read from the 
+		// beginning.
+		cargo->events_info.start_byte = 0; 
+		cargo->time_high = 0; 
+		cargo->last_t = 0; 
+	} else {
+		cargo->events_info.start_byte = data_start + best*sizeof(uint32_t); 
+		cargo->time_high = best_time_high; 
+		cargo->last_t = (int64_t) (best_time_high << 6); 
+	}
+	return 0; 
+}
+
+/** Structure holding the portion of the file decoded by a thread in
+ *  read_evt2_parallel().
+ *
+ *  @field  reader          The reader of the thread, limited to the segment.
+ *  @field  cargo           The decoder state at the segment beginning.
+ *  @field  arr             Where the events of the segment are written.
+ *  @field  dim             The number of events in the segment.
+ *  @field  has_time_high   Flag to indicate that the segment contains at least
+ *                          a TIME_HIGH word.
+ *  @field  time_high       The last upper 28 bits of the timestamp found in 
+ *                          the segment.
+ *  @field  status          A flag that when different from 0, indicates that 
+ *                          there has been some error in the segment.
+ */
+typedef struct {
+	reader_t* reader; 
+	evt2_cargo_t cargo; 
+	event_t* arr; 
+	size_t dim; 
+	uint8_t has_time_high; 
+	uint64_t time_high; 
+	int status; 
+} evt2_segment_t;
+
+/** Function that counts the events in a segment and finds its last TIME_HIGH
+ *  word. Executed by each thread in the first pass of read_evt2_parallel().
+ *
+ *  @param[in]  arg     Pointer to the evt2_segment_t structure.
+ */
+static void* count_evt2_segment(void* arg){
+	evt2_segment_t* segment = (evt2_segment_t*) arg; 
+	if (reader_seek(segment->reader, 
+                    segment->cargo.events_info.start_byte) != 0){
+		segment->status = -1; 
+		return NULL; 
+	}
+
+	// Buffer to read the file.
+	const uint32_t* buff; 
+	// The byte that identifies the event type.
+	uint8_t event_type; 
+	// Indices to access the input file.
+	size_t j=0, values_read=0, dim=0, next_count=0; 
+	const uint32_t mask_28b=0xFFFFFFFU; 
+	// Kernel counting the CD words between TIME_HIGH words.
+	const evt2_count_kernel_t count_cd = get_evt2_count_kernel(); 
+
+	while ((values_read = reader_fetch(segment->reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		next_count = 0; 
+		for (j=0; j < values_read; j++){
+			if (count_cd != NULL && j == next_count){
+				j += count_cd(buff + j, values_read - j, 
+                              EVT2_UNKNOWN_TYPES | EVT2_TIME_TYPES, &dim); 
+				next_count = j + 8; 
+				if (j == values_read)
+					break; 
+			}
+			// Getting the event type. 
+			event_type = (uint8_t) (buff[j] >> 28); 
+			switch (event_type){
+				case EVT2_CD_ON:
+				case EVT2_CD_OFF:
+					dim++; 
+					break; 
+
+				case EVT2_TIME_HIGH:
+					segment->time_high = (uint64_t)(buff[j] & mask_28b); 
+					segment->has_time_high = 1; 
+					break; 
+
+				case EVT2_EXT_TRIGGER:
+				case EVT2_OTHERS:
+				case EVT2_CONTINUED:
+					break; 
+
+				default:
+					fprintf(stderr, "ERROR: event type not recognised: 0x%x.\n", 
+                            event_type);
+					segment->status = -1; 
+					return NULL; 
+			}
+		}
+		reader_consume(segment->reader, j*sizeof(*buff)); 
+	}
+	segment->dim = dim; 
+	return NULL; 
+}
+
+/** Function that decodes a segment to its slice of the output array, starting
+ *  from the state found in the first pass. Executed by each thread in the 
+ *  second pass of read_evt2_parallel().
+ *
+ *  @param[in]  arg     Pointer to the evt2_segment_t structure.
+ */
+static void* decode_evt2_segment(void* arg){
+	evt2_segment_t* segment = (evt2_segment_t*) arg; 
+	segment->cargo.events_info.dim = segment->dim; 
+	if (segment->dim > 0)
+		segment->status = read_evt2(segment->reader, segment->arr, 
+                                    &segment->cargo); 
+	return NULL; 
+}
+
+DLLEXPORT int read_evt2_parallel(reader_t* reader, 
+                                event_t* arr, 
+                                evt2_cargo_t* cargo, 
+                                size_t nthreads){
+	if (cargo->events_info.start_byte == 0){
+		CHECK_JUMP_HEADER(  (cargo->events_info.start_byte = 
+                            reader_jump_header(reader)) ); 
+	}
+	const size_t word_size = sizeof(uint32_t); 
+	const size_t file_size = reader_size(reader); 
+	const size_t first_byte = cargo->events_info.start_byte; 
+	const size_t num_words = (file_size > first_byte) ? 
+                                (file_size - first_byte) / word_size : 0; 
+	const size_t nsegments = get_num_segments(num_words * word_size, nthreads); 
+
+	evt2_segment_t* segments = (evt2_segment_t*) calloc(nsegments, 
+                                                        sizeof(evt2_segment_t)); 
+	CHECK_BUFF_ALLOCATION(segments); 
+
+	// Splitting the file in segments made of whole words.
+	size_t k=0, dim=0; 
+	int status=0; 
+	for (k=0; k < nsegments; k++){
+		segments[k].cargo.events_info.start_byte = first_byte + 
+                                    (num_words * k / nsegments) * word_size; 
+		segments[k].reader = reader_clone(reader); 
+		if (segments[k].reader == NULL)
+			status = -1; 
+		else 
+			reader_set_end(segments[k].reader, first_byte + 
+                            (num_words * (k+1) / nsegments) * word_size); 
+	}
+
+	// First pass: counting the events in each segment.
+	if (status == 0)
+		run_threads(count_evt2_segment, segments, sizeof(*segments), nsegments); 
+
+	// Prefix sum of the events count and propagation of the TIME_HIGH words, 
+	// so that each segment knows where to write and its initial timestamp.
+	uint64_t time_high = cargo->time_high; 
+	for (k=0; status == 0 && k < nsegments; k++){
+		status = segments[k].status; 
+		segments[k].cargo.time_high = time_high; 
+		segments[k].cargo.last_t = (k == 0) ? cargo->last_t : 
+                                    (timestamp_t)(time_high << 6); 
+		segments[k].arr = arr + dim; 
+		dim += segments[k].dim; 
+		if (segments[k].has_time_high)
+			time_high = segments[k].time_high; 
+	}
+
+	// Second pass: decoding the segments, if the array is large enough.
+	if (status == 0 && dim <= cargo->events_info.dim){
+		run_threads(decode_evt2_segment, segments, sizeof(*segments), 
+                    nsegments); 
+		for (k=0; k < nsegments; k++){
+			if (segments[k].status != 0)
+				status = segments[k].status; 
+			if (segments[k].dim > 0)
+				cargo->last_t = segments[k].cargo.last_t; 
+		}
+		cargo->time_high = time_high; 
+		cargo->events_info.start_byte = first_byte + num_words * word_size; 
+		cargo->events_info.finished = 1; 
+	}
+	cargo->events_info.dim = dim; 
+
+	for (k=0; k < nsegments; k++)
+		close_reader(segments[k].reader); 
+	free(segments); 
+	return status; 
+}
+
 DLLEXPORT int save_evt2(const char* fpath, 
                         event_t* arr, 
                         evt2_cargo_t* cargo, 
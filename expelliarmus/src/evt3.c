@@ -3,26 +3,137 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "threads.h"
+#include "simd.h"
+#include "output.h"
+#include "index.h"
 
-DLLEXPORT void measure_evt3(const char* fpath, 
-                            evt3_cargo_t* cargo, 
-                            size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
-	
+// Bit masks of the event types that stop the counting kernels: the types not
+// recognised, that have to be reported by the scalar code, and the time words,
+// that change the timestamp of the following events.
+#define EVT3_UNKNOWN_TYPES (0xFFFFU & ~((1U<<EVT3_EVT_ADDR_Y) |\
+            (1U<<EVT3_EVT_ADDR_X) | (1U<<EVT3_VECT_BASE_X) | (1U<<EVT3_VECT_12) |\
+            (1U<<EVT3_VECT_8) | (1U<<EVT3_TIME_LOW) | (1U<<EVT3_CONTINUED_4) |\
+            (1U<<EVT3_TIME_HIGH) | (1U<<EVT3_EXT_TRIGGER) | (1U<<EVT3_OTHERS) |\
+            (1U<<EVT3_CONTINUED_12)))
+#define EVT3_TIME_TYPES ((1U<<EVT3_TIME_LOW) | (1U<<EVT3_TIME_HIGH))
+
+/** Signature of the kernels that count the events in a stream, i.e. the 
+ *  ADDR_X words and the bits set in the VECT_12 and VECT_8 masks.
+ *
+ *  @param[in]  words       The words to be counted.
+ *  @param[in]  num_words   The number of words available.
+ *  @param[in]  stop_types  Bit mask of the event types that stop the kernel.
+ *  @param[out] dim         The number of events, incremented in place.
+ *
+ *  @return     num_words   The number of words counted. The kernel stops 
+ *                          before the first block of words containing one of 
+ *                          the stop types, and before the last incomplete 
+ *                          block: the remaining words are left to the caller.
+ */
+typedef size_t (*evt3_count_kernel_t)(const uint16_t*, size_t, uint32_t, 
+                                      size_t*);
+
+#ifdef SIMD_X86
+/** AVX2 kernel counting the events in blocks of 16 words. The event types are
+ *  looked up in the stop types through a byte shuffle, and the vector masks 
+ *  are counted with the nibble population count table.
+ */
+TARGET_AVX2
+static size_t count_evt3_avx2(const uint16_t* words, 
+                              size_t num_words, 
+                              uint32_t stop_types, 
+                              size_t* dim){
+	int8_t stop_lut[16]; 
+	size_t i=0, k=0; 
+	for (k=0; k < 16; k++)
+		stop_lut[k] = (int8_t)(((stop_types >> k) & 1U) ? -1 : 0); 
+	const __m256i stop = _mm256_broadcastsi128_si256(
+                            _mm_loadu_si128((const __m128i*)stop_lut)); 
+	const __m256i bits_lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 
+                                              1, 2, 2, 3, 2, 3, 3, 4, 
+                                              0, 1, 1, 2, 1, 2, 2, 3, 
+                                              1, 2, 2, 3, 2, 3, 3, 4); 
+	const __m256i mask_4b = _mm256_set1_epi8(0x0F); 
+	const __m256i mask_8b = _mm256_set1_epi16(0xFF); 
+	const __m256i mask_12b = _mm256_set1_epi16(0xFFF); 
+	const __m256i addr_x = _mm256_set1_epi16(EVT3_EVT_ADDR_X); 
+	const __m256i vect_12 = _mm256_set1_epi16(EVT3_VECT_12); 
+	const __m256i vect_8 = _mm256_set1_epi16(EVT3_VECT_8); 
+	const __m256i ones_8b = _mm256_set1_epi8(1); 
+	const __m256i ones_16b = _mm256_set1_epi16(1); 
+	__m256i block, types, masks, bits, count; 
+	uint8_t stopped=0; 
+	while (!stopped && i + 16 <= num_words){
+		// At most 13 events per lane and block: the lanes are summed every 
+		// 4096 blocks, before they can overflow.
+		count = _mm256_setzero_si256(); 
+		for (k=0; k < 4096 && i + 16 <= num_words; k++, i += 16){
+			block = _mm256_loadu_si256((const __m256i*)(words + i)); 
+			types = _mm256_srli_epi16(block, 12); 
+			if (!_mm256_testz_si256(_mm256_shuffle_epi8(stop, types), 
+                                    _mm256_shuffle_epi8(stop, types))){
+				stopped = 1; 
+				break; 
+			}
+			// Keeping only the masks of the vector words.
+			masks = _mm256_and_si256(block, _mm256_or_si256(
+                        _mm256_and_si256(_mm256_cmpeq_epi16(types, vect_12), 
+                                         mask_12b), 
+                        _mm256_and_si256(_mm256_cmpeq_epi16(types, vect_8), 
+                                         mask_8b))); 
+			bits = _mm256_add_epi8(
+                    _mm256_shuffle_epi8(bits_lut, 
+                                        _mm256_and_si256(masks, mask_4b)), 
+                    _mm256_shuffle_epi8(bits_lut, _mm256_and_si256(
+                                        _mm256_srli_epi16(masks, 4), mask_4b))); 
+			count = _mm256_add_epi16(count, 
+                                     _mm256_maddubs_epi16(bits, ones_8b)); 
+			// One event for each ADDR_X word.
+			count = _mm256_sub_epi16(count, 
+                                     _mm256_cmpeq_epi16(types, addr_x)); 
+		}
+		*dim += sum_epu32_avx2(_mm256_madd_epi16(count, ones_16b)); 
+	}
+	return i; 
+}
+#endif
+
+/** Function that selects the kernel used to count the events.
+ *
+ *  @return     kernel      The AVX2 kernel if supported, NULL otherwise: the
+ *                          words are then counted by the scalar code.
+ */
+static evt3_count_kernel_t get_evt3_count_kernel(void){
+#ifdef SIMD_X86
+	if (get_simd() >= SIMD_AVX2)
+		return count_evt3_avx2; 
+#endif
+	return NULL; 
+}
+
+// Decoder used to count the events passing a filter.
+static int read_evt3_staging(reader_t*, event_t*, void*); 
+
+DLLEXPORT void measure_evt3(reader_t* reader, evt3_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_evt3_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 0) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
-		MEAS_CHECK_JUMP_HEADER((cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)), 
-                                cargo);
+		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
+                                    reader_jump_header(reader)), cargo );
 	} else {
-		MEAS_CHECK_FSEEK(fseek(fp, cargo->events_info.start_byte, SEEK_SET), 
+		MEAS_CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte), 
                         cargo); 
 	}
 
 	// Buffer used to read the binary file.
-	uint16_t* buff = (uint16_t*) malloc(buff_size * sizeof(uint16_t)); 
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
+	const uint16_t* buff; 
 	
 	// Indices to read the file.
 	size_t values_read=0, j=0, dim=0; 
@@ -31,16 +142,22 @@ DLLEXPORT void measure_evt3(const char* fpath,
 
 	// Counters used to keep track of number of events_info encoded in vectors 
     // and of the base x address of these.
-	uint16_t k=0, num_vect_events=0; 
+	uint16_t num_vect_events=0; 
 	// Masks to extract bits.
 	const uint16_t mask_11b=0x7FFU, mask_12b=0xFFFU, mask_8b=0xFFU; 
 	// Temporary values to handle overflows.
 	uint16_t buff_tmp=0;
-
+	// Kernel counting the events.
+	const evt3_count_kernel_t count_events = get_evt3_count_kernel(); 
 
 	// Reading the file.
-	while ((values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0){
-		for (j=0; j<values_read; j++){
+	while ((values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		// The vectorized kernel counts as many words as possible; the rest, 
+		// including the words of unknown type, goes through the switch.
+		j = (count_events != NULL) ? 
+                count_events(buff, values_read, EVT3_UNKNOWN_TYPES, &dim) : 0; 
+		for (; j<values_read; j++){
 			// Getting the event type. 
 			event_type = (uint8_t)(buff[j] >> 12); 
 			switch (event_type){
@@ -63,11 +180,7 @@ DLLEXPORT void measure_evt3(const char* fpath,
 						num_vect_events = 8; 
 						buff_tmp = (uint16_t)(buff[j] & mask_8b);
 					}
-					for (k=0; k<num_vect_events; k++){
-						if (buff_tmp & (1U<<k)){
-							dim++; 
-						}
-					}
+					dim += count_bits((uint16_t)buff_tmp); 
 					num_vect_events = 0; 
 					break; 
 
@@ -83,34 +196,34 @@ DLLEXPORT void measure_evt3(const char* fpath,
 					MEAS_EVENT_TYPE_NOT_RECOGNISED(event_type, cargo); 
 			}
 		}
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
-	fclose(fp); 
-	free(buff); 
 	cargo->events_info.dim = dim; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return; 
 }
 
-DLLEXPORT void get_time_window_evt3(const char* fpath, 
-                                    evt3_cargo_t* cargo, 
-                                    size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	MEAS_CHECK_FILE(fp, fpath, cargo); 
-	
+DLLEXPORT void get_time_window_evt3(reader_t* reader, evt3_cargo_t* cargo){
+	// The events passing a filter can be counted only by decoding them.
+	if (cargo->events_info.filter != NULL){
+		if (count_filtered(reader, read_evt3_staging, cargo, sizeof(*cargo), 
+                           &cargo->events_info, 
+                           (timestamp_t) cargo->events_info.time_window) != 0)
+			cargo->events_info.dim = 0; 
+		return; 
+	}
 	// Jumping over the headers.
 	if (cargo->events_info.start_byte == 0){
-		MEAS_CHECK_JUMP_HEADER((cargo->events_info.start_byte = 
-                                    jump_header(fp, NULL, 0U)), 
-                                cargo);
+		MEAS_CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
+                                    reader_jump_header(reader)), cargo );
 	} else {
-		MEAS_CHECK_FSEEK(fseek( fp, cargo->events_info.start_byte, SEEK_SET), 
-                                cargo ); 
+		MEAS_CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte), 
+                        cargo); 
 	}
 
 	// Buffer used to read the binary file.
-	uint16_t* buff = (uint16_t*) malloc(buff_size * sizeof(uint16_t)); 
-	MEAS_CHECK_BUFF_ALLOCATION(buff, cargo); 
+	const uint16_t* buff; 
 	
 	// Indices to read the file.
 	size_t values_read=0, j=0, dim=0; 
@@ -119,7 +232,7 @@ DLLEXPORT void get_time_window_evt3(const char* fpath,
 
 	// Counters used to keep track of number of events_info encoded in vectors 
     // and of the base x address of these.
-	uint16_t k=0, num_vect_events=0; 
+	uint16_t num_vect_events=0; 
 	// Masks to extract bits.
 	const uint16_t mask_11b=0x7FFU, mask_12b=0xFFFU, mask_8b=0xFFU; 
 	// Temporary values to handle overflows.
@@ -131,11 +244,29 @@ DLLEXPORT void get_time_window_evt3(const char* fpath,
              time_low_ovfs=cargo->time_low_ovfs; 
 	uint64_t time_window = cargo->events_info.time_window; 
 	uint8_t first_run=1, loop_condition_flag=1; 
+	// Kernel counting the events and index of the next word from which it is
+	// tried.
+	const evt3_count_kernel_t count_events = get_evt3_count_kernel(); 
+	size_t next_count=0; 
 
 	// Reading the file.
 	while ( loop_condition_flag && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0 ){
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0 ){
+		next_count = 0; 
 		for (j=0; loop_condition_flag && j<values_read; j++){
+			// The timestamp changes only with the time words: if the next 
+			// event does not end the time window, the events up to the next 
+			// time word are just counted.
+			if (count_events != NULL && j == next_count){
+				if (time_window > last_t - first_t)
+					j += count_events(buff + j, values_read - j, 
+                                      EVT3_UNKNOWN_TYPES | EVT3_TIME_TYPES, 
+                                      &dim); 
+				next_count = j + 16; 
+				if (j == values_read)
+					break; 
+			}
 			// Getting the event type. 
 			event_type = (uint8_t)(buff[j] >> 12); 
 			switch (event_type){
@@ -159,11 +290,7 @@ DLLEXPORT void get_time_window_evt3(const char* fpath,
 						num_vect_events = 8; 
 						buff_tmp = (uint64_t)(buff[j] & mask_8b);
 					}
-					for (k=0; k<num_vect_events; k++){
-						if (buff_tmp & (1U<<k)){
-							dim++; 
-						}
-					}
+					dim += count_bits((uint16_t)buff_tmp); 
 					num_vect_events = 0; 
 					loop_condition_flag = (time_window > last_t - first_t);
 					break; 
@@ -206,33 +333,26 @@ DLLEXPORT void get_time_window_evt3(const char* fpath,
 					MEAS_EVENT_TYPE_NOT_RECOGNISED(event_type, cargo); 
 			}
 		}
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
-	fclose(fp); 
-	free(buff); 
 	cargo->events_info.dim = dim; 
 	if (values_read==0)
 		cargo->events_info.finished = 1;
 	return; 
 }
 
-DLLEXPORT int read_evt3(const char* fpath, 
+DLLEXPORT int read_evt3(reader_t* reader, 
                         event_t* arr, 
-                        evt3_cargo_t* cargo, 
-                        size_t buff_size){
-	FILE* fp = fopen(fpath, "rb"); 
-	CHECK_FILE(fp, fpath); 
-
+                        evt3_cargo_t* cargo){
 	if (cargo->events_info.start_byte == 0){
-		CHECK_JUMP_HEADER((cargo->events_info.start_byte = 
-                                jump_header(fp, NULL, 0U))); 
+		CHECK_JUMP_HEADER( (cargo->events_info.start_byte = 
+                                    reader_jump_header(reader)) );
 	} else {
-		CHECK_FSEEK(fseek(fp, (long)cargo->events_info.start_byte, SEEK_SET)); 
+		CHECK_SEEK(reader_seek(reader, cargo->events_info.start_byte)); 
 	}
-	size_t byte_pt = cargo->events_info.start_byte; 
 
 	// Buffer used to read the binary file.
-	uint16_t* buff = (uint16_t*) malloc(buff_size * sizeof(uint16_t)); 
-	CHECK_BUFF_ALLOCATION(buff); 
+	const uint16_t* buff; 
 	
 	// Indices to read the file.
 	size_t values_read=0, j=0, i=0, dim=cargo->events_info.dim; 
@@ -241,7 +361,13 @@ DLLEXPORT int read_evt3(const char* fpath,
 
 	// Counters used to keep track of number of events_info encoded in vectors 
     // and of the base x address of these.
-	uint16_t k=0, num_vect_events=0; 
+	uint16_t num_vect_events=0, vect_mask=0; 
+	event_t vect_event; 
+	// Filter of the events, if any.
+	const filter_t* filter = cargo->events_info.filter; 
+	const int transform = filter != NULL && has_transform(filter); 
+	// Array of the trigger events, if they are collected.
+	triggers_t* triggers = cargo->events_info.triggers; 
 	// Masks to extract bits.
 	const uint16_t mask_11b=0x7FFU, mask_12b=0xFFFU, mask_8b=0xFFU; 
 	// Temporary values to handle overflows.
@@ -250,9 +376,11 @@ DLLEXPORT int read_evt3(const char* fpath,
     uint8_t tsWarning = 0; 
 
 	// Reading the file.
-	while ( i < dim && 
-            (values_read = fread(buff, sizeof(*buff), buff_size, fp)) > 0){
-		for (j=0; i < dim && j < values_read; j++){
+	while ( i < dim && has_trigger_room(triggers) && 
+            (values_read = reader_fetch(reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		for (j=0; i < dim && has_trigger_room(triggers) && j < values_read; 
+                j++){
 			// Getting the event type. 
 			event_type = (uint8_t)(buff[j] >> 12); 
 			switch (event_type){
@@ -270,7 +398,11 @@ DLLEXPORT int read_evt3(const char* fpath,
 					// t
 					arr[i].t = cargo->last_event.t;
 					// x
-					arr[i++].x = (address_t)(buff[j] & mask_11b);
+					arr[i].x = (address_t)(buff[j] & mask_11b);
+					// The event is overwritten by the next one if it is 
+					// filtered out.
+					if (filter == NULL || filter_event(filter, arr + i))
+						i++; 
 					break; 
 
 				case EVT3_VECT_BASE_X:
@@ -288,17 +420,24 @@ DLLEXPORT int read_evt3(const char* fpath,
 						num_vect_events = 8; 
 						buff_tmp = (uint64_t)(buff[j] & mask_8b);
 					}
-					for (k=0; k<num_vect_events; k++){
-						if (buff_tmp & (1U<<k)){
-							// y
-							arr[i].y = cargo->last_event.y;
-							// p
-							arr[i].p = cargo->last_event.p;
-							// t
-							arr[i].t = cargo->last_event.t;
-							// x
-							arr[i++].x = (address_t)(cargo->base_x + k); 
-						}
+					// One event for each bit set, from the lowest one: only the
+					// x address changes, the rest is copied from the template.
+					vect_event = cargo->last_event; 
+					vect_mask = (uint16_t)buff_tmp; 
+					// The events filtered out are dropped from the mask before
+					// being expanded.
+					if (filter != NULL)
+						vect_mask = filter_vector(filter, cargo->base_x, 
+                                                  vect_event.y, vect_event.p, 
+                                                  vect_mask, 
+                                                  (uint8_t) num_vect_events); 
+					for (; vect_mask != 0; 
+                            vect_mask &= (uint16_t)(vect_mask - 1)){
+						vect_event.x = (address_t)(cargo->base_x + 
+                                                    lowest_bit(vect_mask)); 
+						arr[i] = vect_event; 
+						if (!transform || transform_event(filter, arr + i))
+							i++; 
 					}
 					cargo->base_x += num_vect_events; 
 					num_vect_events = 0; 
@@ -339,6 +478,15 @@ DLLEXPORT int read_evt3(const char* fpath,
 					break; 
 
 				case EVT3_EXT_TRIGGER:
+					if (triggers != NULL){
+						triggers->arr[triggers->num].t = cargo->last_event.t; 
+						triggers->arr[triggers->num].id = 
+                            (uint8_t) ((buff[j] >> 8) & 0xFU); 
+						triggers->arr[triggers->num++].value = 
+                            (uint8_t) (buff[j] & 0x1U); 
+					}
+					break; 
+
 				case EVT3_OTHERS:
 				case EVT3_CONTINUED_12:
 				case EVT3_CONTINUED_4:
@@ -348,20 +496,408 @@ DLLEXPORT int read_evt3(const char* fpath,
 					EVENT_TYPE_NOT_RECOGNISED(event_type); 
 			}
 		}
-		byte_pt += j*sizeof(*buff); 
+		reader_consume(reader, j*sizeof(*buff)); 
 	}
     if (tsWarning)
         fprintf(stderr, "WARNING: The timestamps are not monotonic.\n"); 
-	fclose(fp); 
-	free(buff); 
 
-	cargo->events_info.start_byte = byte_pt; 
+	cargo->events_info.start_byte = reader_tell(reader); 
 	cargo->events_info.dim = i; 
 	if (values_read==0)
 		cargo->events_info.finished = 1; 
 	return 0; 
 }
 
+/** Function that adapts read_evt3() to the read_fn_t signature used by 
+ *  read_columns().
+ */
+static int read_evt3_staging(reader_t* reader, event_t* arr, void* cargo){
+	return read_evt3(reader, arr, (evt3_cargo_t*) cargo); 
+}
+
+DLLEXPORT int read_evt3_columns(reader_t* reader, 
+                                columns_t* columns, 
+                                evt3_cargo_t* cargo){
+	return read_columns(reader, columns, read_evt3_staging, cargo, 
+                        &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt3_frames(reader_t* reader, 
+                               frames_t* frames, 
+                               evt3_cargo_t* cargo){
+	return read_frames(reader, frames, read_evt3_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt3_frames_parallel(reader_t* reader, 
+                                        frames_t* frames, 
+                                        evt3_cargo_t* cargos, 
+                                        size_t nsegments){
+	return read_frames_parallel(reader, frames, read_evt3_staging, cargos, 
+                                sizeof(*cargos), nsegments); 
+}
+
+DLLEXPORT int profile_evt3(reader_t* reader, 
+                           uint32_t* counts, 
+                           size_t width, 
+                           size_t height, 
+                           evt3_cargo_t* cargo){
+	return count_pixels(reader, counts, width, height, read_evt3_staging, 
+                        cargo, &cargo->events_info); 
+}
+
+DLLEXPORT int index_evt3(reader_t* reader, 
+                         index_t* index, 
+                         evt3_cargo_t* cargo){
+	return build_index(reader, index, read_evt3_staging, cargo, sizeof(*cargo), 
+                       &cargo->events_info); 
+}
+
+DLLEXPORT int read_evt3_range(reader_t* reader, 
+                              event_t* arr, 
+                              range_t* range, 
+                              evt3_cargo_t* cargo){
+	return read_range(reader, arr, range, read_evt3_staging, cargo, 
+                      &cargo->events_info); 
+}
+
+/** Function that writes the preamble of a portion of an EVT3 file: the 
+ *  TIME_HIGH, TIME_LOW, ADDR_Y and VECT_BASE_X words restoring the decoder 
+ *  state, except for the overflow counts of the timestamp. If the first byte 
+ *  is HEADER_START, the word would be taken for a header line: an EVT3_OTHERS
+ *  word, that is skipped by the decoder, is put before it.
+ */
+static size_t evt3_preamble(const void* cargo, void* words){
+	const evt3_cargo_t* state = (const evt3_cargo_t*) cargo; 
+	uint16_t* preamble = (uint16_t*) words; 
+	size_t k=0; 
+	if ((uint8_t) state->time_high == (uint8_t) HEADER_START)
+		preamble[k++] = (uint16_t) (EVT3_OTHERS << 12); 
+	preamble[k++] = (uint16_t) ((EVT3_TIME_HIGH << 12) | 
+                                (state->time_high & 0xFFFU)); 
+	preamble[k++] = (uint16_t) ((EVT3_TIME_LOW << 12) | 
+                                (state->time_low & 0xFFFU)); 
+	preamble[k++] = (uint16_t) ((EVT3_EVT_ADDR_Y << 12) | 
+                                (state->last_event.y & 0x7FFU)); 
+	preamble[k++] = (uint16_t) ((EVT3_VECT_BASE_X << 12) | 
+                                ((state->last_event.p & 0x1U) << 11) | 
+                                (state->base_x & 0x7FFU)); 
+	return k*sizeof(*preamble); 
+}
+
+DLLEXPORT int cut_evt3_span(reader_t* reader, 
+                            const char* fpath_out, 
+                            evt3_cargo_t* start, 
+                            evt3_cargo_t* end, 
+                            timestamp_t t_start, 
+                            timestamp_t t_end){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	int status = locate_time(reader, read_evt3_staging, start, sizeof(*start), 
+                             &start->events_info, t_start); 
+	if (status == 0)
+		status = locate_time(reader, read_evt3_staging, end, sizeof(*end), 
+                             &end->events_info, t_end); 
+	if (status != 0)
+		return status; 
+	return write_span(reader, fpath_out, data_start, 
+                      start->events_info.start_byte, end->events_info.start_byte,
+                      evt3_preamble, start); 
+}
+
+DLLEXPORT int split_evt3(reader_t* reader, 
+                         split_t* split, 
+                         evt3_cargo_t* cargo){
+	size_t data_start=0; 
+	CHECK_JUMP_HEADER( (data_start = reader_jump_header(reader)) ); 
+	return split_file(reader, split, data_start, read_evt3_staging, 
+                      evt3_preamble, cargo, sizeof(*cargo), 
+                      &cargo->events_info); 
+}
+
+/** Structure holding the portion of the file decoded by a thread in
+ *  read_evt3_parallel(), together with the summary of the state words found in
+ *  it during the first pass.
+ *
+ *  @field  reader              The reader of the thread, limited to the 
+ *                              segment.
+ *  @field  cargo               The decoder state at the segment beginning.
+ *  @field  arr                 Where the events of the segment are written.
+ *  @field  dim                 The number of events in the segment.
+ *  @field  has_time_high       Flag to indicate that the segment contains at 
+ *                              least a TIME_HIGH word.
+ *  @field  first_time_high     The first TIME_HIGH value in the segment.
+ *  @field  time_high           The last TIME_HIGH value in the segment.
+ *  @field  time_high_ovfs      The TIME_HIGH overflows after the first one.
+ *  @field  has_time_low        Flag to indicate that the segment contains at 
+ *                              least a TIME_LOW word.
+ *  @field  first_time_low      The first TIME_LOW value in the segment.
+ *  @field  time_low            The last TIME_LOW value in the segment.
+ *  @field  time_low_ovfs       The TIME_LOW overflows after the first one.
+ *  @field  has_base_x          Flag to indicate that the segment contains at
+ *                              least a VECT_BASE_X word.
+ *  @field  base_x              The base X address at the segment end if 
+ *                              has_base_x is set, otherwise the increment
+ *                              due to the vector events in the segment.
+ *  @field  has_y               Flag to indicate that the segment contains at 
+ *                              least an ADDR_Y word.
+ *  @field  y                   The last Y address in the segment.
+ *  @field  has_p               Flag to indicate that the segment contains at 
+ *                              least a word carrying the polarity.
+ *  @field  p                   The last polarity in the segment.
+ *  @field  status              A flag that when different from 0, indicates 
+ *                              that there has been some error in the segment.
+ */
+typedef struct {
+	reader_t* reader; 
+	evt3_cargo_t cargo; 
+	event_t* arr; 
+	size_t dim; 
+	uint8_t has_time_high; 
+	uint64_t first_time_high; 
+	uint64_t time_high; 
+	uint64_t time_high_ovfs; 
+	uint8_t has_time_low; 
+	uint64_t first_time_low; 
+	uint64_t time_low; 
+	uint64_t time_low_ovfs; 
+	uint8_t has_base_x; 
+	uint16_t base_x; 
+	uint8_t has_y; 
+	address_t y; 
+	uint8_t has_p; 
+	polarity_t p; 
+	int status; 
+} evt3_segment_t;
+
+/** Function that counts the events in a segment and summarises the state 
+ *  words found in it. Executed by each thread in the first pass of 
+ *  read_evt3_parallel().
+ *
+ *  @param[in]  arg     Pointer to the evt3_segment_t structure.
+ */
+static void* count_evt3_segment(void* arg){
+	evt3_segment_t* segment = (evt3_segment_t*) arg; 
+	if (reader_seek(segment->reader, 
+                    segment->cargo.events_info.start_byte) != 0){
+		segment->status = -1; 
+		return NULL; 
+	}
+
+	// Buffer used to read the binary file.
+	const uint16_t* buff; 
+	// Indices to read the file.
+	size_t values_read=0, j=0, dim=0; 
+	// Byte that identifies the event type.
+	uint8_t event_type; 
+	// Counters used to keep track of number of events encoded in vectors.
+	uint16_t num_vect_events=0; 
+	// Masks to extract bits.
+	const uint16_t mask_11b=0x7FFU, mask_12b=0xFFFU, mask_8b=0xFFU; 
+	uint16_t buff_tmp=0;
+
+	while ((values_read = reader_fetch(segment->reader, (const void**)&buff, 
+                                        sizeof(*buff))) > 0){
+		for (j=0; j<values_read; j++){
+			// Getting the event type. 
+			event_type = (uint8_t)(buff[j] >> 12); 
+			switch (event_type){
+				case EVT3_EVT_ADDR_Y:
+					segment->y = (address_t)(buff[j] & mask_11b); 
+					segment->has_y = 1; 
+					break; 
+
+				case EVT3_EVT_ADDR_X:
+					segment->p = (polarity_t)((buff[j] >> 11) & 0x1U); 
+					segment->has_p = 1; 
+					dim++; 
+					break; 
+
+				case EVT3_VECT_BASE_X:
+					segment->p = (polarity_t)((buff[j] >> 11) & 0x1U); 
+					segment->has_p = 1; 
+					segment->base_x = (uint16_t)(buff[j] & mask_11b); 
+					segment->has_base_x = 1; 
+					break; 
+
+				case EVT3_VECT_12:
+					num_vect_events = 12; 
+					buff_tmp = (uint16_t)(buff[j] & mask_12b);
+
+				case EVT3_VECT_8:
+					if (num_vect_events == 0){
+						num_vect_events = 8; 
+						buff_tmp = (uint16_t)(buff[j] & mask_8b);
+					}
+					dim += count_bits((uint16_t)buff_tmp); 
+					segment->base_x += num_vect_events; 
+					num_vect_events = 0; 
+					break; 
+
+				case EVT3_TIME_LOW:
+					buff_tmp = (uint16_t)(buff[j] & mask_12b); 
+					if (!segment->has_time_low){
+						segment->first_time_low = buff_tmp; 
+						segment->has_time_low = 1; 
+					} else if (buff_tmp < segment->time_low){
+						segment->time_low_ovfs++; 
+					}
+					segment->time_low = buff_tmp; 
+					break; 
+
+				case EVT3_TIME_HIGH:
+					buff_tmp = (uint16_t)(buff[j] & mask_12b); 
+					if (!segment->has_time_high){
+						segment->first_time_high = buff_tmp; 
+						segment->has_time_high = 1; 
+					} else if (buff_tmp < segment->time_high){
+						segment->time_high_ovfs++; 
+					}
+					segment->time_high = buff_tmp; 
+					break; 
+
+				case EVT3_EXT_TRIGGER:
+				case EVT3_OTHERS:
+				case EVT3_CONTINUED_12:
+				case EVT3_CONTINUED_4:
+					break; 
+
+				default:
+					fprintf(stderr, "ERROR: event type not recognised: 0x%x.\n", 
+                            event_type);
+					segment->status = -1; 
+					return NULL; 
+			}
+		}
+		reader_consume(segment->reader, j*sizeof(*buff)); 
+	}
+	segment->dim = dim; 
+	return NULL; 
+}
+
+/** Function that moves a decoder state from the beginning to the end of a 
+ *  segment, using the summary computed in the first pass. The result is the 
+ *  state that read_evt3() would have after decoding the segment.
+ *
+ *  @param[out] state       The decoder state, updated in place.
+ *  @param[in]  segment     The segment summary.
+ */
+static void skip_evt3_segment(evt3_cargo_t* state, 
+                              const evt3_segment_t* segment){
+	if (segment->has_time_high){
+		if (segment->first_time_high < state->time_high) // Overflow.
+			state->time_high_ovfs++; 
+		state->time_high_ovfs += segment->time_high_ovfs; 
+		state->time_high = segment->time_high; 
+	}
+	if (segment->has_time_low){
+		if (segment->first_time_low < state->time_low) // Overflow.
+			state->time_low_ovfs++; 
+		state->time_low_ovfs += segment->time_low_ovfs; 
+		state->time_low = segment->time_low; 
+	}
+	if (segment->has_time_high || segment->has_time_low)
+		state->last_event.t = (timestamp_t)(
+                                (state->time_high_ovfs<<24) + 
+                                ((state->time_high + 
+                                    state->time_low_ovfs)<<12) +
+                                state->time_low);
+	if (segment->has_base_x)
+		state->base_x = segment->base_x; 
+	else
+		state->base_x += segment->base_x; 
+	if (segment->has_y)
+		state->last_event.y = segment->y; 
+	if (segment->has_p)
+		state->last_event.p = segment->p; 
+	return; 
+}
+
+/** Function that decodes a segment to its slice of the output array, starting
+ *  from the state reconstructed after the first pass. Executed by each thread
+ *  in the second pass of read_evt3_parallel().
+ *
+ *  @param[in]  arg     Pointer to the evt3_segment_t structure.
+ */
+static void* decode_evt3_segment(void* arg){
+	evt3_segment_t* segment = (evt3_segment_t*) arg; 
+	segment->cargo.events_info.dim = segment->dim; 
+	if (segment->dim > 0)
+		segment->status = read_evt3(segment->reader, segment->arr, 
+                                    &segment->cargo); 
+	return NULL; 
+}
+
+DLLEXPORT int read_evt3_parallel(reader_t* reader, 
+                                event_t* arr, 
+                                evt3_cargo_t* cargo, 
+                                size_t nthreads){
+	if (cargo->events_info.start_byte == 0){
+		CHECK_JUMP_HEADER(  (cargo->events_info.start_byte = 
+                            reader_jump_header(reader)) ); 
+	}
+	const size_t word_size = sizeof(uint16_t); 
+	const size_t file_size = reader_size(reader); 
+	const size_t first_byte = cargo->events_info.start_byte; 
+	const size_t num_words = (file_size > first_byte) ? 
+                                (file_size - first_byte) / word_size : 0; 
+	const size_t nsegments = get_num_segments(num_words * word_size, nthreads); 
+
+	evt3_segment_t* segments = (evt3_segment_t*) calloc(nsegments, 
+                                                        sizeof(evt3_segment_t)); 
+	CHECK_BUFF_ALLOCATION(segments); 
+
+	// Splitting the file in segments made of whole words.
+	size_t k=0, dim=0; 
+	int status=0; 
+	for (k=0; k < nsegments; k++){
+		segments[k].reader = reader_clone(reader); 
+		if (segments[k].reader == NULL)
+			status = -1; 
+		else 
+			reader_set_end(segments[k].reader, first_byte + 
+                            (num_words * (k+1) / nsegments) * word_size); 
+		segments[k].cargo.events_info.start_byte = first_byte + 
+                                    (num_words * k / nsegments) * word_size; 
+	}
+
+	// First pass: counting the events in each segment.
+	if (status == 0)
+		run_threads(count_evt3_segment, segments, sizeof(*segments), nsegments); 
+
+	// Prefix sum of the events count and reconstruction of the decoder state
+	// at the beginning of each segment.
+	evt3_cargo_t state = *cargo; 
+	size_t start_byte = 0; 
+	for (k=0; status == 0 && k < nsegments; k++){
+		status = segments[k].status; 
+		start_byte = segments[k].cargo.events_info.start_byte; 
+		segments[k].cargo = state; 
+		segments[k].cargo.events_info.start_byte = start_byte; 
+		segments[k].arr = arr + dim; 
+		dim += segments[k].dim; 
+		skip_evt3_segment(&state, &segments[k]); 
+	}
+
+	// Second pass: decoding the segments, if the array is large enough.
+	if (status == 0 && dim <= cargo->events_info.dim){
+		run_threads(decode_evt3_segment, segments, sizeof(*segments), 
+                    nsegments); 
+		for (k=0; k < nsegments; k++)
+			if (segments[k].status != 0)
+				status = segments[k].status; 
+		*cargo = state; 
+		cargo->events_info.start_byte = first_byte + num_words * word_size; 
+		cargo->events_info.finished = 1; 
+	}
+	cargo->events_info.dim = dim; 
+
+	for (k=0; k < nsegments; k++)
+		close_reader(segments[k].reader); 
+	free(segments); 
+	return status; 
+}
+
 DLLEXPORT int save_evt3(const char* fpath, 
                         event_t* arr, 
                         evt3_cargo_t* cargo, 
@@ -487,7 +1023,7 @@ DLLEXPORT size_t cut_evt3(  const char* fpath_in,
 	size_t values_read=0, j=0, i=0; 
 
 	// Temporary values to keep track of vectorized events_info.
-	uint64_t buff_tmp=0, k=0, num_vect_events=0; 
+	uint64_t buff_tmp=0, num_vect_events=0; 
 	// Masks to extract bits.
 	const uint16_t mask_8b = 0xFFU, mask_12b = 0xFFFU; 
 	// Flags to recognise event type and end of file.
@@ -524,11 +1060,7 @@ DLLEXPORT size_t cut_evt3(  const char* fpath_in,
 						num_vect_events = 8; 
 						buff_tmp = (uint64_t)(buff[j] & mask_8b);
 					}
-					for (k=0; k<num_vect_events; k++){
-						if (buff_tmp%2)
-							i++; 
-						buff_tmp = buff_tmp >> 1; 
-					}
+					i += count_bits((uint16_t)buff_tmp); 
 					num_vect_events = 0; 
 					if (recording_finished)
 						last_events_info_acquired = 1; 
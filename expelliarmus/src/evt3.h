@@ -5,6 +5,11 @@
 
 #include "events.h"
 #include "wizard.h"
+#include "reader.h"
+#include "output.h"
+#include "index.h"
+#include "filter.h"
+#include "frame.h"
 
 // EVT3 format constants.
 #define EVT3_EVT_ADDR_Y 0x0U
@@ -49,13 +54,13 @@ typedef struct {
  *  type event_t, so that the file is re-opened successively to fill the 
  *  externally allocated array. 
  *  The size of the external array to be allocated is written to 
- *  cargo->events_info.dim.
+ *  cargo->events_info.dim. If a filter is set in cargo->events_info.filter, 
+ *  only the events that pass it are counted.
  *
- *  @param[in]  fpath       The path to the input file.
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] cargo       The pointer to the information cargo structure.
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
  */
-DLLEXPORT void measure_evt3(const char*, evt3_cargo_t*, size_t);
+DLLEXPORT void measure_evt3(reader_t*, evt3_cargo_t*);
 
 /** Function that counts the number of events to be read in the time window 
  *  duration specified.
@@ -63,30 +68,196 @@ DLLEXPORT void measure_evt3(const char*, evt3_cargo_t*, size_t);
  *  type event_t, filled in a successive file reading. The file is read starting
  *  from the byte number stored in cargo->events_info.start_byte.
  *  The time window duration is read from cargo->events_info.time_window. 
- *  The size of the array to be allocated is saved to cargo->events_info.dim.
+ *  The size of the array to be allocated is saved to cargo->events_info.dim;
+ *  if a filter is set in cargo->events_info.filter, only the events that pass
+ *  it are counted.
  *
- *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] cargo       The pointer to the information cargo structure. 
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
  */
-DLLEXPORT void get_time_window_evt3(const char*, evt3_cargo_t*, size_t);
+DLLEXPORT void get_time_window_evt3(reader_t*, evt3_cargo_t*);
 
 /** Function that fills the array provided with the events from the binary file.
  *  arr is supposed to be an array of size cargo->events_info.dim and type
  *  event_t.
  *  When the entire file has been read, cargo->events_info.finished is set to 1.
+ *  If cargo->events_info.triggers is set, the external trigger events are 
+ *  appended to it, with the last timestamp decoded, and the decoding stops 
+ *  early when it is full.
  *
- *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  reader      The reader of the input file.
  *  @param[out] arr         The event array, passed as a pointer to event_t 
  *                          structures. Allocated externally.
  *  @param[in]  cargo       The pointer to the information cargo structure. 
- *  @param[in]  buff_size   The size of the buffer used to read the binary file.
  *
  *  @return     status      A flag that when different from 0, indicates that 
  *                          there has been some error while filling the input 
  *                          array or reading the file.
  */
-DLLEXPORT int read_evt3(const char*, event_t*, evt3_cargo_t*, size_t);
+DLLEXPORT int read_evt3(reader_t*, event_t*, evt3_cargo_t*);
+
+/** Function that fills the columns provided with the events from the binary 
+ *  file in the layout set in columns->layout (LAYOUT_SOA, LAYOUT_COMPACT or 
+ *  LAYOUT_PACKED, see "output.h"). The events are decoded by read_evt3() to a
+ *  staging array and then narrowed to the columns.
+ *  The columns are supposed to have size cargo->events_info.dim plus 
+ *  STAGING_SLACK elements, since the last vector event decoded is written 
+ *  entirely.
+ *  When the entire file has been read, cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] columns     The pointer to the output arrays. Allocated 
+ *                          externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while filling the 
+ *                          columns or reading the file.
+ */
+DLLEXPORT int read_evt3_columns(reader_t*, columns_t*, evt3_cargo_t*);
+
+/** Function that fills the frames provided with the events from the binary 
+ *  file (see "frame.h"). The events are decoded by read_evt3() to a staging 
+ *  array and scattered to the frames, without being stored.
+ *  When the entire file has been read, cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure. The frames 
+ *                          are allocated externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_evt3_frames(reader_t*, frames_t*, evt3_cargo_t*);
+
+/** Function that fills the frames provided as read_evt3_frames(), splitting
+ *  them among nsegments threads (see read_frames_parallel() in "frame.h").
+ *  The k-th run of frames is decoded from cargos[k], that must precede its 
+ *  first event; on return, cargos[0] holds the state following the frames.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure. The frames 
+ *                          are allocated externally.
+ *  @param[in]  cargos      The array of information cargo structures.
+ *  @param[in]  nsegments   The number of runs of frames, one for each thread.
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_evt3_frames_parallel(reader_t*, frames_t*, 
+                                        evt3_cargo_t*, size_t);
+
+/** Function that counts the events of each pixel of the binary file, from 
+ *  the state stored in cargo to the file end, ignoring the filter (see 
+ *  count_pixels() in "filter.h"). Used to find the hot pixels of the sensor.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] counts      The counts of the pixels, of size width*height. 
+ *                          Allocated externally.
+ *  @param[in]  width       The width of counts.
+ *  @param[in]  height      The height of counts.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int profile_evt3(reader_t*, uint32_t*, size_t, size_t, 
+                           evt3_cargo_t*);
+
+/** Function that adds to the index provided the resume points of the binary 
+ *  file, from the state stored in cargo; see build_index() in "index.h".
+ *  Each entry is followed by a copy of the cargo at that point, that can be 
+ *  passed to read_evt3() to decode the file from there.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] index       The pointer to the index being built.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int index_evt3(reader_t*, index_t*, evt3_cargo_t*);
+
+/** Function that fills the array provided with the events of a range, from 
+ *  the state stored in cargo (e.g. an index entry); see read_range() in 
+ *  "index.h". The events outside of the range are dropped while decoding.
+ *  arr is supposed to have size cargo->events_info.dim plus STAGING_SLACK; 
+ *  the number of events written is saved to cargo->events_info.dim.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] arr         The event array, passed as a pointer to event_t 
+ *                          structures. Allocated externally.
+ *  @param[in]  range       The pointer to the range structure.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while reading the file.
+ */
+DLLEXPORT int read_evt3_range(reader_t*, event_t*, range_t*, evt3_cargo_t*);
+
+/** Function that writes the events with a timestamp in [t_start, t_end) to 
+ *  a new file, without decoding most of them: the cargos are moved to the 
+ *  first event of the span and past its last one by locate_time(), and the 
+ *  bytes in between are copied after the header and the TIME_HIGH, TIME_LOW,
+ *  ADDR_Y and VECT_BASE_X words restoring the decoder state (see 
+ *  write_span()). The overflow counts of the timestamp cannot be encoded, so 
+ *  the timestamps of a span following them are decoded shifted back by a 
+ *  multiple of 4096 us.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[in]  fpath_out   Path to the output file.
+ *  @param[in]  start       The cargo preceding the first event of the span
+ *                          (e.g. an index entry). 
+ *  @param[in]  end         The cargo preceding the first event after the 
+ *                          span.
+ *  @param[in]  t_start     The first timestamp of the span [us].
+ *  @param[in]  t_end       The timestamp ending the span, excluded [us].
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while cutting the file.
+ */
+DLLEXPORT int cut_evt3_span(reader_t*, const char*, evt3_cargo_t*, 
+                            evt3_cargo_t*, timestamp_t, timestamp_t);
+
+/** Function that splits the binary file in clips of split->duration 
+ *  microseconds in a single pass, writing each one to a file of 
+ *  split->fpaths that can be decoded on its own (see split_file()). The overflow 
+ *  counts of the timestamp cannot be encoded, so the timestamps of the clips
+ *  following them are decoded shifted back by a multiple of 4096 us.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] split       The state of the split.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while splitting the file.
+ */
+DLLEXPORT int split_evt3(reader_t*, split_t*, evt3_cargo_t*);
+
+/** Function that fills the array provided with all the events in the binary 
+ *  file, splitting the file among many threads. Each thread counts the events
+ *  in its segment and records the last TIME_HIGH, TIME_LOW, ADDR_Y and 
+ *  VECT_BASE_X words in it, so that the decoder state at the beginning of each
+ *  segment can be reconstructed; then, each segment is decoded in parallel to
+ *  its slice of the array.
+ *  arr is supposed to be an array of size cargo->events_info.dim; if it is too
+ *  small, nothing is decoded and the number of events needed is written to
+ *  cargo->events_info.dim, with cargo->events_info.finished left to 0. 
+ *  Otherwise, the number of events read is written to cargo->events_info.dim
+ *  and cargo->events_info.finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] arr         The event array, passed as a pointer to event_t 
+ *                          structures. Allocated externally.
+ *  @param[in]  cargo       The pointer to the information cargo structure. 
+ *  @param[in]  nthreads    The number of threads used.
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while filling the input 
+ *                          array or reading the file.
+ */
+DLLEXPORT int read_evt3_parallel(reader_t*, event_t*, evt3_cargo_t*, size_t);
 
 /** Function that writes to a binary file the array provided in input using 
  *  EVT3 encoding.
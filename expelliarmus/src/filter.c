@@ -0,0 +1,169 @@
+#include "filter.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd.h"
+
+size_t filter_events(const filter_t* filter, event_t* arr, size_t n){
+	size_t kept=0; 
+	for (size_t k=0; k < n; k++){
+		if (filter_event(filter, arr + k))
+			arr[kept++] = arr[k]; 
+	}
+	return kept; 
+}
+
+uint16_t filter_vector(const filter_t* filter, 
+                       int base_x, 
+                       address_t y, 
+                       polarity_t p, 
+                       uint16_t mask, 
+                       uint8_t width){
+	if (!((filter->p_mask >> (p & 0xFU)) & 0x1U))
+		return 0; 
+	// Union of the bits of the X ranges of the boxes holding the Y address.
+	uint32_t keep = (filter->num_boxes == 0) ? 0xFFFFU : 0; 
+	int lo=0, hi=0; 
+	for (size_t k=0; k < filter->num_boxes; k++){
+		if (y < filter->boxes[k].y_min || y >= filter->boxes[k].y_max)
+			continue; 
+		lo = filter->boxes[k].x_min - base_x; 
+		hi = filter->boxes[k].x_max - base_x; 
+		lo = lo < 0 ? 0 : lo; 
+		hi = hi > width ? width : hi; 
+		if (lo < hi)
+			keep |= ((1U << hi) - 1U) & ~((1U << lo) - 1U); 
+	}
+	mask = (uint16_t) (mask & keep); 
+	if (filter->hot_pixels != NULL){
+		for (uint16_t bits=mask; bits != 0; bits &= (uint16_t) (bits - 1)){
+			lo = lowest_bit(bits); 
+			if (is_hot_pixel(filter, base_x + lo, y))
+				mask &= (uint16_t) ~(1U << lo); 
+		}
+	}
+	return mask; 
+}
+
+int count_filtered(reader_t* reader, 
+                   read_fn_t read_fn, 
+                   void* cargo, 
+                   size_t cargo_size, 
+                   event_cargo_t* events_info, 
+                   timestamp_t time_window){
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+	void* saved = malloc(cargo_size); 
+	if (saved == NULL){
+		free(staging); 
+		CHECK_BUFF_ALLOCATION(saved); 
+	}
+	memcpy(saved, cargo, cargo_size); 
+	// The refractory and background activity states are changed by the 
+	// events decoded.
+	const filter_t* filter = events_info->filter; 
+	timestamp_t* saved_t = NULL; 
+	timestamp_t* saved_support = NULL; 
+	size_t state_size = 0, support_size = 0; 
+	if (filter != NULL && filter->refractory > 0 && filter->last_t != NULL)
+		state_size = filter->width * filter->height * 2 * sizeof(timestamp_t); 
+	if (filter != NULL && filter->background > 0 && filter->support_t != NULL)
+		support_size = filter->width * filter->height * sizeof(timestamp_t); 
+	if (state_size > 0 || support_size > 0){
+		saved_t = (timestamp_t*) malloc(state_size + support_size); 
+		if (saved_t == NULL){
+			free(saved); 
+			free(staging); 
+			CHECK_BUFF_ALLOCATION(saved_t); 
+		}
+		saved_support = saved_t + state_size / sizeof(timestamp_t); 
+		if (state_size > 0)
+			memcpy(saved_t, filter->last_t, state_size); 
+		if (support_size > 0)
+			memcpy(saved_support, filter->support_t, support_size); 
+	}
+
+	// The trigger events are collected when the events are read.
+	triggers_t* triggers = events_info->triggers; 
+	events_info->triggers = NULL; 
+
+	timestamp_t first_t=0; 
+	size_t k=0, n=STAGING_SIZE, dim=0; 
+	uint8_t first_run=1, window_over=0; 
+	int status=0; 
+	while (status == 0 && !window_over && n == STAGING_SIZE){
+		events_info->dim = STAGING_SIZE; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		for (k=0; k < n && !window_over; k++){
+			if (first_run){
+				first_t = staging[k].t; 
+				first_run = 0; 
+			}
+			dim++; 
+			window_over = time_window > 0 && 
+                          staging[k].t - first_t >= time_window; 
+		}
+		// EVT3 vectors can exceed the block.
+		n = n > STAGING_SIZE ? STAGING_SIZE : n; 
+	}
+	// A block shorter than requested means that the file is over.
+	memcpy(cargo, saved, cargo_size); 
+	events_info->triggers = triggers; 
+	if (saved_t != NULL){
+		if (state_size > 0)
+			memcpy(filter->last_t, saved_t, state_size); 
+		if (support_size > 0)
+			memcpy(filter->support_t, saved_support, support_size); 
+		free(saved_t); 
+	}
+	events_info->dim = dim; 
+	if (!window_over && n < STAGING_SIZE)
+		events_info->finished = 1; 
+	free(saved); 
+	free(staging); 
+	return status; 
+}
+
+int count_pixels(reader_t* reader, 
+                 uint32_t* counts, 
+                 size_t width, 
+                 size_t height, 
+                 read_fn_t read_fn, 
+                 void* cargo, 
+                 event_cargo_t* events_info){
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+
+	// The events are counted before being filtered.
+	const filter_t* filter = events_info->filter; 
+	triggers_t* triggers = events_info->triggers; 
+	events_info->filter = NULL; 
+	events_info->triggers = NULL; 
+
+	size_t k=0, n=STAGING_SIZE; 
+	int status=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	while (status == 0 && n == STAGING_SIZE){
+		events_info->dim = STAGING_SIZE; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		for (k=0; k < n; k++){
+			if (staging[k].x >= 0 && staging[k].y >= 0 && 
+                (size_t) staging[k].x < width && 
+                (size_t) staging[k].y < height)
+				counts[(size_t) staging[k].y * width + 
+                       (size_t) staging[k].x]++; 
+		}
+		// EVT3 vectors can exceed the block.
+		n = n > STAGING_SIZE ? STAGING_SIZE : n; 
+	}
+	events_info->filter = filter; 
+	events_info->triggers = triggers; 
+	free(staging); 
+	return status; 
+}
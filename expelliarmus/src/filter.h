@@ -0,0 +1,304 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+/** Library for the event filters.
+ *  A filter is attached to the cargo of a decoder (events_info.filter), so 
+ *  that the events outside of the regions of interest, with an unwanted 
+ *  polarity or of a hot pixel are dropped while decoding, before they reach
+ *  the output array, and the measure_<encoding>() and 
+ *  get_time_window_<encoding>() functions count only the events that pass it.
+ *  The events kept can be transformed as well: the addresses are downscaled,
+ *  the timestamps quantized and the events following too closely another one
+ *  of the same pixel and polarity, after the transforms, are dropped, as well
+ *  as the ones without a recent event in the neighbouring pixels (background
+ *  activity).
+ */
+
+#include <stdint.h>
+#include "events.h"
+#include "wizard.h"
+#include "reader.h"
+#include "output.h"
+
+/** Structure of a region of interest, a rectangle of pixels.
+ *
+ *  @field  x_min   The first X address in the region.
+ *  @field  x_max   The X address ending the region (excluded).
+ *  @field  y_min   The first Y address in the region.
+ *  @field  y_max   The Y address ending the region (excluded).
+ */
+typedef struct {
+	address_t x_min; 
+	address_t x_max; 
+	address_t y_min; 
+	address_t y_max; 
+} box_t; 
+
+/** Structure of a filter. An event passes it if the bit of its polarity is 
+ *  set in p_mask, its pixel is not marked in hot_pixels and it lies in at 
+ *  least one of the boxes, if any. The boxes and hot_pixels are expressed in
+ *  the addresses of the sensor, before the downscale.
+ *
+ *  @field  p_mask      The polarities kept: bit p is set to keep polarity p.
+ *  @field  num_boxes   The number of boxes; 0 to keep all the pixels.
+ *  @field  boxes       The regions of interest. Allocated externally.
+ *  @field  hot_pixels  The bit mask of the pixels whose events are dropped:
+ *                      bit y*mask_width + x, counting from the lowest bit of
+ *                      the first byte, marks the pixel (x, y). NULL to keep
+ *                      all the pixels. Allocated externally.
+ *  @field  mask_width  The width of hot_pixels; the pixels out of it are kept.
+ *  @field  mask_height The height of hot_pixels; the pixels out of it are 
+ *                      kept.
+ *  @field  scale       The factor dividing the addresses; 0 or 1 to keep them.
+ *  @field  t_bin       The width of the bins the timestamps are floored to;
+ *                      0 or 1 to keep them.
+ *  @field  refractory  The period [us] following an event kept in which the 
+ *                      events of the same pixel and polarity are dropped, 
+ *                      measured on the transformed events: 1 drops only the 
+ *                      duplicates. 0 to keep all of them.
+ *  @field  background  The period [us] preceding an event in which at least 
+ *                      one of the 8 neighbouring pixels must have had an 
+ *                      event, for it to be kept; measured on the transformed
+ *                      events that pass the rest of the filter. 0 to keep all
+ *                      of them.
+ *  @field  width       The width of the downscaled sensor, used to index 
+ *                      last_t and support_t.
+ *  @field  height      The height of the downscaled sensor, used to index 
+ *                      last_t and support_t.
+ *  @field  last_t      The timestamp of the last event kept for each pixel 
+ *                      and polarity, at (y*width + x)*2 + (p & 1), used by the
+ *                      refractory filter; INT64_MIN when no event has been 
+ *                      kept. Allocated externally. The events out of the 
+ *                      sensor are not filtered.
+ *  @field  support_t   The timestamp of the last event of the neighbours of 
+ *                      each pixel, at y*width + x, used by the background
+ *                      activity filter; INT64_MIN when no neighbour has had
+ *                      an event. Allocated externally. The events out of the
+ *                      sensor are not filtered.
+ */
+typedef struct filter_s {
+	uint16_t p_mask; 
+	size_t num_boxes; 
+	const box_t* boxes; 
+	const uint8_t* hot_pixels; 
+	size_t mask_width; 
+	size_t mask_height; 
+	uint16_t scale; 
+	timestamp_t t_bin; 
+	timestamp_t refractory; 
+	timestamp_t background; 
+	size_t width; 
+	size_t height; 
+	timestamp_t* last_t; 
+	timestamp_t* support_t; 
+} filter_t; 
+
+/** Function that checks whether a pixel is marked in the hot pixels mask of 
+ *  the filter.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[in]  x           The X address of the pixel.
+ *  @param[in]  y           The Y address of the pixel.
+ *
+ *  @return     hot         1 if the events of the pixel are dropped, 0 
+ *                          otherwise.
+ */
+static inline int is_hot_pixel(const filter_t* filter, int x, int y){
+	if (filter->hot_pixels == NULL || x < 0 || y < 0 || 
+        (size_t) x >= filter->mask_width || (size_t) y >= filter->mask_height)
+		return 0; 
+	const size_t pixel = (size_t) y * filter->mask_width + (size_t) x; 
+	return (filter->hot_pixels[pixel >> 3] >> (pixel & 0x7U)) & 0x1U; 
+}
+
+/** Function that checks whether an event is selected by the polarity mask, 
+ *  the hot pixels mask and the boxes of the filter.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[in]  event       The event.
+ *
+ *  @return     pass        1 if the event is selected, 0 otherwise.
+ */
+static inline int select_event(const filter_t* filter, const event_t* event){
+	if (!((filter->p_mask >> (event->p & 0xFU)) & 0x1U))
+		return 0; 
+	if (is_hot_pixel(filter, event->x, event->y))
+		return 0; 
+	if (filter->num_boxes == 0)
+		return 1; 
+	for (size_t k=0; k < filter->num_boxes; k++){
+		if (event->x >= filter->boxes[k].x_min && 
+            event->x < filter->boxes[k].x_max && 
+            event->y >= filter->boxes[k].y_min && 
+            event->y < filter->boxes[k].y_max)
+			return 1; 
+	}
+	return 0; 
+}
+
+/** Function that checks whether the filter transforms the events.
+ *
+ *  @param[in]  filter      The filter.
+ *
+ *  @return     transform   1 if the events are transformed, 0 otherwise.
+ */
+static inline int has_transform(const filter_t* filter){
+	return filter->scale > 1 || filter->t_bin > 1 || filter->refractory > 0 || 
+           filter->background > 0; 
+}
+
+/** Function that applies the background activity filter to an event, which
+ *  is kept if a neighbouring pixel has had an event in the previous 
+ *  filter->background microseconds. The event supports its neighbours in 
+ *  turn, whether it is kept or not.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[in]  event       The event, already transformed.
+ *
+ *  @return     pass        1 if the event is kept, 0 otherwise.
+ */
+static inline int check_support(const filter_t* filter, const event_t* event){
+	if (filter->background <= 0 || filter->support_t == NULL || 
+        event->x < 0 || event->y < 0 || 
+        (size_t) event->x >= filter->width || 
+        (size_t) event->y >= filter->height)
+		return 1; 
+	const size_t x = (size_t) event->x, y = (size_t) event->y; 
+	const size_t width = filter->width; 
+	timestamp_t* support_t = filter->support_t; 
+	const int pass = support_t[y*width + x] >= event->t - filter->background; 
+	const size_t x_min = x > 0 ? x-1 : 0, y_min = y > 0 ? y-1 : 0; 
+	const size_t x_max = x+1 < width ? x+1 : x; 
+	const size_t y_max = y+1 < filter->height ? y+1 : y; 
+	for (size_t j=y_min; j <= y_max; j++){
+		for (size_t i=x_min; i <= x_max; i++){
+			if (i != x || j != y)
+				support_t[j*width + i] = event->t; 
+		}
+	}
+	return pass; 
+}
+
+/** Function that downscales the addresses and quantizes the timestamp of an
+ *  event, then applies the refractory and background activity filters to it.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[out] event       The event, transformed in place.
+ *
+ *  @return     pass        1 if the event is kept, 0 otherwise.
+ */
+static inline int transform_event(const filter_t* filter, event_t* event){
+	if (filter->scale > 1){
+		event->x = (address_t) (event->x / filter->scale); 
+		event->y = (address_t) (event->y / filter->scale); 
+	}
+	if (filter->t_bin > 1){
+		timestamp_t rem = event->t % filter->t_bin; 
+		event->t -= rem < 0 ? rem + filter->t_bin : rem; 
+	}
+	if (filter->refractory <= 0 || filter->last_t == NULL || event->x < 0 || 
+        event->y < 0 || (size_t) event->x >= filter->width || 
+        (size_t) event->y >= filter->height)
+		return check_support(filter, event); 
+	timestamp_t* last_t = filter->last_t + 
+        (((size_t) event->y * filter->width + (size_t) event->x) << 1) + 
+        (event->p & 0x1U); 
+	if (event->t < *last_t + filter->refractory)
+		return 0; 
+	*last_t = event->t; 
+	return check_support(filter, event); 
+}
+
+/** Function that checks whether an event passes the filter, transforming it
+ *  if it does.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[out] event       The event, transformed in place if kept.
+ *
+ *  @return     pass        1 if the event is kept, 0 otherwise.
+ */
+static inline int filter_event(const filter_t* filter, event_t* event){
+	if (!select_event(filter, event))
+		return 0; 
+	return has_transform(filter) ? transform_event(filter, event) : 1; 
+}
+
+/** Function that drops the events not passing the filter from an array, 
+ *  moving the kept ones to its beginning.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[out] arr         The events, filtered in place.
+ *  @param[in]  n           The number of events in arr.
+ *
+ *  @return     kept        The number of events kept.
+ */
+size_t filter_events(const filter_t*, event_t*, size_t); 
+
+/** Function that drops from the mask of a vector word (EVT3) the events not 
+ *  selected by the filter, before they are expanded: the events of a vector 
+ *  share Y address and polarity, and bit k of the mask is the event at 
+ *  X address base_x + k. The events expanded still need to be transformed.
+ *
+ *  @param[in]  filter      The filter.
+ *  @param[in]  base_x      The X address of the lowest bit of the mask.
+ *  @param[in]  y           The Y address of the events.
+ *  @param[in]  p           The polarity of the events.
+ *  @param[in]  mask        The mask of the vector word.
+ *  @param[in]  width       The number of bits of the mask.
+ *
+ *  @return     mask        The mask of the events kept.
+ */
+uint16_t filter_vector(const filter_t*, int, address_t, polarity_t, uint16_t, 
+                       uint8_t); 
+
+/** Function that counts the events passing the filter in the cargo, 
+ *  decoding the file with a read_<encoding>() function through a staging 
+ *  array. Used by the measure_<encoding>() and get_time_window_<encoding>() 
+ *  functions when a filter is set, in place of the word counting. 
+ *  If time_window is larger than 0, the count stops at the first event whose
+ *  distance from the first one is at least time_window, included, as 
+ *  get_time_window_<encoding>() does. The cargo and the refractory and 
+ *  background activity states of the filter are left as they were, except 
+ *  for events_info->dim, where the count is saved, and 
+ *  events_info->finished, that is set to 1 if the file end is reached.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  cargo_size  The size in bytes of the cargo structure.
+ *  @param[in]  events_info The events information in the cargo.
+ *  @param[in]  time_window The duration of the time window [us]; 0 to count 
+ *                          the events up to the file end.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int count_filtered(reader_t*, read_fn_t, void*, size_t, event_cargo_t*, 
+                   timestamp_t); 
+
+/** Function that counts the events of each pixel, of both polarities, from 
+ *  the state stored in cargo to the file end, decoding the file with a 
+ *  read_<encoding>() function through a staging array, as count_filtered()
+ *  does. The filter and the trigger events array of the cargo are ignored, 
+ *  so that the counts are in the addresses of the sensor. Used to find the 
+ *  hot pixels.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] counts      The number of events of the pixel (x, y) is added
+ *                          to counts[y*width + x]; the events out of the 
+ *                          array are not counted. Allocated externally.
+ *  @param[in]  width       The width of counts.
+ *  @param[in]  height      The height of counts.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int count_pixels(reader_t*, uint32_t*, size_t, size_t, read_fn_t, void*, 
+                 event_cargo_t*); 
+
+#endif
@@ -0,0 +1,392 @@
+#include "frame.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "index.h"
+#include "threads.h"
+
+/** Function that returns the number of channels of a frame.
+ */
+static size_t get_channels(const frames_t* frames){
+	switch (frames->mode){
+		case FRAME_SIGNED:
+			return 1; 
+		case FRAME_VOXEL:
+			return frames->bins; 
+		default:
+			return 2; 
+	}
+}
+
+/** Function that returns the size of a frame in bytes.
+ */
+static size_t get_frame_bytes(const frames_t* frames){
+	const size_t value_size = (frames->mode >= FRAME_VOXEL) ? 
+                              sizeof(frame_float_t) : sizeof(frame_value_t); 
+	return get_channels(frames) * frames->width * frames->height * value_size; 
+}
+
+/** Function that checks that the frames settings are consistent.
+ */
+static int check_frames(const frames_t* frames){
+	if (frames->mode > FRAME_SURFACE){
+		fprintf(stderr, "ERROR: the frame mode is not supported.\n"); 
+		return -1; 
+	}
+	if (frames->time_window <= 0 && frames->event_count == 0){
+		fprintf(stderr, "ERROR: the frame duration is not set.\n"); 
+		return -1; 
+	}
+	if (frames->mode == FRAME_VOXEL && 
+        (frames->time_window <= 0 || frames->bins == 0)){
+		fprintf(stderr, "ERROR: the voxel grids require a time window and at "
+                        "least one bin.\n"); 
+		return -1; 
+	}
+	if (frames->mode == FRAME_SURFACE && 
+        (frames->tau <= 0 || frames->last_t == NULL)){
+		fprintf(stderr, "ERROR: the time surfaces require a positive decay "
+                        "constant and the last timestamps of the pixels.\n"); 
+		return -1; 
+	}
+	return 0; 
+}
+
+/** Function that returns the value of a time surface for an event that 
+ *  occurred dt microseconds before. 
+ */
+static inline frame_float_t decay(timestamp_t dt, double inv_tau){
+	return (frame_float_t) exp(-(double) dt * inv_tau); 
+}
+
+/** Function that opens the k-th frame, zeroing it.
+ */
+static uint8_t* open_frame(frames_t* frames, size_t k, timestamp_t t){
+	const size_t frame_bytes = get_frame_bytes(frames); 
+	uint8_t* frame = (uint8_t*) frames->arr + k*frame_bytes; 
+	memset(frame, 0, frame_bytes); 
+	frames->t_start[k] = t; 
+	return frame; 
+}
+
+/** Function that closes a frame, writing its time surface at t_end.
+ */
+static void close_frame(const frames_t* frames, 
+                        uint8_t* frame, 
+                        timestamp_t t_end){
+	if (frames->mode != FRAME_SURFACE)
+		return; 
+	frame_float_t* surface = (frame_float_t*) frame; 
+	const size_t size = 2 * frames->width * frames->height; 
+	const double inv_tau = 1.0 / frames->tau; 
+	size_t i; 
+	for (i=0; i < size; i++){
+		if (frames->last_t[i] != INT64_MIN)
+			surface[i] = decay(t_end - frames->last_t[i], inv_tau); 
+	}
+}
+
+/** Function that adds an event to a frame starting at t_start.
+ */
+static inline void scatter_event(const frames_t* frames, 
+                                 uint8_t* frame, 
+                                 timestamp_t t_start, 
+                                 const event_t* event){
+	if (event->x < 0 || event->y < 0 ||
+        (size_t) event->x >= frames->width ||
+        (size_t) event->y >= frames->height)
+		return; 
+	const size_t pixel = (size_t) event->y * frames->width + (size_t) event->x; 
+	const size_t plane = frames->width * frames->height; 
+	frame_value_t* values = (frame_value_t*) frame; 
+	frame_float_t* voxels = (frame_float_t*) frame; 
+	double pos=0; 
+	size_t bin=0; 
+	frame_float_t weight=0, sign=0; 
+	switch (frames->mode){
+		case FRAME_COUNT:
+			values[(event->p & 0x1U) * plane + pixel]++; 
+			break; 
+		case FRAME_BINARY:
+			values[(event->p & 0x1U) * plane + pixel] = 1; 
+			break; 
+		case FRAME_SIGNED:
+			values[pixel] += (event->p & 0x1U) ? 1 : -1; 
+			break; 
+		case FRAME_VOXEL:
+			// Position of the event among the bins, in [0, bins-1). The 
+			// timestamps are not necessarily monotonic, so that an event 
+			// older than the frame is clamped to the first bin.
+			pos = (double) (event->t - t_start) * (double) (frames->bins - 1) / 
+                  (double) frames->time_window; 
+			if (pos < 0)
+				pos = 0; 
+			else if (pos > (double) (frames->bins - 1))
+				pos = (double) (frames->bins - 1); 
+			bin = (size_t) pos; 
+			weight = (frame_float_t) (pos - (double) bin); 
+			sign = (event->p & 0x1U) ? 1 : -1; 
+			voxels[bin * plane + pixel] += sign * (1 - weight); 
+			if (weight > 0)
+				voxels[(bin + 1) * plane + pixel] += sign * weight; 
+			break; 
+		default:
+			frames->last_t[(event->p & 0x1U) * plane + pixel] = event->t; 
+	}
+}
+
+int read_frames(reader_t* reader, 
+                frames_t* frames, 
+                read_fn_t read_fn, 
+                void* cargo, 
+                size_t cargo_size, 
+                event_cargo_t* events_info){
+	if (check_frames(frames) != 0)
+		return -1; 
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+	void* saved = malloc(cargo_size); 
+	if (saved == NULL){
+		free(staging); 
+		CHECK_BUFF_ALLOCATION(saved); 
+	}
+
+	const uint8_t by_time = frames->time_window > 0; 
+	size_t k=0, n=0, block=0, num=0, count=0, dim=frames->dim; 
+	uint8_t* frame = NULL; 
+	// End of the time window of the open frame, and last timestamp read.
+	timestamp_t t_end=0, t_last=0; 
+	uint8_t full=0; 
+	int status=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	// The frame following the last one filled is opened even if it has no 
+	// events, since its time window is known.
+	if (by_time && frames->has_t_next && dim > 0){
+		frame = open_frame(frames, 0, frames->t_next); 
+		t_end = frames->t_next + frames->time_window; 
+	}
+	while (status == 0 && !full && num < dim){
+		memcpy(saved, cargo, cargo_size); 
+		// A frame of event_count events is read at most up to its end.
+		block = (by_time || frames->event_count - count > STAGING_SIZE) ? 
+                STAGING_SIZE : frames->event_count - count; 
+		events_info->dim = block; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		for (k=0; k < n; k++){
+			if (frame == NULL){
+				frame = open_frame(frames, num, staging[k].t); 
+				t_end = staging[k].t + frames->time_window; 
+			}
+			// The frames without events are left empty.
+			while (by_time && staging[k].t >= t_end && !full){
+				close_frame(frames, frame, t_end); 
+				if (++num == dim){
+					full = 1; 
+					break; 
+				}
+				frame = open_frame(frames, num, t_end); 
+				t_end += frames->time_window; 
+				count = 0; 
+			}
+			if (full)
+				break; 
+			scatter_event(frames, frame, frames->t_start[num], staging + k); 
+			t_last = staging[k].t; 
+			count++; 
+		}
+		if (full){
+			// The block is decoded again up to the last event of the frames.
+			// EVT3 vectors do not exceed it, since their events share the 
+			// timestamp.
+			memcpy(cargo, saved, cargo_size); 
+			if (k > 0){
+				events_info->dim = k; 
+				status = read_fn(reader, staging, cargo); 
+			}
+			frames->t_next = t_end; 
+			frames->has_t_next = 1; 
+			break; 
+		}
+		if (!by_time && count >= frames->event_count){
+			close_frame(frames, frame, t_last); 
+			num++; 
+			frame = NULL; 
+			count = 0; 
+		}
+		// A block shorter than requested means that the file is over.
+		if (n < block){
+			if (frame != NULL && count > 0){
+				close_frame(frames, frame, by_time ? t_end : t_last); 
+				num++; 
+			}
+			break; 
+		}
+	}
+	frames->dim = num; 
+	free(saved); 
+	free(staging); 
+	return status; 
+}
+
+/** Structure holding the run of frames filled by a thread in 
+ *  read_frames_parallel().
+ *
+ *  @field  reader      The reader of the thread.
+ *  @field  cargo       The decoder state, preceding the first event of the run.
+ *  @field  cargo_size  The size in bytes of the cargo structure.
+ *  @field  read_fn     The function decoding the events.
+ *  @field  frames      The frames of the run, starting at frames.t_next.
+ *  @field  prior_t     The last timestamp of each pixel before the run, used
+ *                      to complete the time surfaces.
+ *  @field  status      A flag that when different from 0, indicates that 
+ *                      there has been some error in the run.
+ */
+typedef struct {
+	reader_t* reader; 
+	void* cargo; 
+	size_t cargo_size; 
+	read_fn_t read_fn; 
+	frames_t frames; 
+	const timestamp_t* prior_t; 
+	int status; 
+} frames_segment_t; 
+
+/** Function that moves the cargo to the beginning of a run and fills its 
+ *  frames. Executed by each thread in the first pass of 
+ *  read_frames_parallel().
+ *
+ *  @param[in]  arg     Pointer to the frames_segment_t structure.
+ */
+static void* fill_frames_segment(void* arg){
+	frames_segment_t* segment = (frames_segment_t*) arg; 
+	event_cargo_t* events_info = (event_cargo_t*) segment->cargo; 
+	segment->status = locate_time(segment->reader, segment->read_fn, 
+                                  segment->cargo, segment->cargo_size, 
+                                  events_info, segment->frames.t_next); 
+	if (segment->status == 0)
+		segment->status = read_frames(segment->reader, &segment->frames, 
+                                      segment->read_fn, segment->cargo, 
+                                      segment->cargo_size, events_info); 
+	return NULL; 
+}
+
+/** Function that completes the time surfaces of a run with the pixels whose 
+ *  last event precedes it. Executed by each thread but the first one in the 
+ *  second pass of read_frames_parallel().
+ *
+ *  @param[in]  arg     Pointer to the frames_segment_t structure.
+ */
+static void* complete_frames_segment(void* arg){
+	frames_segment_t* segment = (frames_segment_t*) arg; 
+	const frames_t* frames = &segment->frames; 
+	const size_t size = 2 * frames->width * frames->height; 
+	const double inv_tau = 1.0 / frames->tau; 
+	frame_float_t* surface = NULL; 
+	timestamp_t t_end=0; 
+	size_t i=0, k=0; 
+	for (k=0; k < frames->dim; k++){
+		surface = (frame_float_t*) frames->arr + k*size; 
+		t_end = frames->t_start[k] + frames->time_window; 
+		// A pixel with an event in the run has a more recent timestamp, 
+		// hence a larger value, unless both underflow to 0.
+		for (i=0; i < size; i++){
+			if (surface[i] == 0 && segment->prior_t[i] != INT64_MIN)
+				surface[i] = decay(t_end - segment->prior_t[i], inv_tau); 
+		}
+	}
+	return NULL; 
+}
+
+int read_frames_parallel(reader_t* reader, 
+                         frames_t* frames, 
+                         read_fn_t read_fn, 
+                         void* cargos, 
+                         size_t cargo_size, 
+                         size_t nsegments){
+	if (nsegments <= 1 || nsegments > frames->dim || 
+        frames->time_window <= 0 || !frames->has_t_next)
+		return read_frames(reader, frames, read_fn, cargos, cargo_size, 
+                           (event_cargo_t*) cargos); 
+	if (check_frames(frames) != 0)
+		return -1; 
+	frames_segment_t* segments = (frames_segment_t*) calloc(nsegments, 
+                                                    sizeof(frames_segment_t)); 
+	CHECK_BUFF_ALLOCATION(segments); 
+
+	const size_t frame_bytes = get_frame_bytes(frames); 
+	const size_t size = 2 * frames->width * frames->height; 
+	const uint8_t is_surface = frames->mode == FRAME_SURFACE; 
+	size_t i=0, k=0, first=0, dim=0; 
+	int status=0; 
+	for (k=0; k < nsegments; k++){
+		first = frames->dim * k / nsegments; 
+		segments[k].cargo = (uint8_t*) cargos + k*cargo_size; 
+		segments[k].cargo_size = cargo_size; 
+		segments[k].read_fn = read_fn; 
+		segments[k].frames = *frames; 
+		segments[k].frames.arr = (uint8_t*) frames->arr + first*frame_bytes; 
+		segments[k].frames.t_start = frames->t_start + first; 
+		segments[k].frames.dim = frames->dim * (k+1) / nsegments - first; 
+		segments[k].frames.t_next = frames->t_next + 
+                                    (timestamp_t) first * frames->time_window; 
+		segments[k].reader = (k == 0) ? reader : reader_clone(reader); 
+		if (segments[k].reader == NULL)
+			status = -1; 
+		// The runs following the first one start without the events that 
+		// precede them.
+		if (k > 0 && is_surface){
+			segments[k].frames.last_t = (timestamp_t*) malloc(size * 
+                                                    sizeof(timestamp_t)); 
+			if (segments[k].frames.last_t == NULL)
+				status = -1; 
+			for (i=0; status == 0 && i < size; i++)
+				segments[k].frames.last_t[i] = INT64_MIN; 
+		}
+	}
+
+	// First pass: filling the runs of frames.
+	if (status == 0)
+		run_threads(fill_frames_segment, segments, sizeof(*segments), 
+                    nsegments); 
+	for (k=0; status == 0 && k < nsegments; k++){
+		status = segments[k].status; 
+		dim += segments[k].frames.dim; 
+	}
+
+	// Second pass: propagating the last timestamps of the pixels through the
+	// runs, and completing the time surfaces with them.
+	if (status == 0 && is_surface){
+		for (k=1; k < nsegments; k++){
+			segments[k].prior_t = segments[k-1].frames.last_t; 
+			for (i=0; i < size; i++){
+				if (segments[k].frames.last_t[i] == INT64_MIN)
+					segments[k].frames.last_t[i] = segments[k].prior_t[i]; 
+			}
+		}
+		run_threads(complete_frames_segment, segments + 1, sizeof(*segments), 
+                    nsegments - 1); 
+		memcpy(frames->last_t, segments[nsegments-1].frames.last_t, 
+               size * sizeof(timestamp_t)); 
+	}
+
+	// The last run holds the state following the frames.
+	if (status == 0){
+		memcpy(cargos, segments[nsegments-1].cargo, cargo_size); 
+		frames->t_next = segments[nsegments-1].frames.t_next; 
+		frames->has_t_next = segments[nsegments-1].frames.has_t_next; 
+		frames->dim = dim; 
+	}
+
+	for (k=1; k < nsegments; k++){
+		close_reader(segments[k].reader); 
+		if (is_surface)
+			free(segments[k].frames.last_t); 
+	}
+	free(segments); 
+	return status; 
+}
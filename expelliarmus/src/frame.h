@@ -0,0 +1,136 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+/** Library for the frame accumulation.
+ *  The events are decoded to a small staging array, that stays in cache, and
+ *  scattered to 2D histograms (frames), voxel grids or time surfaces of fixed
+ *  duration or number of events, so that the memory used does not depend on 
+ *  the event rate.
+ */
+
+#include <stdint.h>
+#include "events.h"
+#include "wizard.h"
+#include "reader.h"
+#include "output.h"
+
+// Frame modes.
+// Number of events of each pixel, one channel for each polarity.
+#define FRAME_COUNT 0U
+// 1 if the pixel has events, one channel for each polarity.
+#define FRAME_BINARY 1U
+// Number of events of polarity 1 minus the number of events of polarity 0, 
+// in a single channel.
+#define FRAME_SIGNED 2U
+// Voxel grid: the events of polarity 1 minus the ones of polarity 0, spread 
+// over a channel for each of the bins of the time window, each event being
+// split between the two closest bins with a linear weight. Only for frames of
+// fixed duration.
+#define FRAME_VOXEL 3U
+// Time surface: exp(-(t_end - t)/tau), where t is the timestamp of the last 
+// event of the pixel up to the end of the frame, t_end, and 0 if the pixel 
+// has no events yet; one channel for each polarity.
+#define FRAME_SURFACE 4U
+
+// Data type of the frame values.
+typedef int32_t frame_value_t; 
+// Data type of the values of voxel grids and time surfaces.
+typedef float frame_float_t; 
+
+/** Structure of the frames to be filled. The frame k covers the events with a
+ *  timestamp in [t_start[k], t_start[k] + time_window) or, if time_window is
+ *  0, the next event_count events (more for EVT3 vectorized events, as in
+ *  read_chunk()). The events with an address out of the frame are dropped.
+ *  The time surface of a frame of event_count events is computed at the 
+ *  timestamp of its last event.
+ *
+ *  @field  mode        One among FRAME_COUNT, FRAME_BINARY, FRAME_SIGNED, 
+ *                      FRAME_VOXEL, FRAME_SURFACE.
+ *  @field  width       The width of the frames.
+ *  @field  height      The height of the frames.
+ *  @field  time_window The duration of a frame [us]; 0 to use event_count.
+ *  @field  event_count The number of events of a frame, if time_window is 0.
+ *  @field  t_next      The start of the next frame, when time_window is set.
+ *  @field  has_t_next  Flag to indicate that t_next is set; if not, the
+ *                      first frame starts at the first event read.
+ *  @field  bins        The number of bins of a voxel grid.
+ *  @field  tau         The decay constant of a time surface [us].
+ *  @field  last_t      The timestamp of the last event of each pixel, for the
+ *                      time surfaces, of size 2*height*width and carried 
+ *                      across calls; INT64_MIN if the pixel has no events.
+ *                      Allocated externally.
+ *  @field  arr         The frames, of size dim*channels*height*width, where
+ *                      the channels are 1 for FRAME_SIGNED, bins for 
+ *                      FRAME_VOXEL and 2 otherwise. Of type frame_float_t for
+ *                      FRAME_VOXEL and FRAME_SURFACE, frame_value_t 
+ *                      otherwise. Allocated externally.
+ *  @field  t_start     The start timestamp of each frame. Allocated
+ *                      externally.
+ *  @field  dim         The number of frames that fit in arr; it is set to
+ *                      the number of frames filled.
+ */
+typedef struct {
+	uint8_t mode; 
+	size_t width; 
+	size_t height; 
+	timestamp_t time_window; 
+	size_t event_count; 
+	timestamp_t t_next; 
+	uint8_t has_t_next; 
+	size_t bins; 
+	double tau; 
+	timestamp_t* last_t; 
+	void* arr; 
+	timestamp_t* t_start; 
+	size_t dim; 
+} frames_t; 
+
+/** Function that fills the frames provided with the events from the binary
+ *  file, decoding them to a staging array with a read_<encoding>() function.
+ *  The decoding stops when the frames are full, at the end of the last one, 
+ *  so that the next call continues from there. The last frame of the file is
+ *  filled also if it is shorter than the others, while the frames without
+ *  events between two that have some are left empty.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure, 
+ *                          passed to read_fn.
+ *  @param[in]  cargo_size  The size in bytes of the cargo structure.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int read_frames(reader_t*, frames_t*, read_fn_t, void*, size_t, 
+                event_cargo_t*); 
+
+/** Function that fills the frames provided as read_frames() does, splitting 
+ *  them among many threads. It requires frames of fixed duration and t_next
+ *  to be set: the frames are split in nsegments runs of consecutive frames, 
+ *  and the k-th one is filled by a thread decoding the file from cargos[k], 
+ *  a state preceding the first event of the run (e.g. an index entry), with
+ *  its own reader. The time surfaces of a run are completed with the events 
+ *  of the previous ones once all the threads have finished. Otherwise, 
+ *  read_frames() is called on the first cargo.
+ *  On return, the first cargo holds the state following the frames. The 
+ *  cargos begin with their event_cargo_t, as all the cargo structures do, 
+ *  and must not set a filter.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] frames      The pointer to the frames structure.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargos      The array of nsegments cargo structures, the first
+ *                          one being the state from which read_frames() would
+ *                          be called.
+ *  @param[in]  cargo_size  The size in bytes of a cargo structure.
+ *  @param[in]  nsegments   The number of runs of frames, one for each thread.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int read_frames_parallel(reader_t*, frames_t*, read_fn_t, void*, size_t, 
+                         size_t); 
+
+#endif
@@ -0,0 +1,274 @@
+#include "index.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Function that checks whether an entry has to be added before the next
+ *  events are decoded.
+ */
+static int needs_entry(const index_t* index){
+	if (!index->has_entry)
+		return 1; 
+	if (index->step_events > 0 && index->since_entry >= index->step_events)
+		return 1; 
+	if (index->step_time > 0 &&
+        index->last_t - index->entry_t >= index->step_time)
+		return 1; 
+	return 0; 
+}
+
+int build_index(reader_t* reader, 
+                index_t* index, 
+                read_fn_t read_fn, 
+                void* cargo, 
+                size_t cargo_size, 
+                event_cargo_t* events_info){
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+
+	const size_t entry_size = sizeof(index_entry_t) + cargo_size; 
+	// The offset of the events information in the cargo.
+	const size_t info_offset = (uint8_t*) events_info - (uint8_t*) cargo; 
+	const event_cargo_t blank_info = {0}; 
+	uint8_t* entry = NULL; 
+	size_t k=0, n=0, block=0, capacity=index->dim; 
+	int status=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	while (status == 0 && k < capacity && !events_info->finished){
+		// The entry holds the cargo before the block is decoded, and the
+		// timestamp of its first event.
+		entry = NULL; 
+		if (needs_entry(index)){
+			// Only the decoder state is stored: the pointers and the read 
+			// bookkeeping of the events information are left to 0, apart 
+			// from the byte to resume from.
+			entry = (uint8_t*) index->entries + k*entry_size; 
+			memset(entry, 0, entry_size); 
+			memcpy(entry + sizeof(index_entry_t), cargo, cargo_size); 
+			memcpy(entry + sizeof(index_entry_t) + info_offset, &blank_info, 
+                   sizeof(event_cargo_t)); 
+			((event_cargo_t*) (entry + sizeof(index_entry_t) + info_offset))
+                ->start_byte = events_info->start_byte; 
+			index->since_entry = 0; 
+		}
+		block = STAGING_SIZE; 
+		if (index->step_events > 0 &&
+            index->step_events - index->since_entry < block)
+			block = index->step_events - index->since_entry; 
+		events_info->dim = block; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		if (n == 0)
+			break; 
+		if (entry != NULL){
+			((index_entry_t*) entry)->ordinal = index->ordinal; 
+			((index_entry_t*) entry)->t = staging[0].t; 
+			index->entry_t = staging[0].t; 
+			index->has_entry = 1; 
+			k++; 
+		}
+		index->ordinal += n; 
+		index->since_entry += n; 
+		index->last_t = staging[n-1].t; 
+	}
+	index->dim = k; 
+	free(staging); 
+	return status; 
+}
+
+int read_range(reader_t* reader, 
+               event_t* arr, 
+               range_t* range, 
+               read_fn_t read_fn, 
+               void* cargo, 
+               event_cargo_t* events_info){
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+
+	size_t i=0, k=0, n=0, block=0, dim=events_info->dim; 
+	int status=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	if (range->count == 0)
+		range->done = 1; 
+	while (status == 0 && i < dim && !range->done){
+		// The block never exceeds the space left, so that the events kept
+		// always fit in arr.
+		block = (dim - i < STAGING_SIZE) ? dim - i : STAGING_SIZE; 
+		events_info->dim = block; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		for (k=0; k < n && !range->done; k++){
+			if (range->skip > 0){
+				range->skip--; 
+				continue; 
+			}
+			if (staging[k].t >= range->t_end){
+				range->done = 1; 
+				break; 
+			}
+			if (staging[k].t < range->t_start)
+				continue; 
+			arr[i++] = staging[k]; 
+			if (--range->count == 0)
+				range->done = 1; 
+		}
+		// A block shorter than requested means that the file is over.
+		if (n < block)
+			range->done = 1; 
+	}
+	events_info->dim = i; 
+	free(staging); 
+	return status; 
+}
+
+int locate_time(reader_t* reader, 
+                read_fn_t read_fn, 
+                void* cargo, 
+                size_t cargo_size, 
+                event_cargo_t* events_info, 
+                timestamp_t t){
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+	void* saved = malloc(cargo_size); 
+	if (saved == NULL){
+		free(staging); 
+		CHECK_BUFF_ALLOCATION(saved); 
+	}
+
+	size_t k=0, n=STAGING_SIZE; 
+	int status=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	while (status == 0 && n == STAGING_SIZE){
+		memcpy(saved, cargo, cargo_size); 
+		events_info->dim = STAGING_SIZE; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		for (k=0; k < n && staging[k].t < t; k++); 
+		if (k < n){
+			// The block is decoded again up to the last event preceding t. 
+			// EVT3 vectors do not exceed it, since their events share the 
+			// timestamp.
+			memcpy(cargo, saved, cargo_size); 
+			if (k > 0){
+				events_info->dim = k; 
+				status = read_fn(reader, staging, cargo); 
+			}
+			break; 
+		}
+		n = n > STAGING_SIZE ? STAGING_SIZE : n; 
+	}
+	free(saved); 
+	free(staging); 
+	return status; 
+}
+
+int write_span(reader_t* reader, 
+               const char* fpath_out, 
+               size_t data_start, 
+               size_t start_byte, 
+               size_t end_byte, 
+               preamble_fn_t preamble_fn, 
+               const void* cargo){
+	start_byte = start_byte > data_start ? start_byte : data_start; 
+	end_byte = end_byte > start_byte ? end_byte : start_byte; 
+	FILE* fp_out = fopen(fpath_out, "wb"); 
+	CHECK_FILE(fp_out, fpath_out); 
+	int status = reader_copy(reader, fp_out, 0, data_start); 
+	if (status == 0 && start_byte > data_start){
+		uint8_t preamble[PREAMBLE_MAX_SIZE]; 
+		const size_t preamble_size = preamble_fn(cargo, preamble); 
+		if (fwrite(preamble, 1, preamble_size, fp_out) != preamble_size)
+			status = -1; 
+	}
+	if (status == 0)
+		status = reader_copy(reader, fp_out, start_byte, end_byte); 
+	if (fclose(fp_out) != 0)
+		status = -1; 
+	if (status != 0)
+		fprintf(stderr, "ERROR: the output file \"%s\" could not be written.\n", 
+                fpath_out); 
+	return status; 
+}
+
+/** Function that decodes the next event without moving the cargo. 
+ *
+ *  @return     found       1 if there is an event, 0 if the file is over and
+ *                          -1 on error.
+ */
+static int peek_event(reader_t* reader, 
+                      event_t* staging, 
+                      read_fn_t read_fn, 
+                      void* cargo, 
+                      void* saved, 
+                      size_t cargo_size, 
+                      event_cargo_t* events_info){
+	memcpy(saved, cargo, cargo_size); 
+	events_info->dim = 1; 
+	int status = read_fn(reader, staging, cargo); 
+	const int found = events_info->dim > 0; 
+	memcpy(cargo, saved, cargo_size); 
+	return status != 0 ? -1 : found; 
+}
+
+int split_file(reader_t* reader, 
+               split_t* split, 
+               size_t data_start, 
+               read_fn_t read_fn, 
+               preamble_fn_t preamble_fn, 
+               void* cargo, 
+               size_t cargo_size, 
+               event_cargo_t* events_info){
+	event_t* staging = (event_t*) malloc((1 + STAGING_SLACK) * sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+	void* start = malloc(cargo_size); 
+	void* saved = malloc(cargo_size); 
+	if (start == NULL || saved == NULL){
+		free(staging); 
+		free(start); 
+		free(saved); 
+		fprintf(stderr, "ERROR: the cargo copies could not be allocated.\n"); 
+		return -1; 
+	}
+	// The events information of the copy at the clip beginning.
+	const event_cargo_t* start_info = (const event_cargo_t*) (
+        (uint8_t*) start + ((uint8_t*) events_info - (uint8_t*) cargo)); 
+
+	size_t k=0, capacity=split->dim; 
+	int status=0, found=0; 
+	events_info->is_chunk = 1; 
+	events_info->is_time_window = 0; 
+	while (status == 0 && k < capacity){
+		// Looking for the event following the last clip.
+		if ((found = peek_event(reader, staging, read_fn, cargo, saved, 
+                                cargo_size, events_info)) <= 0){
+			status = found; 
+			events_info->finished = 1; 
+			break; 
+		}
+		if (!split->has_t_next){
+			split->t_next = staging[0].t + split->duration; 
+			split->has_t_next = 1; 
+		}
+		memcpy(start, cargo, cargo_size); 
+		status = locate_time(reader, read_fn, cargo, cargo_size, events_info, 
+                             split->t_next); 
+		if (status == 0)
+			status = write_span(reader, split->fpaths[k], data_start, 
+                                start_info->start_byte, 
+                                events_info->start_byte, preamble_fn, start); 
+		split->t_next += split->duration; 
+		k++; 
+	}
+	split->dim = k; 
+	free(saved); 
+	free(start); 
+	free(staging); 
+	return status; 
+}
@@ -0,0 +1,232 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+/** Library for the indices of the binary files.
+ *  An index is a list of resume points: each entry holds the number of events
+ *  preceding it, the timestamp of the first event following it and a copy of
+ *  the decoder cargo at that point, so that a read_<encoding>() call can
+ *  start there without decoding the file from the beginning.
+ *  The entries are built in a single pass, decoding the file through a
+ *  staging array as read_columns() does.
+ */
+
+#include <stdint.h>
+#include "events.h"
+#include "wizard.h"
+#include "reader.h"
+#include "output.h"
+
+/** Structure at the beginning of each index entry. It is followed by the
+ *  cargo of the encoding (e.g. evt2_cargo_t), so that an entry takes
+ *  sizeof(index_entry_t) + sizeof(cargo) bytes. The events information of
+ *  the cargo only holds start_byte, the other fields and the padding being 0.
+ *
+ *  @field  ordinal     The number of events preceding the entry.
+ *  @field  t           The timestamp of the first event following the entry.
+ */
+typedef struct {
+	uint64_t ordinal; 
+	timestamp_t t; 
+} index_entry_t; 
+
+/** Structure holding the state of an index being built, so that it can be
+ *  filled through many calls when the entries array is full.
+ *
+ *  @field  step_events     An entry is added every step_events events; 0 to
+ *                          disable.
+ *  @field  step_time       An entry is added when step_time microseconds
+ *                          have elapsed since the previous one; 0 to disable.
+ *                          The events are decoded in blocks of STAGING_SIZE,
+ *                          that is the resolution of this step.
+ *  @field  ordinal         The number of events decoded so far.
+ *  @field  since_entry     The number of events decoded since the last entry.
+ *  @field  entry_t         The timestamp of the last entry.
+ *  @field  last_t          The timestamp of the last event decoded.
+ *  @field  has_entry       Flag to indicate that an entry has been added.
+ *  @field  entries         The array of entries. Allocated externally.
+ *  @field  dim             The capacity of entries; the number of entries
+ *                          added by the last call is written here.
+ */
+typedef struct {
+	size_t step_events; 
+	timestamp_t step_time; 
+	uint64_t ordinal; 
+	uint64_t since_entry; 
+	timestamp_t entry_t; 
+	timestamp_t last_t; 
+	uint8_t has_entry; 
+	void* entries; 
+	size_t dim; 
+} index_t; 
+
+/** Function that adds to the index the resume points of the binary file,
+ *  decoding it with a read_<encoding>() function from the state stored in
+ *  cargo. It returns when the file is over (events_info->finished is set to
+ *  1) or when index->dim entries have been added; in the latter case, it can
+ *  be called again with a new entries array to continue.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] index       The index being built.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  cargo_size  The size in bytes of the cargo structure.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int build_index(reader_t*, index_t*, read_fn_t, void*, size_t, 
+                event_cargo_t*); 
+
+/** Structure delimiting the events read by read_range(). An event is kept if 
+ *  it follows the first skip events, its timestamp is in [t_start, t_end) 
+ *  and less than count events have been kept; the first event with a 
+ *  timestamp not smaller than t_end ends the range.
+ *
+ *  @field  skip        The number of events to be dropped at the beginning.
+ *                      Decremented while they are dropped.
+ *  @field  count       The maximum number of events to be kept. Decremented
+ *                      while they are kept.
+ *  @field  t_start     The first timestamp of the range.
+ *  @field  t_end       The timestamp ending the range (excluded).
+ *  @field  done        Flag to indicate that the range end has been reached.
+ */
+typedef struct {
+	uint64_t skip; 
+	uint64_t count; 
+	timestamp_t t_start; 
+	timestamp_t t_end; 
+	uint8_t done; 
+} range_t; 
+
+/** Function that fills the array provided with the events of a range, 
+ *  decoding the file with a read_<encoding>() function from the state stored
+ *  in cargo (e.g. an index entry). The events outside of the range are 
+ *  decoded to a staging array and dropped, and the decoding stops at the end
+ *  of the range.
+ *  arr is supposed to have size events_info->dim plus STAGING_SLACK; if it is 
+ *  filled before the range end, range->done is left to 0 and the function 
+ *  can be called again to continue. The number of events written is saved to
+ *  events_info->dim.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] arr         The event array. Allocated externally.
+ *  @param[in]  range       The pointer to the range structure.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int read_range(reader_t*, event_t*, range_t*, read_fn_t, void*, 
+               event_cargo_t*); 
+
+/** Function that moves the cargo past all the events with a timestamp 
+ *  smaller than t, decoding the file with a read_<encoding>() function from 
+ *  the state stored in cargo (e.g. an index entry), that must precede the 
+ *  first event with timestamp t or larger. 
+ *  On return, events_info->start_byte is the first byte after the last 
+ *  event with a timestamp smaller than t (0 if no event is decoded from the 
+ *  beginning of the file), and the cargo holds the decoder state there.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  cargo_size  The size in bytes of the cargo structure.
+ *  @param[in]  events_info The events information in the cargo.
+ *  @param[in]  t           The timestamp to be reached [us].
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int locate_time(reader_t*, read_fn_t, void*, size_t, event_cargo_t*, 
+                timestamp_t); 
+
+// Maximum size in bytes of the words restoring the decoder state at the 
+// beginning of a portion of the binary file.
+#define PREAMBLE_MAX_SIZE 16U
+
+/** Type of the functions that write the words restoring the decoder state 
+ *  stored in cargo, so that the bytes following the state can be decoded on 
+ *  their own. 
+ *
+ *  @param[in]  cargo       The pointer to the information cargo structure.
+ *  @param[out] words       The preamble words; PREAMBLE_MAX_SIZE bytes long.
+ *
+ *  @return     size        The size of the preamble in bytes.
+ */
+typedef size_t (*preamble_fn_t)(const void*, void*); 
+
+/** Function that writes a portion of the binary file to a new file: the 
+ *  header, the preamble restoring the decoder state at the first byte copied,
+ *  and the bytes in [start_byte, end_byte), that are copied without being 
+ *  decoded (see reader_copy()). A start or end byte equal to 0 stands for 
+ *  the data beginning, in which case the preamble is not written.
+ *
+ *  @param[in]  reader          The reader of the input file.
+ *  @param[in]  fpath_out       Path to the output file.
+ *  @param[in]  data_start      The byte where the data begin.
+ *  @param[in]  start_byte      The first byte copied.
+ *  @param[in]  end_byte        The byte ending the copy (excluded).
+ *  @param[in]  preamble_fn     The function writing the preamble.
+ *  @param[in]  cargo           The cargo at start_byte, passed to 
+ *                              preamble_fn.
+ *
+ *  @return     status          A flag that when different from 0, indicates 
+ *                              that there has been some error while writing 
+ *                              the file.
+ */
+int write_span(reader_t*, const char*, size_t, size_t, size_t, preamble_fn_t, 
+               const void*); 
+
+/** Structure holding the state of a recording being split in clips of fixed
+ *  duration, so that it can be split through many calls when the output 
+ *  paths are over. 
+ *
+ *  @field  duration    The duration of the clips [us].
+ *  @field  t_next      The timestamp ending the current clip.
+ *  @field  has_t_next  Flag to indicate that t_next has been set from the 
+ *                      first event of the recording.
+ *  @field  fpaths      The paths of the output files. Allocated externally.
+ *  @field  dim         The number of output paths; the number of clips 
+ *                      written by the last call is written here.
+ */
+typedef struct {
+	timestamp_t duration; 
+	timestamp_t t_next; 
+	uint8_t has_t_next; 
+	const char** fpaths; 
+	size_t dim; 
+} split_t; 
+
+/** Function that splits the binary file in clips of split->duration 
+ *  microseconds, the first one starting at the first event, in a single 
+ *  pass: the decoder moves through the clip boundaries with locate_time(), 
+ *  and the bytes of each clip are copied after the header and the preamble 
+ *  (see write_span()). The clips without events are written as well, so 
+ *  that the k-th one always starts at k*duration from the first event.
+ *  It returns when the file is over (events_info->finished is set to 1) or 
+ *  when split->dim clips have been written; in the latter case, it can be 
+ *  called again with new output paths to continue.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] split       The state of the split.
+ *  @param[in]  data_start  The byte where the data begin.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  preamble_fn The function writing the preamble.
+ *  @param[in]  cargo       The pointer to the information cargo structure,
+ *                          passed to read_fn.
+ *  @param[in]  cargo_size  The size in bytes of the cargo structure.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that
+ *                          there has been some error while reading the file.
+ */
+int split_file(reader_t*, split_t*, size_t, read_fn_t, preamble_fn_t, void*, 
+               size_t, event_cargo_t*); 
+
+#endif
@@ -0,0 +1,157 @@
+#include "output.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Flags returned by the split_<layout>() functions.
+#define SPLIT_OVERFLOW 1
+#define SPLIT_CLAMPED 2
+
+/** Functions that copy n events from the staging array to the output arrays,
+ *  starting from the i-th element of the latter. The fields whose array is 
+ *  NULL are skipped, one loop per field so that the projected out ones are
+ *  not copied; they are decoded to the staging array nonetheless.
+ *  The timestamps are made relative to columns->t_base; the functions return
+ *  SPLIT_OVERFLOW if one of them does not fit in the output type, 
+ *  SPLIT_CLAMPED if one of them has been clamped to it and 0 otherwise.
+ */
+static int split_soa(const event_t* staging, size_t n, columns_t* columns, 
+                     size_t i){
+	if (columns->t != NULL){
+		timestamp_t* t = (timestamp_t*) columns->t + i; 
+		for (size_t k=0; k < n; k++)
+			t[k] = staging[k].t; 
+	}
+	if (columns->x != NULL){
+		address_t* x = (address_t*) columns->x + i; 
+		for (size_t k=0; k < n; k++)
+			x[k] = staging[k].x; 
+	}
+	if (columns->y != NULL){
+		address_t* y = (address_t*) columns->y + i; 
+		for (size_t k=0; k < n; k++)
+			y[k] = staging[k].y; 
+	}
+	if (columns->p != NULL){
+		polarity_t* p = (polarity_t*) columns->p + i; 
+		for (size_t k=0; k < n; k++)
+			p[k] = staging[k].p; 
+	}
+	return 0; 
+}
+
+static int split_compact(const event_t* staging, size_t n, columns_t* columns, 
+                         size_t i){
+	timestamp_t dt=0, min_dt=0, max_dt=0; 
+	if (columns->t != NULL){
+		rel_timestamp_t* t = (rel_timestamp_t*) columns->t + i; 
+		const timestamp_t t_base = columns->t_base; 
+		for (size_t k=0; k < n; k++){
+			dt = staging[k].t - t_base; 
+			min_dt = dt < min_dt ? dt : min_dt; 
+			max_dt = dt > max_dt ? dt : max_dt; 
+			t[k] = (rel_timestamp_t) dt; 
+		}
+	}
+	if (columns->x != NULL){
+		compact_address_t* x = (compact_address_t*) columns->x + i; 
+		for (size_t k=0; k < n; k++)
+			x[k] = (compact_address_t) staging[k].x; 
+	}
+	if (columns->y != NULL){
+		compact_address_t* y = (compact_address_t*) columns->y + i; 
+		for (size_t k=0; k < n; k++)
+			y[k] = (compact_address_t) staging[k].y; 
+	}
+	if (columns->p != NULL){
+		polarity_t* p = (polarity_t*) columns->p + i; 
+		for (size_t k=0; k < n; k++)
+			p[k] = staging[k].p; 
+	}
+	return (min_dt < INT32_MIN || max_dt > INT32_MAX) ? SPLIT_OVERFLOW : 0; 
+}
+
+static int split_packed(const event_t* staging, size_t n, columns_t* columns, 
+                        size_t i){
+	uint64_t* packed = columns->packed + i; 
+	const timestamp_t t_base = columns->t_base; 
+	timestamp_t dt=0, min_dt=0, max_dt=0; 
+	uint64_t x=0, y=0, p=0; 
+	for (size_t k=0; k < n; k++){
+		// The timestamps are not necessarily monotonic: the ones preceding 
+		// t_base, that cannot be represented, are clamped to it.
+		dt = staging[k].t - t_base; 
+		min_dt = dt < min_dt ? dt : min_dt; 
+		max_dt = dt > max_dt ? dt : max_dt; 
+		dt = dt < 0 ? 0 : dt; 
+		x = (uint64_t) staging[k].x & PACKED_ADDR_MASK; 
+		y = (uint64_t) staging[k].y & PACKED_ADDR_MASK; 
+		p = (uint64_t) staging[k].p & PACKED_P_MASK; 
+		packed[k] = ((uint64_t) dt & UINT32_MAX) | (x << PACKED_X_SHIFT) | 
+		            (y << PACKED_Y_SHIFT) | (p << PACKED_P_SHIFT); 
+	}
+	return (max_dt > UINT32_MAX ? SPLIT_OVERFLOW : 0) | 
+           (min_dt < 0 ? SPLIT_CLAMPED : 0); 
+}
+
+int read_columns(reader_t* reader, 
+                 columns_t* columns, 
+                 read_fn_t read_fn, 
+                 void* cargo, 
+                 event_cargo_t* events_info){
+	int (*split)(const event_t*, size_t, columns_t*, size_t) = NULL; 
+	switch (columns->layout){
+		case LAYOUT_SOA:
+			split = split_soa; 
+			break; 
+		case LAYOUT_COMPACT:
+			split = split_compact; 
+			break; 
+		case LAYOUT_PACKED:
+			split = split_packed; 
+			break; 
+		default:
+			fprintf(stderr, "ERROR: the output layout is not supported.\n"); 
+			return -1; 
+	}
+
+	event_t* staging = (event_t*) malloc((STAGING_SIZE + STAGING_SLACK) *
+                                         sizeof(event_t)); 
+	CHECK_BUFF_ALLOCATION(staging); 
+
+	size_t i=0, n=0, block=0, dim=events_info->dim; 
+	int status=0, flags=0; 
+	uint8_t tsWarning=0; 
+	// A block shorter than requested means that the file is over. The finished
+	// flag cannot be used, since get_time_window_<encoding>() sets it when the
+	// last window is measured, before the window is read.
+	while (status == 0 && i < dim && n == block){
+		block = (dim - i < STAGING_SIZE) ? dim - i : STAGING_SIZE; 
+		events_info->dim = block; 
+		status = read_fn(reader, staging, cargo); 
+		n = events_info->dim; 
+		if (n > 0 && !columns->has_t_base){
+			columns->t_base = staging[0].t; 
+			columns->has_t_base = 1; 
+		}
+		// Splitting the events in the output arrays, while the staging array
+		// is still in cache.
+		flags = split(staging, n, columns, i); 
+		if (flags & SPLIT_OVERFLOW){
+			fprintf(stderr, "ERROR: the timestamps relative to %lld do not fit "
+                    "in 32 bits.\n", (long long) columns->t_base); 
+			status = -1; 
+		}
+		tsWarning |= (flags & SPLIT_CLAMPED) != 0; 
+		i += n; 
+		// EVT3 vectors can exceed the block.
+		n = n > block ? block : n; 
+	}
+	if (tsWarning)
+		fprintf(stderr, "WARNING: The timestamps are not monotonic: the ones "
+                "preceding %lld are packed as it.\n", 
+                (long long) columns->t_base); 
+	events_info->dim = i; 
+	free(staging); 
+	return status; 
+}
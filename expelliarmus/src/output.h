@@ -0,0 +1,102 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/** Library for the output layouts of the decoders.
+ *  The decoders write arrays of event_t structures. To fill other layouts, the
+ *  events are decoded to a small staging array, that stays in cache, and then
+ *  copied to the output arrays.
+ */
+
+#include <stdint.h>
+#include "events.h"
+#include "wizard.h"
+#include "reader.h"
+
+// Output layouts.
+// Array of event_t structures.
+#define LAYOUT_AOS 0U
+// One contiguous array for each field.
+#define LAYOUT_SOA 1U
+// One contiguous array for each field, with the timestamps narrowed to 32 bits
+// relative to a base timestamp and the addresses to 16 bits unsigned.
+#define LAYOUT_COMPACT 2U
+// Array of 8 bytes events, see the PACKED_* bit fields.
+#define LAYOUT_PACKED 3U
+
+// Bit fields of a packed event: the lower 32 bits hold the timestamp relative 
+// to the base one, followed by 14 bits of X address, 14 bits of Y address and 
+// 4 bits of polarity (the widths of the DAT format).
+#define PACKED_X_SHIFT 32U
+#define PACKED_Y_SHIFT 46U
+#define PACKED_P_SHIFT 60U
+#define PACKED_ADDR_MASK 0x3FFFU
+#define PACKED_P_MASK 0xFU
+
+// Number of events decoded to the staging array at a time (16 KiB, so that
+// the staging array stays in L1 cache).
+#define STAGING_SIZE 1024U
+// Extra events that the decoders can write past the staging array end (see
+// the EVT3 vectorized events).
+#define STAGING_SLACK 12U
+
+// Data types used by the LAYOUT_COMPACT fields.
+typedef int32_t rel_timestamp_t; 
+typedef uint16_t compact_address_t; 
+
+/** Structure of the output arrays used by the LAYOUT_SOA, LAYOUT_COMPACT and 
+ *  LAYOUT_PACKED layouts. The field arrays have type timestamp_t/address_t 
+ *  for LAYOUT_SOA and rel_timestamp_t/compact_address_t for LAYOUT_COMPACT,
+ *  while LAYOUT_PACKED uses only the packed array. The field arrays set to 
+ *  NULL are not filled (output projection): the read_<encoding>() functions
+ *  still decode all the fields to the staging array.
+ *
+ *  @field  layout      One among LAYOUT_SOA, LAYOUT_COMPACT, LAYOUT_PACKED.
+ *  @field  t_base      The timestamp subtracted from the ones written by 
+ *                      LAYOUT_COMPACT and LAYOUT_PACKED. 
+ *  @field  has_t_base  Flag to indicate that t_base is set; if not, it is set
+ *                      to the timestamp of the first event read.
+ *  @field  t           Timestamps.
+ *  @field  x           X addresses.
+ *  @field  y           Y addresses.
+ *  @field  p           Polarities.
+ *  @field  packed      Packed events.
+ */
+typedef struct {
+	uint8_t layout; 
+	timestamp_t t_base; 
+	uint8_t has_t_base; 
+	void* t; 
+	void* x; 
+	void* y; 
+	void* p; 
+	uint64_t* packed; 
+} columns_t;
+
+/** Signature of the read_<encoding>() functions, with the cargo passed as a 
+ *  generic pointer.
+ */
+typedef int (*read_fn_t)(reader_t*, event_t*, void*);
+
+/** Function that fills the columns provided with the events from the binary 
+ *  file, decoding them to a staging array with a read_<encoding>() function 
+ *  and narrowing them to columns->layout. 
+ *  The columns are supposed to have size events_info->dim, plus STAGING_SLACK
+ *  elements if the last event decoded can be a vector of events (EVT3); the 
+ *  number of events written is saved to events_info->dim.
+ *  When the entire file has been read, events_info->finished is set to 1.
+ *
+ *  @param[in]  reader      The reader of the input file.
+ *  @param[out] columns     The output arrays. Allocated externally.
+ *  @param[in]  read_fn     The function decoding the events.
+ *  @param[in]  cargo       The pointer to the information cargo structure, 
+ *                          passed to read_fn.
+ *  @param[in]  events_info The events information in the cargo.
+ *
+ *  @return     status      A flag that when different from 0, indicates that 
+ *                          there has been some error while filling the 
+ *                          columns or reading the file, or that a relative 
+ *                          timestamp does not fit in 32 bits.
+ */
+int read_columns(reader_t*, columns_t*, read_fn_t, void*, event_cargo_t*);
+
+#endif
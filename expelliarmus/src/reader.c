@@ -0,0 +1,667 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// Needed by copy_file_range().
+#define _GNU_SOURCE
+#endif
+#include "reader.h"
+#include "threads.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAS_COPY_FILE_RANGE
+#endif
+
+/** Structure of the ring of blocks filled by the prefetch thread of a reader
+ *  with IO_MODE_PREFETCH. The blocks hold consecutive bytes of the file: the 
+ *  thread fills them in order, while the reader decodes the words in place 
+ *  from the head one and releases it when its position moves past it. The 
+ *  fields are protected by the monitor, except for the content of the 
+ *  blocks: the thread writes only the block after the filled ones, and the
+ *  reader reads only the filled ones.
+ *
+ *  @field  fp          Input file pointer, used only by the thread.
+ *  @field  blocks      The PREFETCH_BLOCKS blocks, of block_size bytes each.
+ *  @field  starts      Byte offset in the file of each block.
+ *  @field  lens        The number of valid bytes of each block.
+ *  @field  block_size  The capacity of a block in bytes.
+ *  @field  min_size    The size of the first read after a seek in bytes.
+ *  @field  ramp        The size of the next read in bytes, doubled at each
+ *                      block up to block_size.
+ *  @field  head        The index of the first filled block.
+ *  @field  count       The number of filled blocks.
+ *  @field  next        Byte offset in the file of the next block to be read;
+ *                      SIZE_MAX before the first fetch.
+ *  @field  end         Byte offset at which the thread stops reading.
+ *  @field  seeks       The number of times the ring has been moved, used by
+ *                      the thread to discard a block read in the meantime.
+ *  @field  done        Flag to indicate that the thread has nothing to read
+ *                      until the ring is moved, having reached the end of the
+ *                      file or the end byte.
+ *  @field  stop        Flag to terminate the thread.
+ *  @field  monitor     The monitor shared by the thread and the reader.
+ *  @field  thread      The prefetch thread.
+ */
+typedef struct {
+	FILE* fp;
+	uint8_t* blocks;
+	size_t starts[PREFETCH_BLOCKS];
+	size_t lens[PREFETCH_BLOCKS];
+	size_t block_size;
+	size_t min_size;
+	size_t ramp;
+	size_t head;
+	size_t count;
+	size_t next;
+	size_t end;
+	size_t seeks;
+	uint8_t done;
+	uint8_t stop;
+	monitor_t* monitor;
+	thread_t* thread;
+} prefetch_t;
+
+/** Structure of a reader.
+ *
+ *  @field  fpath       Path to the input file, used to clone the reader.
+ *  @field  io_mode     How the file is accessed, IO_MODE_FREAD, IO_MODE_MMAP
+ *                      or IO_MODE_PREFETCH.
+ *  @field  file_size   The size of the file in bytes.
+ *  @field  end         Byte offset after which no words are provided.
+ *  @field  fp          Input file pointer. With IO_MODE_FREAD, the file 
+ *                      position is always at buff_start + buff_len; with 
+ *                      IO_MODE_PREFETCH, it is moved by the prefetch thread 
+ *                      only.
+ *  @field  map         The file mapped to memory. Used by IO_MODE_MMAP.
+ *  @field  map_size    The size of the mapping, i.e. of the file, in bytes.
+ *  @field  owns_map    Flag to indicate that the mapping has been created by
+ *                      this reader and not shared by the one it was cloned 
+ *                      from.
+ *  @field  buff        The read buffer. With IO_MODE_MMAP, it is used only 
+ *                      when the words in the mapping are not aligned.
+ *  @field  buff_size   The capacity of the buffer in bytes.
+ *  @field  buff_start  Byte offset in the file of buff[0].
+ *  @field  buff_len    Number of valid bytes in the buffer.
+ *  @field  pos         Byte offset in the file of the next unconsumed byte.
+ *  @field  prefetch    The ring filled by the prefetch thread. Used by 
+ *                      IO_MODE_PREFETCH.
+ */
+struct reader_s {
+	char* fpath;
+	uint8_t io_mode;
+	size_t file_size;
+	size_t end;
+	FILE* fp;
+	const uint8_t* map;
+	size_t map_size;
+	uint8_t owns_map;
+	uint8_t* buff;
+	size_t buff_size;
+	size_t buff_start;
+	size_t buff_len;
+	size_t pos;
+	prefetch_t* prefetch;
+};
+
+/** Function that maps the whole file to memory, advising the kernel that it 
+ *  is going to be read sequentially. 
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[in]  fpath       Path to the input file.
+ *
+ *  @return     status      0 on success, non zero otherwise.
+ */
+static int map_file(reader_t* reader, const char* fpath){
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	HANDLE file = CreateFileA(fpath, GENERIC_READ, FILE_SHARE_READ, NULL, 
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return -1;
+	if (!GetFileSizeEx(file, &size)){
+		CloseHandle(file);
+		return -1;
+	}
+	reader->map_size = (size_t)size.QuadPart;
+	if (reader->map_size > 0){
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 
+                                            0, 0, NULL);
+		if (mapping != NULL){
+			reader->map = (const uint8_t*) MapViewOfFile(mapping, 
+                                                        FILE_MAP_READ, 
+                                                        0, 0, 0);
+			reader->owns_map = reader->map != NULL;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	struct stat info;
+	int fd = open(fpath, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &info) != 0){
+		close(fd);
+		return -1;
+	}
+	reader->map_size = (size_t)info.st_size;
+	if (reader->map_size > 0){
+		void* map = mmap(NULL, reader->map_size, PROT_READ, MAP_PRIVATE, 
+                         fd, 0);
+		if (map != MAP_FAILED){
+			reader->map = (const uint8_t*) map;
+			reader->owns_map = 1;
+			madvise(map, reader->map_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+			madvise(map, reader->map_size, MADV_HUGEPAGE);
+#endif
+		}
+	}
+	close(fd);
+#endif
+	// Empty files are not mapped.
+	return (reader->map_size > 0 && reader->map == NULL) ? -1 : 0;
+}
+
+/** Function that releases the memory mapping of the file.
+ *
+ *  @param[in]  reader      The reader.
+ */
+static void unmap_file(reader_t* reader){
+	if (reader->map == NULL || !reader->owns_map)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile((LPCVOID)reader->map);
+#else
+	munmap((void*)reader->map, reader->map_size);
+#endif
+	reader->map = NULL;
+	return;
+}
+
+/** Function executed by the prefetch thread: it fills the blocks of the ring
+ *  following the filled ones, until the ring is full or the end of the file 
+ *  is reached, and then waits for the reader to consume them or to move the
+ *  ring. The file is read without holding the lock.
+ *
+ *  @param[in]  arg         The prefetch_t structure of the reader.
+ *
+ *  @return     NULL.
+ */
+static void* prefetch_blocks(void* arg){
+	prefetch_t* prefetch = (prefetch_t*) arg;
+	// Byte offset of the file position, SIZE_MAX if unknown.
+	size_t file_pos = 0, start, size, len, seeks, k;
+	lock_monitor(prefetch->monitor);
+	while (!prefetch->stop){
+		if (prefetch->done || prefetch->count == PREFETCH_BLOCKS){
+			wait_monitor(prefetch->monitor);
+			continue;
+		}
+		seeks = prefetch->seeks;
+		start = prefetch->next;
+		k = (prefetch->head + prefetch->count) % PREFETCH_BLOCKS;
+		size = prefetch->ramp;
+		if (prefetch->end <= start)
+			size = 0;
+		else if (prefetch->end - start < size)
+			size = prefetch->end - start;
+		prefetch->ramp = 2*prefetch->ramp < prefetch->block_size ? 
+                         2*prefetch->ramp : prefetch->block_size;
+		unlock_monitor(prefetch->monitor);
+		len = 0;
+		if (size > 0 && (file_pos == start || 
+                         fseek(prefetch->fp, (long)start, SEEK_SET) == 0)){
+			len = fread(prefetch->blocks + k*prefetch->block_size, 1, size, 
+                        prefetch->fp);
+			file_pos = start + len;
+		} else
+			file_pos = SIZE_MAX;
+		lock_monitor(prefetch->monitor);
+		// If the ring has been moved in the meantime, the block is dropped.
+		if (seeks != prefetch->seeks)
+			continue;
+		prefetch->starts[k] = start;
+		prefetch->lens[k] = len;
+		prefetch->next += len;
+		if (len > 0)
+			prefetch->count++;
+		prefetch->done = len < size || size == 0 || 
+                         prefetch->next >= prefetch->end;
+		notify_monitor(prefetch->monitor);
+	}
+	unlock_monitor(prefetch->monitor);
+	return NULL;
+}
+
+/** Function that allocates the ring of a reader with IO_MODE_PREFETCH and 
+ *  starts its thread, that waits for the first read. The file has to be 
+ *  already open.
+ *
+ *  @param[in]  reader      The reader.
+ *
+ *  @return     status      0 on success, non zero otherwise.
+ */
+static int start_prefetch(reader_t* reader){
+	prefetch_t* prefetch = (prefetch_t*) calloc(1, sizeof(prefetch_t));
+	if (prefetch == NULL)
+		return -1;
+	reader->prefetch = prefetch;
+	prefetch->fp = reader->fp;
+	prefetch->block_size = reader->buff_size > PREFETCH_BLOCK_SIZE ? 
+                           reader->buff_size : PREFETCH_BLOCK_SIZE;
+	prefetch->min_size = prefetch->ramp = reader->buff_size;
+	prefetch->next = prefetch->end = SIZE_MAX;
+	prefetch->done = 1;
+	prefetch->blocks = (uint8_t*) malloc(PREFETCH_BLOCKS * 
+                                         prefetch->block_size);
+	prefetch->monitor = create_monitor();
+	if (prefetch->blocks == NULL || prefetch->monitor == NULL)
+		return -1;
+	prefetch->thread = start_thread(prefetch_blocks, prefetch);
+	return prefetch->thread == NULL ? -1 : 0;
+}
+
+/** Function that stops the prefetch thread of a reader and frees its ring.
+ *
+ *  @param[in]  reader      The reader.
+ */
+static void stop_prefetch(reader_t* reader){
+	prefetch_t* prefetch = reader->prefetch;
+	if (prefetch == NULL)
+		return;
+	if (prefetch->thread != NULL){
+		lock_monitor(prefetch->monitor);
+		prefetch->stop = 1;
+		notify_monitor(prefetch->monitor);
+		unlock_monitor(prefetch->monitor);
+		join_thread(prefetch->thread);
+	}
+	destroy_monitor(prefetch->monitor);
+	free(prefetch->blocks);
+	free(prefetch);
+	reader->prefetch = NULL;
+	return;
+}
+
+/** Function that moves the ring of the prefetch thread to a byte of the 
+ *  file, dropping the blocks filled. Called with the lock held.
+ *
+ *  @param[in]  prefetch    The ring of the reader.
+ *  @param[in]  byte        Byte offset in the file of the next block read.
+ */
+static void move_ring(prefetch_t* prefetch, size_t byte){
+	prefetch->seeks++;
+	prefetch->head = prefetch->count = 0;
+	prefetch->next = byte;
+	prefetch->ramp = prefetch->min_size;
+	prefetch->done = 0;
+	notify_monitor(prefetch->monitor);
+	return;
+}
+
+/** Function that provides the words available in the block of the ring of 
+ *  the prefetch thread holding the reader position, waiting for it to be 
+ *  read. The words are decoded in place: the blocks preceding the position
+ *  are released to the thread, while the ring is moved to the position when
+ *  this is not in the blocks filled, or the words are not aligned in the 
+ *  block (e.g. after the header has been skipped byte by byte), or one of 
+ *  them is split between two blocks.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[out] words       Pointer set to the first available word.
+ *  @param[in]  word_size   The size of the words in bytes.
+ *
+ *  @return     num_words   The number of whole words available.
+ */
+static size_t prefetch_fetch(reader_t* reader, 
+                             const void** words, 
+                             size_t word_size){
+	prefetch_t* prefetch = reader->prefetch;
+	const size_t pos = reader->pos;
+	size_t k, offset, available;
+	lock_monitor(prefetch->monitor);
+	while (prefetch->count > 0 && pos >= prefetch->starts[prefetch->head] + 
+                                         prefetch->lens[prefetch->head]){
+		prefetch->head = (prefetch->head + 1) % PREFETCH_BLOCKS;
+		prefetch->count--;
+		notify_monitor(prefetch->monitor);
+	}
+	if (prefetch->count > 0 ? pos < prefetch->starts[prefetch->head] : 
+                              pos != prefetch->next)
+		move_ring(prefetch, pos);
+	while (1){
+		while (prefetch->count == 0 && !prefetch->done)
+			wait_monitor(prefetch->monitor);
+		if (prefetch->count == 0){
+			unlock_monitor(prefetch->monitor);
+			return 0;
+		}
+		k = prefetch->head;
+		offset = pos - prefetch->starts[k];
+		available = prefetch->lens[k] - offset;
+		if (offset % word_size == 0 && (available >= word_size || 
+                (prefetch->count == 1 && prefetch->done)))
+			break;
+		move_ring(prefetch, pos);
+	}
+	unlock_monitor(prefetch->monitor);
+	*words = (const void*)(prefetch->blocks + k*prefetch->block_size + offset);
+	return available / word_size;
+}
+
+/** Function that allocates a reader and its buffer, without opening the file.
+ *
+ *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  buff_size   The size of the read buffer in bytes.
+ *  @param[in]  io_mode     How the file is accessed.
+ *
+ *  @return     reader      The reader, or NULL if the allocation failed.
+ */
+static reader_t* alloc_reader(const char* fpath, 
+                              size_t buff_size, 
+                              uint8_t io_mode){
+	reader_t* reader = (reader_t*) malloc(sizeof(reader_t));
+	if (reader == NULL)
+		return NULL;
+	reader->io_mode = io_mode;
+	reader->file_size = 0;
+	reader->end = SIZE_MAX;
+	reader->fp = NULL;
+	reader->map = NULL;
+	reader->map_size = 0;
+	reader->owns_map = 0;
+	reader->prefetch = NULL;
+	// At least a DAT word has to fit in the buffer.
+	if (buff_size < sizeof(uint64_t))
+		buff_size = sizeof(uint64_t);
+	reader->buff = (uint8_t*) malloc(buff_size);
+	reader->fpath = (char*) malloc(strlen(fpath) + 1);
+	if (reader->buff == NULL || reader->fpath == NULL){
+		close_reader(reader);
+		return NULL;
+	}
+	strcpy(reader->fpath, fpath);
+	reader->buff_size = buff_size;
+	reader->buff_start = reader->buff_len = reader->pos = 0;
+	return reader;
+}
+
+/** Function that opens the file with fopen() and gets its size.
+ *
+ *  @param[in]  reader      The reader.
+ *
+ *  @return     status      0 on success, non zero otherwise.
+ */
+static int open_file(reader_t* reader){
+	long size;
+	reader->fp = fopen(reader->fpath, "rb");
+	if (reader->fp == NULL)
+		return -1;
+	if (fseek(reader->fp, 0, SEEK_END) != 0 || 
+            (size = ftell(reader->fp)) < 0 || 
+            fseek(reader->fp, 0, SEEK_SET) != 0)
+		return -1;
+	reader->file_size = (size_t)size;
+	return 0;
+}
+
+DLLEXPORT reader_t* open_reader(const char* fpath, 
+                                size_t buff_size, 
+                                uint8_t io_mode){
+	reader_t* reader = alloc_reader(fpath, buff_size, io_mode);
+	if (reader == NULL)
+		return NULL;
+	switch (io_mode){
+		case IO_MODE_FREAD:
+			if (open_file(reader) == 0)
+				return reader;
+			break;
+
+		case IO_MODE_MMAP:
+			if (map_file(reader, fpath) == 0){
+				reader->file_size = reader->map_size;
+				return reader;
+			}
+			break;
+
+		case IO_MODE_PREFETCH:
+			if (open_file(reader) == 0 && start_prefetch(reader) == 0)
+				return reader;
+			break;
+
+		default:
+			fprintf(stderr, "ERROR: I/O mode not recognised: %u.\n", io_mode);
+	}
+	close_reader(reader);
+	return NULL;
+}
+
+reader_t* reader_clone(const reader_t* reader){
+	reader_t* clone = alloc_reader(reader->fpath, reader->buff_size, 
+                                   reader->io_mode);
+	if (clone == NULL)
+		return NULL;
+	if (reader->io_mode == IO_MODE_MMAP){
+		// The mapping is shared, the original reader has to outlive the clone.
+		clone->map = reader->map;
+		clone->map_size = clone->file_size = reader->map_size;
+		return clone;
+	}
+	if (open_file(clone) == 0 && (clone->io_mode != IO_MODE_PREFETCH || 
+                                  start_prefetch(clone) == 0))
+		return clone;
+	close_reader(clone);
+	return NULL;
+}
+
+DLLEXPORT void close_reader(reader_t* reader){
+	if (reader == NULL)
+		return;
+	// The thread has to be stopped before the file is closed.
+	stop_prefetch(reader);
+	if (reader->fp != NULL)
+		fclose(reader->fp);
+	unmap_file(reader);
+	free(reader->buff);
+	free(reader->fpath);
+	free(reader);
+	return;
+}
+
+int reader_seek(reader_t* reader, size_t byte){
+	if (reader->io_mode != IO_MODE_FREAD){
+		// With IO_MODE_PREFETCH, the ring is moved at the next fetch.
+		if (byte > reader->file_size)
+			return -1;
+		reader->pos = byte;
+		return 0;
+	}
+	if (byte >= reader->buff_start &&
+            byte <= reader->buff_start + reader->buff_len){
+		reader->pos = byte;
+		return 0;
+	}
+	if (fseek(reader->fp, (long)byte, SEEK_SET) != 0)
+		return -1;
+	reader->buff_start = reader->pos = byte;
+	reader->buff_len = 0;
+	return 0;
+}
+
+size_t reader_tell(const reader_t* reader){
+	return reader->pos;
+}
+
+size_t reader_size(const reader_t* reader){
+	return reader->file_size;
+}
+
+void reader_set_end(reader_t* reader, size_t byte){
+	prefetch_t* prefetch = reader->prefetch;
+	reader->end = byte;
+	if (prefetch != NULL){
+		lock_monitor(prefetch->monitor);
+		prefetch->end = byte;
+		// The thread resumes reading if the range has been extended.
+		if (prefetch->seeks > 0 && prefetch->next < byte){
+			prefetch->done = 0;
+			notify_monitor(prefetch->monitor);
+		}
+		unlock_monitor(prefetch->monitor);
+	}
+	return;
+}
+
+/** Function that provides the words available in the mapping. The words are
+ *  read in place, unless the payload is not aligned to word_size: in that case
+ *  they are copied to the buffer, at most buff_size bytes at a time.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[out] words       Pointer set to the first available word.
+ *  @param[in]  word_size   The size of the words in bytes.
+ *
+ *  @return     num_words   The number of whole words available.
+ */
+static size_t map_fetch(reader_t* reader, const void** words, size_t word_size){
+	size_t available = reader->map_size - reader->pos;
+	if (reader->pos % word_size == 0){
+		*words = (const void*)(reader->map + reader->pos);
+		return available / word_size;
+	}
+	if (available > reader->buff_size)
+		available = reader->buff_size;
+	memcpy(reader->buff, reader->map + reader->pos, available);
+	reader->buff_start = reader->pos;
+	reader->buff_len = available;
+	*words = (const void*)reader->buff;
+	return available / word_size;
+}
+
+/** Function that provides the words available in the buffer, refilling it 
+ *  through fread() when less than one word is left.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[out] words       Pointer set to the first available word.
+ *  @param[in]  word_size   The size of the words in bytes.
+ *
+ *  @return     num_words   The number of whole words available.
+ */
+static size_t buff_fetch(reader_t* reader, const void** words, size_t word_size){
+	size_t offset = reader->pos - reader->buff_start;
+	size_t available = reader->buff_len - offset;
+	if (available < word_size || offset % word_size != 0){
+		// Moving the leftover bytes to the buffer beginning, so that the words
+		// are aligned, and refilling the rest of the buffer.
+		memmove(reader->buff, reader->buff + offset, available);
+		reader->buff_start = reader->pos;
+		reader->buff_len = available + fread(reader->buff + available, 1,
+                                            reader->buff_size - available,
+                                            reader->fp);
+		offset = 0;
+		available = reader->buff_len;
+	}
+	*words = (const void*)(reader->buff + offset);
+	return available / word_size;
+}
+
+size_t reader_fetch(reader_t* reader, const void** words, size_t word_size){
+	size_t num_words;
+	switch (reader->io_mode){
+		case IO_MODE_MMAP:
+			num_words = map_fetch(reader, words, word_size);
+			break;
+
+		case IO_MODE_PREFETCH:
+			num_words = prefetch_fetch(reader, words, word_size);
+			break;
+
+		default:
+			num_words = buff_fetch(reader, words, word_size);
+	}
+	// The words after the end byte are not provided.
+	if (reader->end <= reader->pos)
+		num_words = 0;
+	else if (reader->end - reader->pos < num_words * word_size)
+		num_words = (reader->end - reader->pos) / word_size;
+	return num_words;
+}
+
+void reader_consume(reader_t* reader, size_t num_bytes){
+	reader->pos += num_bytes;
+	return;
+}
+
+size_t reader_jump_header(reader_t* reader){
+	size_t bytes_read = 0;
+	const uint8_t* c;
+	uint8_t header_begins;
+	if (reader_seek(reader, 0) != 0)
+		return 0;
+	do {
+		header_begins = 1;
+		do {
+			if (reader_fetch(reader, (const void**)&c, 1) == 0)
+				return bytes_read;
+			if (header_begins && *c != HEADER_START)
+				return bytes_read;
+			header_begins = 0;
+			reader_consume(reader, 1);
+			bytes_read++;
+		} while (*c != HEADER_END);
+	} while (1);
+	return 0;
+}
+
+int reader_copy(reader_t* reader, FILE* fp_out, size_t start, size_t end){
+	if (end > reader->file_size)
+		end = reader->file_size; 
+	if (start >= end)
+		return 0; 
+	if (reader->io_mode == IO_MODE_MMAP){
+		// The bytes are written straight from the mapping.
+		if (fwrite(reader->map + start, 1, end - start, fp_out) != end - start)
+			return -1; 
+		return 0; 
+	}
+#ifdef HAS_COPY_FILE_RANGE
+	// The bytes are moved by the kernel, without being copied to user space. 
+	// The file offset of the input is not changed.
+	if (fflush(fp_out) != 0)
+		return -1; 
+	loff_t offset = (loff_t) start; 
+	ssize_t copied = 0; 
+	while ((size_t) offset < end && 
+           (copied = copy_file_range(fileno(reader->fp), &offset, 
+                                     fileno(fp_out), NULL, 
+                                     end - (size_t) offset, 0)) > 0); 
+	if ((size_t) offset == end)
+		return 0; 
+	// Some file systems do not support it: the rest is copied below.
+	start = (size_t) offset; 
+#endif
+	const uint8_t* bytes; 
+	size_t num_bytes=0; 
+	if (reader_seek(reader, start) != 0)
+		return -1; 
+	while (start < end && (num_bytes = (reader->prefetch != NULL ? 
+                prefetch_fetch(reader, (const void**)&bytes, 1) : 
+                buff_fetch(reader, (const void**)&bytes, 1))) > 0){
+		if (num_bytes > end - start)
+			num_bytes = end - start; 
+		if (fwrite(bytes, 1, num_bytes, fp_out) != num_bytes)
+			return -1; 
+		reader_consume(reader, num_bytes); 
+		start += num_bytes; 
+	}
+	return start == end ? 0 : -1; 
+}
@@ -0,0 +1,193 @@
+#ifndef READER_H
+#define READER_H
+
+/** Library for buffered input.
+ *  A reader owns an open binary file and the buffer used to read it, so that
+ *  the file can be decoded through many successive calls (chunks, time
+ *  windows) without opening it, seeking and allocating the buffer every time.
+ *  The words left unconsumed at the end of a call stay in the buffer and are
+ *  reused by the following one.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "wizard.h"
+
+// I/O modes.
+// The file is read through fread() to the reader buffer.
+#define IO_MODE_FREAD 0U
+// The file is mapped to memory and the words are decoded in place.
+#define IO_MODE_MMAP 1U
+// The file is read through fread() by a background thread to a ring of 
+// blocks, and the words are decoded in place from a block while the next ones
+// are read.
+#define IO_MODE_PREFETCH 2U
+
+// Number of blocks of the ring of a reader with IO_MODE_PREFETCH.
+#define PREFETCH_BLOCKS 4U
+// Minimum size in bytes of the blocks of the ring. After a seek, the thread
+// reads the size of the reader buffer first and then doubles the reads up to
+// the block size, so that sparse accesses do not wait for whole blocks.
+#define PREFETCH_BLOCK_SIZE (1U<<20)
+
+// Number of words below which the bisections of the seek_time_<encoding>() 
+// functions scan the file linearly.
+#define SEEK_LINEAR_WORDS 4096U
+
+/** Opaque structure holding the input file and its read buffer.
+ */
+typedef struct reader_s reader_t;
+
+/** Macro for checking that the reader has been properly created.
+ *  If the reader pointer is NULL, an error is returned.
+ */
+#define CHECK_READER(reader, fpath){\
+	if (reader==NULL){\
+		fprintf(stderr, "ERROR: the input file \"%s\" could not be opened.\n",\
+                fpath);\
+		return -1;\
+	}\
+}
+
+/** Macro to check that reader_seek() executes correctly.
+ *  Used in read_<encoding>() functions.
+ */
+#define CHECK_SEEK(fn){\
+	if (fn != 0){\
+		fprintf(stderr, "ERROR: reader_seek failed.\n");\
+		return -1;\
+	}\
+}
+
+/** Macro to check that reader_seek() executes correctly.
+ *  The number of events read is set to 0.
+ *  Used in meas_<encoding>() functions.
+ */
+#define MEAS_CHECK_SEEK(fn, cargo){\
+	if (fn != 0){\
+		fprintf(stderr, "ERROR: reader_seek failed.\n");\
+		cargo->events_info.dim = 0;\
+		return;\
+	}\
+}
+
+/** Function that opens a file and allocates the buffer used to read it, or 
+ *  maps the file to memory.
+ *
+ *  @param[in]  fpath       Path to the input file.
+ *  @param[in]  buff_size   The size of the read buffer in bytes.
+ *  @param[in]  io_mode     How the file is accessed: IO_MODE_FREAD, 
+ *                          IO_MODE_MMAP or IO_MODE_PREFETCH. With 
+ *                          IO_MODE_MMAP, the buffer is used only if the words
+ *                          of the file are not aligned. With 
+ *                          IO_MODE_PREFETCH, the prefetch thread is started
+ *                          as well, and it waits for the first read.
+ *
+ *  @return     reader      The reader, or NULL if the file could not be opened,
+ *                          the buffers could not be allocated or the thread
+ *                          could not be started.
+ */
+DLLEXPORT reader_t* open_reader(const char*, size_t, uint8_t);
+
+/** Function that stops the prefetch thread, if any, closes the file and 
+ *  frees the buffers of a reader.
+ *
+ *  @param[in]  reader      The reader to be closed. NULL is accepted.
+ */
+DLLEXPORT void close_reader(reader_t*);
+
+/** Function that moves the reader to a byte of the file. If the byte is still
+ *  in the buffer, or the file is mapped to memory, no file access is 
+ *  performed.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[in]  byte        The byte offset with respect to the file beginning.
+ *
+ *  @return     status      0 on success, non zero if the file seek failed.
+ */
+int reader_seek(reader_t*, size_t);
+
+/** Function that returns the byte offset of the next unconsumed byte.
+ *
+ *  @param[in]  reader      The reader.
+ *
+ *  @return     byte        The byte offset with respect to the file beginning.
+ */
+size_t reader_tell(const reader_t*);
+
+/** Function that returns the size of the file read.
+ *
+ *  @param[in]  reader      The reader.
+ *
+ *  @return     file_size   The size of the file in bytes.
+ */
+size_t reader_size(const reader_t*);
+
+/** Function that limits the words provided by reader_fetch() to the ones 
+ *  before a byte, so that a reader can decode a portion of the file. With 
+ *  IO_MODE_PREFETCH, the prefetch thread does not read past it.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[in]  byte        The byte offset at which the reader stops; SIZE_MAX
+ *                          removes the limit.
+ */
+void reader_set_end(reader_t*, size_t);
+
+/** Function that appends a byte range of the file to an output file. On 
+ *  Linux, the bytes are moved by the kernel through copy_file_range(); with 
+ *  IO_MODE_MMAP they are written from the mapping; otherwise, they are copied 
+ *  through the read buffer. 
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[in]  fp_out      The output file pointer.
+ *  @param[in]  start       The first byte copied.
+ *  @param[in]  end         The byte ending the range (excluded).
+ *
+ *  @return     status      0 on success, non zero otherwise.
+ */
+int reader_copy(reader_t*, FILE*, size_t, size_t);
+
+/** Function that opens a new reader on the same file and with the same 
+ *  settings, starting from the file beginning. With IO_MODE_MMAP the mapping
+ *  is shared, so the original reader has to be closed after the clone; with
+ *  IO_MODE_PREFETCH the clone has its own prefetch thread.
+ *  Used to decode different portions of a file in parallel.
+ *
+ *  @param[in]  reader      The reader to be cloned.
+ *
+ *  @return     clone       The new reader, or NULL if it could not be opened.
+ */
+reader_t* reader_clone(const reader_t*);
+
+/** Function that provides the words available in the buffer, starting from
+ *  the current position. The buffer is refilled from the file only when less
+ *  than one word is left. The words are not consumed: reader_consume() has to
+ *  be called with the number of bytes actually decoded.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[out] words       Pointer set to the first available word, aligned
+ *                          to word_size.
+ *  @param[in]  word_size   The size of the words in bytes.
+ *
+ *  @return     num_words   The number of whole words available; 0 means that
+ *                          the end of the file has been reached.
+ */
+size_t reader_fetch(reader_t*, const void**, size_t);
+
+/** Function that marks bytes as consumed, moving the reader position forward.
+ *
+ *  @param[in]  reader      The reader.
+ *  @param[in]  num_bytes   The number of bytes consumed.
+ */
+void reader_consume(reader_t*, size_t);
+
+/** Function to handle binary files header through a reader.
+ *  The reader is moved to the file beginning and the header is skipped.
+ *
+ *  @param[in]  reader      The reader.
+ *
+ *  @return     bytes_read  The number of bytes read while skipping the header.
+ */
+size_t reader_jump_header(reader_t*);
+
+#endif
@@ -0,0 +1,38 @@
+#include "simd.h"
+#include <stdint.h>
+
+#define B2(n) n, n+1, n+1, n+2
+#define B4(n) B2(n), B2(n+1), B2(n+1), B2(n+2)
+#define B6(n) B4(n), B4(n+1), B4(n+1), B4(n+2)
+const uint8_t BITS_SET[256] = { B6(0), B6(1), B6(1), B6(2) }; 
+#undef B2
+#undef B4
+#undef B6
+
+// Instruction set in use; UINT8_MAX until it is detected.
+static uint8_t simd_level = UINT8_MAX;
+
+/** Function that finds the best instruction set supported by the CPU.
+ *
+ *  @return     simd        SIMD_NONE or SIMD_AVX2.
+ */
+static uint8_t detect_simd(void){
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+#endif
+	return SIMD_NONE;
+}
+
+DLLEXPORT uint8_t get_simd(void){
+	if (simd_level == UINT8_MAX)
+		simd_level = detect_simd();
+	return simd_level;
+}
+
+DLLEXPORT uint8_t set_simd(uint8_t simd){
+	const uint8_t supported = detect_simd();
+	simd_level = (simd < supported) ? simd : supported;
+	return simd_level;
+}
@@ -0,0 +1,106 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/** Library for vectorized decoding.
+ *  The decoders provide vectorized kernels for the most common words, compiled
+ *  for the instruction sets listed here and selected at runtime according to
+ *  the CPU capabilities. A scalar kernel is always available as fallback.
+ */
+
+#include <stdint.h>
+#include "wizard.h"
+
+// Instruction sets, in increasing order.
+// Scalar code only.
+#define SIMD_NONE 0U
+// AVX2 kernels (x86-64).
+#define SIMD_AVX2 1U
+
+// The AVX2 kernels are compiled only by GCC and Clang on x86, enabling the 
+// instruction set function by function, so that the rest of the library still
+// runs on any CPU.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef SIMD_X86
+/** Function that sums the 32 bits lanes of an AVX2 register.
+ *
+ *  @param[in]  v           The register.
+ *
+ *  @return     sum         The sum of the 8 unsigned lanes.
+ */
+TARGET_AVX2
+static inline size_t sum_epu32_avx2(__m256i v){
+	uint32_t lanes[8]; 
+	size_t sum=0, k=0; 
+	_mm256_storeu_si256((__m256i*)lanes, v); 
+	for (k=0; k < 8; k++)
+		sum += lanes[k]; 
+	return sum; 
+}
+#endif
+
+/** Number of bits set in each byte, used to count the events encoded by the 
+ *  mask of a vector word without testing its bits one by one.
+ */
+extern const uint8_t BITS_SET[256];
+
+/** Function that counts the bits set in the mask of a vector word.
+ *
+ *  @param[in]  mask        The mask, at most 16 bits long.
+ *
+ *  @return     num_bits    The number of bits set.
+ */
+static inline uint8_t count_bits(uint16_t mask){
+	return (uint8_t)(BITS_SET[mask & 0xFFU] + BITS_SET[mask >> 8]); 
+}
+
+/** Function that finds the lowest bit set in the mask of a vector word. 
+ *  Compiled to a single tzcnt/bsf instruction where available.
+ *
+ *  @param[in]  mask        The mask, not 0.
+ *
+ *  @return     k           The index of the lowest bit set.
+ */
+static inline uint8_t lowest_bit(uint16_t mask){
+#if defined(__GNUC__) || defined(__clang__)
+	return (uint8_t) __builtin_ctz(mask); 
+#elif defined(_MSC_VER)
+	unsigned long k; 
+	_BitScanForward(&k, mask); 
+	return (uint8_t) k; 
+#else
+	uint8_t k = 0; 
+	while (!(mask & 1U)){
+		mask >>= 1; 
+		k++; 
+	}
+	return k; 
+#endif
+}
+
+/** Function that returns the instruction set used by the decoders. The first
+ *  time it is called, the best one supported by the CPU is selected.
+ *
+ *  @return     simd        SIMD_NONE or SIMD_AVX2.
+ */
+DLLEXPORT uint8_t get_simd(void);
+
+/** Function that limits the instruction set used by the decoders, for 
+ *  instance to compare the vectorized kernels with the scalar ones.
+ *
+ *  @param[in]  simd        The best instruction set allowed.
+ *
+ *  @return     simd        The instruction set actually selected, that is the
+ *                          one requested if the CPU supports it.
+ */
+DLLEXPORT uint8_t set_simd(uint8_t);
+
+#endif
@@ -0,0 +1,219 @@
+#include "threads.h"
+#include <stdlib.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef _WIN32
+/** Structure used to adapt thread_fn_t to the Windows thread signature.
+ *
+ *  @field  fn      The function executed by the thread.
+ *  @field  arg     Its argument.
+ */
+typedef struct {
+	thread_fn_t fn;
+	void* arg;
+} thread_start_t;
+
+static DWORD WINAPI thread_start(LPVOID param){
+	thread_start_t* start = (thread_start_t*) param;
+	start->fn(start->arg);
+	return 0;
+}
+#endif
+
+int run_threads(thread_fn_t fn, void* args, size_t arg_size, size_t nthreads){
+	size_t k;
+	int status = 0;
+	uint8_t* arg_pt = (uint8_t*) args;
+#ifdef _WIN32
+	HANDLE* threads = (HANDLE*) malloc(nthreads * sizeof(HANDLE));
+	thread_start_t* starts = (thread_start_t*) malloc(nthreads * 
+                                                      sizeof(thread_start_t));
+	if (threads == NULL || starts == NULL){
+		free(threads);
+		free(starts);
+		for (k=0; k<nthreads; k++)
+			fn(arg_pt + k*arg_size);
+		return -1;
+	}
+	for (k=1; k<nthreads; k++){
+		starts[k].fn = fn;
+		starts[k].arg = arg_pt + k*arg_size;
+		threads[k] = CreateThread(NULL, 0, thread_start, &starts[k], 0, NULL);
+		if (threads[k] == NULL){
+			fn(arg_pt + k*arg_size);
+			status = -1;
+		}
+	}
+	fn(arg_pt);
+	for (k=1; k<nthreads; k++){
+		if (threads[k] != NULL){
+			WaitForSingleObject(threads[k], INFINITE);
+			CloseHandle(threads[k]);
+		}
+	}
+	free(starts);
+	free(threads);
+#else
+	pthread_t* threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+	uint8_t* started = (uint8_t*) calloc(nthreads, sizeof(uint8_t));
+	if (threads == NULL || started == NULL){
+		free(threads);
+		free(started);
+		for (k=0; k<nthreads; k++)
+			fn(arg_pt + k*arg_size);
+		return -1;
+	}
+	for (k=1; k<nthreads; k++){
+		started[k] = pthread_create(&threads[k], NULL, fn, 
+                                    arg_pt + k*arg_size) == 0;
+		if (!started[k]){
+			fn(arg_pt + k*arg_size);
+			status = -1;
+		}
+	}
+	fn(arg_pt);
+	for (k=1; k<nthreads; k++){
+		if (started[k])
+			pthread_join(threads[k], NULL);
+	}
+	free(started);
+	free(threads);
+#endif
+	return status;
+}
+
+size_t get_num_segments(size_t payload_size, size_t nthreads){
+	size_t nsegments = payload_size / MIN_SEGMENT_SIZE;
+	if (nsegments > nthreads)
+		nsegments = nthreads;
+	return nsegments > 0 ? nsegments : 1;
+}
+
+#ifdef _WIN32
+struct thread_s {
+	HANDLE handle;
+	thread_start_t start;
+};
+
+struct monitor_s {
+	SRWLOCK lock;
+	CONDITION_VARIABLE cond;
+};
+#else
+struct thread_s {
+	pthread_t handle;
+};
+
+struct monitor_s {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+#endif
+
+thread_t* start_thread(thread_fn_t fn, void* arg){
+	thread_t* thread = (thread_t*) malloc(sizeof(thread_t));
+	if (thread == NULL)
+		return NULL;
+#ifdef _WIN32
+	thread->start.fn = fn;
+	thread->start.arg = arg;
+	thread->handle = CreateThread(NULL, 0, thread_start, &thread->start, 0, 
+                                  NULL);
+	if (thread->handle == NULL){
+		free(thread);
+		return NULL;
+	}
+#else
+	if (pthread_create(&thread->handle, NULL, fn, arg) != 0){
+		free(thread);
+		return NULL;
+	}
+#endif
+	return thread;
+}
+
+void join_thread(thread_t* thread){
+	if (thread == NULL)
+		return;
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+	free(thread);
+	return;
+}
+
+monitor_t* create_monitor(void){
+	monitor_t* monitor = (monitor_t*) malloc(sizeof(monitor_t));
+	if (monitor == NULL)
+		return NULL;
+#ifdef _WIN32
+	InitializeSRWLock(&monitor->lock);
+	InitializeConditionVariable(&monitor->cond);
+#else
+	if (pthread_mutex_init(&monitor->lock, NULL) != 0){
+		free(monitor);
+		return NULL;
+	}
+	if (pthread_cond_init(&monitor->cond, NULL) != 0){
+		pthread_mutex_destroy(&monitor->lock);
+		free(monitor);
+		return NULL;
+	}
+#endif
+	return monitor;
+}
+
+void destroy_monitor(monitor_t* monitor){
+	if (monitor == NULL)
+		return;
+#ifndef _WIN32
+	pthread_cond_destroy(&monitor->cond);
+	pthread_mutex_destroy(&monitor->lock);
+#endif
+	free(monitor);
+	return;
+}
+
+void lock_monitor(monitor_t* monitor){
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&monitor->lock);
+#else
+	pthread_mutex_lock(&monitor->lock);
+#endif
+	return;
+}
+
+void unlock_monitor(monitor_t* monitor){
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&monitor->lock);
+#else
+	pthread_mutex_unlock(&monitor->lock);
+#endif
+	return;
+}
+
+void wait_monitor(monitor_t* monitor){
+#ifdef _WIN32
+	SleepConditionVariableSRW(&monitor->cond, &monitor->lock, INFINITE, 0);
+#else
+	pthread_cond_wait(&monitor->cond, &monitor->lock);
+#endif
+	return;
+}
+
+void notify_monitor(monitor_t* monitor){
+#ifdef _WIN32
+	WakeAllConditionVariable(&monitor->cond);
+#else
+	pthread_cond_broadcast(&monitor->cond);
+#endif
+	return;
+}
@@ -0,0 +1,107 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+/** Library for parallel decoding.
+ *  Minimal wrapper around POSIX threads and Windows threads, used to split the
+ *  decoding of a file among many workers and to read a file in the background
+ *  while it is decoded.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// Minimum number of bytes decoded by a thread: smaller files are split in less
+// segments than the number of threads requested.
+#define MIN_SEGMENT_SIZE (1U<<16)
+
+// Signature of the function executed by each thread.
+typedef void* (*thread_fn_t)(void*);
+
+/** Function that executes fn on nthreads arguments in parallel and waits for
+ *  all of them to finish. The k-th thread receives the pointer 
+ *  (uint8_t*)args + k*arg_size; the calling thread executes the first one.
+ *
+ *  @param[in]  fn          The function executed by each thread.
+ *  @param[in]  args        Array of the arguments of the threads.
+ *  @param[in]  arg_size    The size in bytes of each argument.
+ *  @param[in]  nthreads    The number of threads.
+ *
+ *  @return     status      0 on success, non zero if a thread could not be 
+ *                          started. In that case, its argument is processed by
+ *                          the calling thread.
+ */
+int run_threads(thread_fn_t, void*, size_t, size_t);
+
+/** Function that computes the number of segments in which a payload has to be
+ *  split, such that no segment is smaller than MIN_SEGMENT_SIZE.
+ *
+ *  @param[in]  payload_size    The number of bytes to be decoded.
+ *  @param[in]  nthreads        The number of threads requested.
+ *
+ *  @return     nsegments       The number of segments, at least 1.
+ */
+size_t get_num_segments(size_t, size_t);
+
+/** Opaque structure of a thread running in the background.
+ */
+typedef struct thread_s thread_t;
+
+/** Opaque structure of a mutex paired with a condition variable, used by a 
+ *  thread to wait for the data produced by another one.
+ */
+typedef struct monitor_s monitor_t;
+
+/** Function that starts a thread executing fn(arg) in the background.
+ *
+ *  @param[in]  fn          The function executed by the thread.
+ *  @param[in]  arg         Its argument.
+ *
+ *  @return     thread      The thread, or NULL if it could not be started.
+ */
+thread_t* start_thread(thread_fn_t, void*);
+
+/** Function that waits for a thread to finish and frees it.
+ *
+ *  @param[in]  thread      The thread. NULL is accepted.
+ */
+void join_thread(thread_t*);
+
+/** Function that creates a monitor.
+ *
+ *  @return     monitor     The monitor, or NULL if it could not be created.
+ */
+monitor_t* create_monitor(void);
+
+/** Function that frees a monitor, that must not be locked.
+ *
+ *  @param[in]  monitor     The monitor. NULL is accepted.
+ */
+void destroy_monitor(monitor_t*);
+
+/** Function that locks the mutex of a monitor.
+ *
+ *  @param[in]  monitor     The monitor.
+ */
+void lock_monitor(monitor_t*);
+
+/** Function that unlocks the mutex of a monitor.
+ *
+ *  @param[in]  monitor     The monitor.
+ */
+void unlock_monitor(monitor_t*);
+
+/** Function that releases the mutex of a monitor, locked by the caller, until
+ *  another thread calls notify_monitor(), and locks it again. The wake up can
+ *  be spurious, so the condition waited for has to be checked again.
+ *
+ *  @param[in]  monitor     The monitor.
+ */
+void wait_monitor(monitor_t*);
+
+/** Function that wakes up all the threads waiting on a monitor.
+ *
+ *  @param[in]  monitor     The monitor.
+ */
+void notify_monitor(monitor_t*);
+
+#endif
@@ -1,11 +1,8 @@
+from ctypes import c_int16, c_int32, c_int64, c_uint8, c_uint16
 from pathlib import Path
+from typing import Optional, Union
+
 import numpy as np
-from typing import Union
-from ctypes import (
-    c_int64,
-    c_int16,
-    c_uint8,
-)
 
 _ROOT_PATH = Path(__file__).resolve().parent.parent
 
@@ -22,8 +19,101 @@ _DTYPES = {
     "p": c_uint8,
 }
 
+# Fields of the events.
+_FIELDS = ("t", "x", "y", "p")
+
+# Narrowed data types of the "compact" layout, see "output.h".
+_COMPACT_DTYPES = {
+    "t": c_int32,
+    "y": c_uint16,
+    "x": c_uint16,
+    "p": c_uint8,
+}
+
+# Bit fields of the events of the "packed" layout, see "output.h".
+_PACKED_SHIFTS = {
+    "t": 0,
+    "x": 32,
+    "y": 46,
+    "p": 60,
+}
+_PACKED_MASKS = {
+    "t": 0xFFFFFFFF,
+    "x": 0x3FFF,
+    "y": 0x3FFF,
+    "p": 0xF,
+}
+
 _DEFAULT_BUFF_SIZE = 4096
 
+# I/O modes used to access the binary files, see "reader.h".
+_IO_MODES = {
+    "fread": 0,
+    "mmap": 1,
+    "prefetch": 2,
+}
+
+# Instruction sets used by the decoders, see "simd.h".
+_SIMD_LEVELS = {
+    "none": 0,
+    "avx2": 1,
+}
+
+# Layouts of the arrays returned by Wizard.read(), see "output.h".
+_LAYOUTS = {
+    "aos": 0,
+    "soa": 1,
+    "compact": 2,
+    "packed": 3,
+}
+
+# Modes of the frames returned by Wizard.read_frames() and their number of
+# channels, see "frame.h". The voxel grids have a channel for each bin.
+_FRAME_MODES = {
+    "count": 0,
+    "binary": 1,
+    "signed": 2,
+    "voxel": 3,
+    "surface": 4,
+}
+_FRAME_CHANNELS = {
+    "count": 2,
+    "binary": 2,
+    "signed": 1,
+    "surface": 2,
+}
+# Modes of the frames with float32 values instead of int32 ones.
+_FLOAT_FRAME_MODES = ("voxel", "surface")
+
+# Size in bytes of the frames filled by each call of the decoders.
+_FRAMES_BUFF_SIZE = 2**24
+
+# Size in bytes of the words used by each encoding.
+_WORD_SIZES = {
+    "dat": 8,
+    "evt2": 4,
+    "evt3": 2,
+}
+
+# Extra events that an EVT3 vectorized event can write past the array end.
+_VECT_SLACK = 12
+
+# Sidecar index files, see "index.h": suffix appended to the recording path,
+# magic bytes and version of the format.
+_INDEX_SUFFIX = ".idx"
+_INDEX_MAGIC = b"EXPIDX\x00\x00"
+_INDEX_VERSION = 4
+
+# Initial size of the array the external trigger events are collected to.
+_TRIGGERS_SIZE = 1024
+
+# Factor used to grow the output array when the file size guess is too small.
+_GROWTH_FACTOR = 1.5
+
+# Largest number of events the output array is first allocated for, so that
+# the file size guess of large recordings is reached by growing the array.
+_MAX_CAPACITY_GUESS = 2**23
+
 
 def check_file_encoding(fpath: Union[str, Path], encoding: str) -> None:
     if encoding == "dat":
@@ -76,6 +166,26 @@ def check_output_file(fpath: Union[str, Path], encoding: str) -> Union[str, Path
     return fpath
 
 
+def check_out_pattern(out_pattern: Union[str, Path], encoding: str) -> str:
+    if not (isinstance(out_pattern, str) or isinstance(out_pattern, Path)):
+        raise TypeError(
+            "ERROR: The output pattern must be a string or a pathlib.Path object."
+        )
+    out_pattern = str(Path(out_pattern).resolve())
+    try:
+        names = (out_pattern.format(0), out_pattern.format(1))
+    except (IndexError, KeyError, ValueError):
+        names = (out_pattern, out_pattern)
+    if names[0] == names[1]:
+        raise ValueError(
+            "ERROR: The output pattern must contain a field for the clip number, e.g. 'clip_{:04d}.raw'."
+        )
+    if not Path(names[0]).parent.is_dir():
+        raise NotADirectoryError("ERROR: The output file directory does not exist.")
+    check_file_encoding(names[0], encoding)
+    return out_pattern
+
+
 def check_chunk_size(chunk_size: int, encoding: str) -> int:
     if not (isinstance(chunk_size, int)):
         raise TypeError("ERROR: The chunk size must be a positive integer number.")
@@ -98,6 +208,70 @@ def check_buff_size(buff_size: int) -> int:
     return buff_size
 
 
+def check_io_mode(io_mode: str) -> str:
+    if not isinstance(io_mode, str):
+        raise TypeError("ERROR: The I/O mode must be specified as a string.")
+    io_mode = io_mode.lower()
+    if not (io_mode in _IO_MODES):
+        raise ValueError(
+            f"ERROR: The I/O mode must be one among {tuple(_IO_MODES.keys())}."
+        )
+    return io_mode
+
+
+def check_layout(layout: str) -> str:
+    if not isinstance(layout, str):
+        raise TypeError("ERROR: The layout must be specified as a string.")
+    layout = layout.lower()
+    if not (layout in _LAYOUTS):
+        raise ValueError(
+            f"ERROR: The layout must be one among {tuple(_LAYOUTS.keys())}."
+        )
+    return layout
+
+
+def check_fields(fields: Optional[tuple]) -> Optional[tuple]:
+    if fields is None:
+        return None
+    if not isinstance(fields, (tuple, list)) or not all(
+        isinstance(field, str) for field in fields
+    ):
+        raise TypeError("ERROR: The fields must be specified as a tuple of strings.")
+    fields = tuple(field.lower() for field in fields)
+    if (
+        len(fields) == 0
+        or not set(fields).issubset(_FIELDS)
+        or len(set(fields)) != len(fields)
+    ):
+        raise ValueError(
+            f"ERROR: The fields must be a non-empty subset of {_FIELDS}, without repetitions."
+        )
+    return fields
+
+
+def check_index_steps(step_events: Optional[int], step_time: Optional[int]) -> tuple:
+    if step_events is None and step_time is None:
+        raise ValueError(
+            "ERROR: At least one between the event and time steps of the index must be specified."
+        )
+    for step in (step_events, step_time):
+        if step is None:
+            continue
+        if not isinstance(step, int):
+            raise TypeError("ERROR: The index steps must be positive integers.")
+        if step <= 0:
+            raise ValueError("ERROR: The index steps must be larger than 0.")
+    return (step_events or 0, step_time or 0)
+
+
+def check_nthreads(nthreads: int) -> int:
+    if not isinstance(nthreads, int):
+        raise TypeError("ERROR: The number of threads must be a positive integer.")
+    if nthreads <= 0:
+        raise ValueError("ERROR: The number of threads must be larger than 0.")
+    return nthreads
+
+
 def check_new_duration(new_duration: int) -> int:
     if not (isinstance(new_duration, int)):
         raise TypeError(
@@ -108,6 +282,152 @@ def check_new_duration(new_duration: int) -> int:
     return new_duration
 
 
+def check_span(t_start: int, t_end: int) -> tuple:
+    if not isinstance(t_start, int) or not isinstance(t_end, int):
+        raise TypeError("ERROR: The span bounds must be integer values.")
+    if t_end <= t_start:
+        raise ValueError("ERROR: The span end must follow its start.")
+    return t_start, t_end
+
+
+def check_filter(roi: Optional[Union[tuple, list]], polarity) -> Optional[tuple]:
+    if roi is None and polarity is None:
+        return None
+    boxes = [] if roi is None else ([roi] if isinstance(roi, tuple) else roi)
+    if not isinstance(boxes, list) or not all(
+        isinstance(box, tuple)
+        and len(box) == 4
+        and all(isinstance(value, int) for value in box)
+        for box in boxes
+    ):
+        raise TypeError(
+            "ERROR: The region of interest must be a tuple of integers (x_min, x_max, y_min, y_max), or a list of them."
+        )
+    for x_min, x_max, y_min, y_max in boxes:
+        if x_min < 0 or y_min < 0 or x_max <= x_min or y_max <= y_min:
+            raise ValueError(
+                "ERROR: The region of interest bounds must be non negative, with the maximum ones (excluded) larger than the minimum ones."
+            )
+    if polarity is None:
+        return tuple(boxes), 0xFFFF
+    polarities = (polarity,) if isinstance(polarity, int) else polarity
+    if not isinstance(polarities, (tuple, list, set)) or not all(
+        isinstance(p, int) for p in polarities
+    ):
+        raise TypeError(
+            "ERROR: The polarity must be an integer value, or a collection of them."
+        )
+    if len(polarities) == 0 or not all(0 <= p < 16 for p in polarities):
+        raise ValueError("ERROR: The polarities must be in the range [0, 16).")
+    p_mask = 0
+    for p in polarities:
+        p_mask |= 1 << p
+    return tuple(boxes), p_mask
+
+
+def check_sensor_size(sensor_size: tuple) -> tuple:
+    if (
+        not isinstance(sensor_size, tuple)
+        or len(sensor_size) != 2
+        or not all(isinstance(value, int) for value in sensor_size)
+    ):
+        raise TypeError("ERROR: The sensor size must be a tuple (width, height).")
+    if sensor_size[0] <= 0 or sensor_size[1] <= 0:
+        raise ValueError("ERROR: The sensor size must be positive.")
+    return sensor_size
+
+
+def check_frame_mode(mode: str) -> str:
+    if not isinstance(mode, str):
+        raise TypeError("ERROR: The frame mode must be specified as a string.")
+    mode = mode.lower()
+    if not (mode in _FRAME_MODES):
+        raise ValueError(
+            f"ERROR: The frame mode must be one among {tuple(_FRAME_MODES.keys())}."
+        )
+    return mode
+
+
+def check_bins(bins: int) -> int:
+    if not isinstance(bins, int):
+        raise TypeError("ERROR: The number of bins must be an integer value.")
+    if bins <= 0:
+        raise ValueError("ERROR: The number of bins must be larger than 0.")
+    return bins
+
+
+def check_tau(tau: Union[int, float]) -> float:
+    if isinstance(tau, bool) or not isinstance(tau, (int, float)):
+        raise TypeError("ERROR: The decay constant must be a number.")
+    if tau <= 0:
+        raise ValueError("ERROR: The decay constant must be positive.")
+    return float(tau)
+
+
+def check_transform(
+    downscale: int,
+    t_bin: int,
+    refractory: int,
+    dedup: bool,
+    sensor_size: Optional[tuple],
+    background: int = 0,
+) -> Optional[tuple]:
+    for value in (downscale, t_bin, refractory, background):
+        if not isinstance(value, int) or isinstance(value, bool):
+            raise TypeError(
+                "ERROR: The downscale factor, time bin, refractory period and background activity window must be integer values."
+            )
+    if not isinstance(dedup, bool):
+        raise TypeError("ERROR: The deduplication flag must be a boolean.")
+    if downscale <= 0 or t_bin <= 0 or refractory < 0 or background < 0:
+        raise ValueError(
+            "ERROR: The downscale factor and time bin must be positive, the refractory period and background activity window non negative."
+        )
+    # The duplicates are the events in the refractory period of 1 us.
+    refractory = max(refractory, 1) if dedup else refractory
+    if downscale == 1 and t_bin == 1 and refractory == 0 and background == 0:
+        return None
+    if refractory == 0 and background == 0:
+        return downscale, t_bin, 0, 0, 0, 0
+    if sensor_size is None:
+        raise ValueError(
+            "ERROR: The sensor size is needed by the refractory filter, the deduplication and the background activity filter."
+        )
+    width, height = (
+        (value + downscale - 1) // downscale for value in check_sensor_size(sensor_size)
+    )
+    return downscale, t_bin, refractory, background, width, height
+
+
+def check_hot_pixels(hot_pixels: Optional[np.ndarray]) -> Optional[np.ndarray]:
+    if hot_pixels is None:
+        return None
+    if (
+        not isinstance(hot_pixels, np.ndarray)
+        or hot_pixels.dtype != np.bool_
+        or hot_pixels.ndim != 2
+    ):
+        raise TypeError(
+            "ERROR: The hot pixels must be a 2D boolean NumPy array of shape (height, width)."
+        )
+    if hot_pixels.size == 0:
+        raise ValueError("ERROR: The hot pixels mask is empty.")
+    return np.ascontiguousarray(hot_pixels)
+
+
+def check_trigger(channel: Optional[int], value: Optional[int]) -> tuple:
+    for arg in (channel, value):
+        if arg is not None and (not isinstance(arg, int) or isinstance(arg, bool)):
+            raise TypeError(
+                "ERROR: The trigger channel and value must be integer values."
+            )
+    if channel is not None and channel < 0:
+        raise ValueError("ERROR: The trigger channel must be non negative.")
+    if value is not None and value not in (0, 1):
+        raise ValueError("ERROR: The trigger value must be either 0 or 1.")
+    return channel, value
+
+
 def check_external_file(
     fpath: Union[str, Path], self_fpath: Union[str, Path], encoding: str
 ) -> Union[str, Path]:
@@ -138,3 +458,91 @@ def check_dtype_order(dtype_order: tuple) -> tuple:
             "ERROR: The dtype order must be a tuple of the form ('t', 'y', 'x', 'p')."
         )
     return dtype_order
+
+
+def unpack_events(packed: np.ndarray, t_base: int = 0) -> np.ndarray:
+    """
+    Converts the events of the "packed" layout to a structured NumPy array.
+
+    :param packed: the packed events, as returned by Wizard.read(layout="packed")["events"].
+    :param t_base: the timestamp the packed ones are relative to.
+
+    :returns: the structured NumPy array.
+    """
+    if not isinstance(packed, np.ndarray) or packed.dtype != np.uint64:
+        raise TypeError("ERROR: The packed events must be a NumPy array of uint64.")
+    # Same layout of the "event_t" structure.
+    dtype = np.dtype([(k, _DTYPES[k]) for k in ("t", "x", "y", "p")], align=True)
+    arr = np.empty((len(packed),), dtype=dtype)
+    for field in ("t", "x", "y", "p"):
+        arr[field] = (packed >> np.uint64(_PACKED_SHIFTS[field])) & np.uint64(
+            _PACKED_MASKS[field]
+        )
+    arr["t"] += t_base
+    return arr
+
+
+def find_hot_pixels(
+    counts: np.ndarray, ratio: float = 10.0, threshold: Optional[int] = None
+) -> np.ndarray:
+    """
+    Finds the hot pixels of a sensor from the number of events of each pixel.
+
+    :param counts: the number of events of each pixel, as returned by Wizard.profile_pixels().
+    :param ratio: a pixel is hot if it has more than 'ratio' times the median number of events of the pixels that have some.
+    :param threshold: if specified, a pixel is hot if it has more than 'threshold' events, and 'ratio' is ignored.
+
+    :returns: a boolean NumPy array of the same shape of 'counts', True for the hot pixels.
+    """
+    if not isinstance(counts, np.ndarray) or counts.ndim != 2:
+        raise TypeError("ERROR: The counts must be a 2D NumPy array.")
+    if threshold is None:
+        if isinstance(ratio, bool) or not isinstance(ratio, (int, float)):
+            raise TypeError("ERROR: The ratio must be a number.")
+        if ratio <= 0:
+            raise ValueError("ERROR: The ratio must be positive.")
+        active = counts[counts > 0]
+        threshold = ratio * np.median(active) if active.size > 0 else 0
+    elif isinstance(threshold, bool) or not isinstance(threshold, int):
+        raise TypeError("ERROR: The threshold must be an integer value.")
+    return counts > threshold
+
+
+def save_hot_pixels(fpath: Union[str, Path], hot_pixels: np.ndarray) -> None:
+    """
+    Saves a hot pixels mask to a text file, with the sensor size in the header followed by the (x, y) addresses of the hot pixels, one for each line, so that it can be reused for the recordings of the same camera.
+
+    :param fpath: path to the output file.
+    :param hot_pixels: the boolean NumPy array of shape (height, width), True for the hot pixels.
+    """
+    hot_pixels = check_hot_pixels(hot_pixels)
+    height, width = hot_pixels.shape
+    y, x = np.nonzero(hot_pixels)
+    np.savetxt(
+        fpath,
+        np.stack((x, y), axis=1),
+        fmt="%d",
+        header=f"sensor {width} {height}\nx y",
+    )
+    return
+
+
+def load_hot_pixels(fpath: Union[str, Path]) -> np.ndarray:
+    """
+    Loads a hot pixels mask saved by save_hot_pixels().
+
+    :param fpath: path to the input file.
+
+    :returns: the boolean NumPy array of shape (height, width), True for the hot pixels.
+    """
+    with open(fpath, "r") as fp:
+        header = fp.readline().split()
+    if len(header) != 4 or header[:2] != ["#", "sensor"]:
+        raise ValueError("ERROR: The file is not a hot pixels file.")
+    width, height = int(header[2]), int(header[3])
+    pixels = np.loadtxt(fpath, dtype=np.int64, ndmin=2).reshape((-1, 2))
+    if ((pixels < 0) | (pixels >= (width, height))).any():
+        raise ValueError("ERROR: The hot pixels are out of the sensor.")
+    hot_pixels = np.zeros((height, width), dtype=np.bool_)
+    hot_pixels[pixels[:, 1], pixels[:, 0]] = True
+    return hot_pixels
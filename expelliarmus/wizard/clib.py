@@ -6,6 +6,7 @@ from ctypes import (
     POINTER,
     Structure,
     c_char_p,
+    c_double,
     c_int,
     c_int16,
     c_int64,
@@ -14,6 +15,7 @@ from ctypes import (
     c_uint8,
     c_uint16,
     c_uint64,
+    c_void_p,
 )
 
 from numpy import zeros
@@ -40,6 +42,22 @@ class event_t(Structure):
     ]
 
 
+class trigger_t(Structure):
+    _fields_ = [
+        ("t", c_int64),
+        ("id", c_uint8),
+        ("value", c_uint8),
+    ]
+
+
+class triggers_t(Structure):
+    _fields_ = [
+        ("arr", c_void_p),
+        ("dim", c_size_t),
+        ("num", c_size_t),
+    ]
+
+
 class events_cargo_t(Structure):
     _fields_ = [
         ("dim", c_size_t),
@@ -48,6 +66,36 @@ class events_cargo_t(Structure):
         ("is_time_window", c_uint8),
         ("start_byte", c_size_t),
         ("finished", c_uint8),
+        ("filter", c_void_p),
+        ("triggers", c_void_p),
+    ]
+
+
+class box_t(Structure):
+    _fields_ = [
+        ("x_min", c_int16),
+        ("x_max", c_int16),
+        ("y_min", c_int16),
+        ("y_max", c_int16),
+    ]
+
+
+class filter_t(Structure):
+    _fields_ = [
+        ("p_mask", c_uint16),
+        ("num_boxes", c_size_t),
+        ("boxes", POINTER(box_t)),
+        ("hot_pixels", c_void_p),
+        ("mask_width", c_size_t),
+        ("mask_height", c_size_t),
+        ("scale", c_uint16),
+        ("t_bin", c_int64),
+        ("refractory", c_int64),
+        ("background", c_int64),
+        ("width", c_size_t),
+        ("height", c_size_t),
+        ("last_t", c_void_p),
+        ("support_t", c_void_p),
     ]
 
 
@@ -81,7 +129,91 @@ class evt3_cargo_t(Structure):
 
 c_cargos_t = dict(dat=dat_cargo_t, evt2=evt2_cargo_t, evt3=evt3_cargo_t)
 
+
+class columns_t(Structure):
+    _fields_ = [
+        ("layout", c_uint8),
+        ("t_base", c_int64),
+        ("has_t_base", c_uint8),
+        ("t", c_void_p),
+        ("x", c_void_p),
+        ("y", c_void_p),
+        ("p", c_void_p),
+        ("packed", c_void_p),
+    ]
+
+
+class frames_t(Structure):
+    _fields_ = [
+        ("mode", c_uint8),
+        ("width", c_size_t),
+        ("height", c_size_t),
+        ("time_window", c_int64),
+        ("event_count", c_size_t),
+        ("t_next", c_int64),
+        ("has_t_next", c_uint8),
+        ("bins", c_size_t),
+        ("tau", c_double),
+        ("last_t", c_void_p),
+        ("arr", c_void_p),
+        ("t_start", c_void_p),
+        ("dim", c_size_t),
+    ]
+
+
+class index_t(Structure):
+    _fields_ = [
+        ("step_events", c_size_t),
+        ("step_time", c_int64),
+        ("ordinal", c_uint64),
+        ("since_entry", c_uint64),
+        ("entry_t", c_int64),
+        ("last_t", c_int64),
+        ("has_entry", c_uint8),
+        ("entries", c_void_p),
+        ("dim", c_size_t),
+    ]
+
+
+class range_t(Structure):
+    _fields_ = [
+        ("skip", c_uint64),
+        ("count", c_uint64),
+        ("t_start", c_int64),
+        ("t_end", c_int64),
+        ("done", c_uint8),
+    ]
+
+
+class split_t(Structure):
+    _fields_ = [
+        ("duration", c_int64),
+        ("t_next", c_int64),
+        ("has_t_next", c_uint8),
+        ("fpaths", POINTER(c_char_p)),
+        ("dim", c_size_t),
+    ]
+
+
 # Setting up C wrappers.
+# Reader functions.
+c_open_reader = clib.open_reader
+c_open_reader.argtypes = [c_char_p, c_size_t, c_uint8]
+c_open_reader.restype = c_void_p
+
+c_close_reader = clib.close_reader
+c_close_reader.argtypes = [c_void_p]
+c_close_reader.restype = None
+
+# SIMD functions.
+c_get_simd = clib.get_simd
+c_get_simd.argtypes = []
+c_get_simd.restype = c_uint8
+
+c_set_simd = clib.set_simd
+c_set_simd.argtypes = [c_uint8]
+c_set_simd.restype = c_uint8
+
 # Read functions.
 c_read_dat = clib.read_dat
 c_read_evt2 = clib.read_evt2
@@ -91,15 +223,171 @@ for fn, cargo_t in zip(
     (c_read_dat, c_read_evt2, c_read_evt3), (dat_cargo_t, evt2_cargo_t, evt3_cargo_t)
 ):
     fn.argtypes = [
-        c_char_p,
+        c_void_p,
         ndpointer(ndim=1),
         POINTER(cargo_t),
-        c_size_t,
     ]
     fn.restype = c_int
 
 c_read_fns = dict(dat=c_read_dat, evt2=c_read_evt2, evt3=c_read_evt3)
 
+c_read_dat_columns = clib.read_dat_columns
+c_read_evt2_columns = clib.read_evt2_columns
+c_read_evt3_columns = clib.read_evt3_columns
+
+for fn, cargo_t in zip(
+    (c_read_dat_columns, c_read_evt2_columns, c_read_evt3_columns),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        POINTER(columns_t),
+        POINTER(cargo_t),
+    ]
+    fn.restype = c_int
+
+c_read_columns_fns = dict(
+    dat=c_read_dat_columns, evt2=c_read_evt2_columns, evt3=c_read_evt3_columns
+)
+
+c_read_dat_frames = clib.read_dat_frames
+c_read_evt2_frames = clib.read_evt2_frames
+c_read_evt3_frames = clib.read_evt3_frames
+
+for fn, cargo_t in zip(
+    (c_read_dat_frames, c_read_evt2_frames, c_read_evt3_frames),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        POINTER(frames_t),
+        POINTER(cargo_t),
+    ]
+    fn.restype = c_int
+
+c_read_frames_fns = dict(
+    dat=c_read_dat_frames, evt2=c_read_evt2_frames, evt3=c_read_evt3_frames
+)
+
+c_read_dat_frames_parallel = clib.read_dat_frames_parallel
+c_read_evt2_frames_parallel = clib.read_evt2_frames_parallel
+c_read_evt3_frames_parallel = clib.read_evt3_frames_parallel
+
+for fn, cargo_t in zip(
+    (
+        c_read_dat_frames_parallel,
+        c_read_evt2_frames_parallel,
+        c_read_evt3_frames_parallel,
+    ),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        POINTER(frames_t),
+        POINTER(cargo_t),
+        c_size_t,
+    ]
+    fn.restype = c_int
+
+c_read_frames_parallel_fns = dict(
+    dat=c_read_dat_frames_parallel,
+    evt2=c_read_evt2_frames_parallel,
+    evt3=c_read_evt3_frames_parallel,
+)
+
+# Index functions.
+c_index_dat = clib.index_dat
+c_index_evt2 = clib.index_evt2
+c_index_evt3 = clib.index_evt3
+
+for fn, cargo_t in zip(
+    (c_index_dat, c_index_evt2, c_index_evt3),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        POINTER(index_t),
+        POINTER(cargo_t),
+    ]
+    fn.restype = c_int
+
+c_index_fns = dict(dat=c_index_dat, evt2=c_index_evt2, evt3=c_index_evt3)
+
+# Pixel profile functions.
+c_profile_dat = clib.profile_dat
+c_profile_evt2 = clib.profile_evt2
+c_profile_evt3 = clib.profile_evt3
+
+for fn, cargo_t in zip(
+    (c_profile_dat, c_profile_evt2, c_profile_evt3),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        c_void_p,
+        c_size_t,
+        c_size_t,
+        POINTER(cargo_t),
+    ]
+    fn.restype = c_int
+
+c_profile_fns = dict(dat=c_profile_dat, evt2=c_profile_evt2, evt3=c_profile_evt3)
+
+# Range read functions.
+c_read_dat_range = clib.read_dat_range
+c_read_evt2_range = clib.read_evt2_range
+c_read_evt3_range = clib.read_evt3_range
+
+for fn, cargo_t in zip(
+    (c_read_dat_range, c_read_evt2_range, c_read_evt3_range),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        c_void_p,
+        POINTER(range_t),
+        POINTER(cargo_t),
+    ]
+    fn.restype = c_int
+
+c_read_range_fns = dict(
+    dat=c_read_dat_range, evt2=c_read_evt2_range, evt3=c_read_evt3_range
+)
+
+# Seek functions; EVT3 has no absolute timestamp to bisect on.
+c_seek_time_dat = clib.seek_time_dat
+c_seek_time_evt2 = clib.seek_time_evt2
+
+for fn, cargo_t in zip(
+    (c_seek_time_dat, c_seek_time_evt2),
+    (dat_cargo_t, evt2_cargo_t),
+):
+    fn.argtypes = [c_void_p, POINTER(cargo_t), c_int64]
+    fn.restype = c_int
+
+c_seek_time_fns = dict(dat=c_seek_time_dat, evt2=c_seek_time_evt2)
+
+# Parallel read functions.
+c_read_dat_parallel = clib.read_dat_parallel
+c_read_evt2_parallel = clib.read_evt2_parallel
+c_read_evt3_parallel = clib.read_evt3_parallel
+
+for fn, cargo_t in zip(
+    (c_read_dat_parallel, c_read_evt2_parallel, c_read_evt3_parallel),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        ndpointer(ndim=1),
+        POINTER(cargo_t),
+        c_size_t,
+    ]
+    fn.restype = c_int
+
+c_read_parallel_fns = dict(
+    dat=c_read_dat_parallel, evt2=c_read_evt2_parallel, evt3=c_read_evt3_parallel
+)
+
 # Compression functions.
 c_save_dat = clib.save_dat
 c_save_evt2 = clib.save_evt2
@@ -131,6 +419,39 @@ for fn in (c_cut_dat, c_cut_evt2, c_cut_evt3):
 
 c_cut_fns = dict(dat=c_cut_dat, evt2=c_cut_evt2, evt3=c_cut_evt3)
 
+# Span cut functions.
+c_cut_dat_span = clib.cut_dat_span
+c_cut_evt2_span = clib.cut_evt2_span
+c_cut_evt3_span = clib.cut_evt3_span
+for fn, cargo_t in zip(
+    (c_cut_dat_span, c_cut_evt2_span, c_cut_evt3_span),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [
+        c_void_p,
+        c_char_p,
+        POINTER(cargo_t),
+        POINTER(cargo_t),
+        c_int64,
+        c_int64,
+    ]
+    fn.restype = c_int
+
+c_cut_span_fns = dict(dat=c_cut_dat_span, evt2=c_cut_evt2_span, evt3=c_cut_evt3_span)
+
+# Split functions.
+c_split_dat = clib.split_dat
+c_split_evt2 = clib.split_evt2
+c_split_evt3 = clib.split_evt3
+for fn, cargo_t in zip(
+    (c_split_dat, c_split_evt2, c_split_evt3),
+    (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
+):
+    fn.argtypes = [c_void_p, POINTER(split_t), POINTER(cargo_t)]
+    fn.restype = c_int
+
+c_split_fns = dict(dat=c_split_dat, evt2=c_split_evt2, evt3=c_split_evt3)
+
 # Measure functions.
 c_measure_dat = clib.measure_dat
 c_measure_evt2 = clib.measure_evt2
@@ -139,7 +460,7 @@ for fn, cargo_t in zip(
     (c_measure_dat, c_measure_evt2, c_measure_evt3),
     (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
 ):
-    fn.argtypes = [c_char_p, POINTER(cargo_t), c_size_t]
+    fn.argtypes = [c_void_p, POINTER(cargo_t)]
     fn.restype = None
 
 c_measure_fns = dict(dat=c_measure_dat, evt2=c_measure_evt2, evt3=c_measure_evt3)
@@ -152,7 +473,7 @@ for fn, cargo_t in zip(
     (c_get_time_window_dat, c_get_time_window_evt2, c_get_time_window_evt3),
     (dat_cargo_t, evt2_cargo_t, evt3_cargo_t),
 ):
-    fn.argtypes = [c_char_p, POINTER(cargo_t), c_size_t]
+    fn.argtypes = [c_void_p, POINTER(cargo_t)]
     fn.restype = None
 
 c_get_time_window_fns = dict(
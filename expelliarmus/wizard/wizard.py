@@ -1,32 +1,69 @@
+import os
 import pathlib
 import shutil
-from ctypes import Structure, c_size_t
+from ctypes import Structure, addressof, c_size_t
 from typing import Optional, Union
 
+from numpy import concatenate
 from numpy import dtype as np_dtype
-from numpy import ndarray
+from numpy import empty, ndarray, searchsorted
 
 from expelliarmus.utils import (
     _DEFAULT_BUFF_SIZE,
     _DTYPES,
+    check_bins,
     check_buff_size,
     check_chunk_size,
     check_dtype_order,
     check_encoding,
     check_external_file,
+    check_fields,
     check_file_encoding,
+    check_filter,
+    check_frame_mode,
+    check_hot_pixels,
+    check_index_steps,
     check_input_file,
+    check_io_mode,
+    check_layout,
     check_new_duration,
+    check_nthreads,
+    check_out_pattern,
     check_output_file,
+    check_sensor_size,
+    check_span,
+    check_tau,
     check_time_window,
+    check_transform,
+    check_trigger,
+)
+from expelliarmus.wizard.clib import (
+    c_cargos_t,
+    c_seek_time_fns,
+    event_t,
+    events_cargo_t,
+    range_t,
 )
-from expelliarmus.wizard.clib import c_cargos_t, events_cargo_t
 from expelliarmus.wizard.wizard_wrapper import (
+    c_build_index_wrapper,
+    c_cut_span_wrapper,
     c_cut_wrapper,
+    c_filter_wrapper,
+    c_frames_wrapper,
+    c_profile_wrapper,
     c_read_chunk_wrapper,
+    c_read_columns_wrapper,
+    c_read_frames_wrapper,
+    c_read_range_wrapper,
     c_read_time_window_wrapper,
     c_read_wrapper,
+    c_reader_wrapper,
     c_save_wrapper,
+    c_seek_time_wrapper,
+    c_split_wrapper,
+    c_triggers_wrapper,
+    load_index,
+    save_index,
 )
 
 
@@ -39,6 +76,8 @@ class Wizard:
     :param buff_size: the size of the buffer used to read the binary file.
     :param chunk_size: the chunk lenght when reading files in chunks.
     :param time_window: the time window length in microseconds when reading files in time chunks.
+    :param io_mode: how the binary file is accessed: "fread" copies it to a buffer of 'buff_size' words, "mmap" maps it to memory and decodes it in place, while "prefetch" reads it in a background thread while the events are decoded.
+    :param nthreads: the number of threads used to decode the whole file in read(), and to fill the frames in read_frames().
     """
 
     def __init__(
@@ -48,10 +87,18 @@ class Wizard:
         chunk_size: Optional[int] = 8192,
         time_window: Optional[int] = 10,
         buff_size: Optional[int] = _DEFAULT_BUFF_SIZE,
+        io_mode: Optional[str] = "fread",
+        nthreads: Optional[int] = 1,
     ) -> None:
         self._encoding = check_encoding(encoding)
+        self._selection, self._transform = None, None
+        self._hot_pixels = None
+        self._filter = None
+        self._index = None
         self.cargo = self._get_cargo()
         self.set_buff_size(buff_size)
+        self.set_io_mode(io_mode)
+        self.set_nthreads(nthreads)
         if fpath:
             self.set_file(fpath)
         else:
@@ -105,6 +152,24 @@ class Wizard:
         """
         return self._time_window
 
+    @property
+    def io_mode(self) -> str:
+        """
+        How the binary files are accessed, either "fread", "mmap" or "prefetch".
+
+        :returns: the I/O mode.
+        """
+        return self._io_mode
+
+    @property
+    def nthreads(self) -> int:
+        """
+        The number of threads used to read a whole file.
+
+        :returns: the number of threads.
+        """
+        return self._nthreads
+
     @encoding.setter
     def encoding(self, value):
         raise AttributeError("ERROR: Denied setting of private attribute encoding.")
@@ -125,8 +190,35 @@ class Wizard:
     def time_window(self, value):
         raise AttributeError("ERROR: Denied setting of private attribute time_window.")
 
+    @io_mode.setter
+    def io_mode(self, value):
+        raise AttributeError("ERROR: Denied setting of private attribute io_mode.")
+
+    @nthreads.setter
+    def nthreads(self, value):
+        raise AttributeError("ERROR: Denied setting of private attribute nthreads.")
+
     def _get_cargo(self) -> object:
-        return c_cargos_t[self.encoding](events_info=events_cargo_t())
+        return self._set_cargo_filter(
+            c_cargos_t[self.encoding](events_info=events_cargo_t())
+        )
+
+    def _get_filter(self) -> Optional[Structure]:
+        # Each filter has its own refractory state.
+        if (
+            self._selection is None
+            and self._transform is None
+            and self._hot_pixels is None
+        ):
+            return None
+        return c_filter_wrapper(self._selection, self._transform, self._hot_pixels)
+
+    def _set_cargo_filter(
+        self, cargo: Structure, c_filter: Optional[Structure] = None
+    ) -> Structure:
+        c_filter = c_filter if c_filter is not None else self._filter
+        cargo.events_info.filter = addressof(c_filter) if c_filter is not None else None
+        return cargo
 
     def set_file(self, fpath: Union[str, pathlib.Path]) -> None:
         """
@@ -172,6 +264,101 @@ class Wizard:
         self.reset()
         return
 
+    def set_io_mode(self, io_mode: str) -> None:
+        """
+        Sets how the binary files are accessed.
+
+        :param io_mode: "fread" to read the file through a buffer of 'buff_size' words, "mmap" to map it to memory and decode it in place, "prefetch" to read it in a background thread that keeps a few blocks of the file ahead of the decoder, which decodes them in place. The latter pays off on slow storage (e.g. network file systems) and when the file is not in the page cache: the next blocks are read while the events are decoded and, since read_chunk() and read_time_window() keep their reader open for the whole iteration, also while each chunk is processed by the caller.
+        """
+        self._io_mode = check_io_mode(io_mode)
+        self.reset()
+        return
+
+    def set_nthreads(self, nthreads: int) -> None:
+        """
+        Sets the number of threads used by read() to decode a whole file, which is split in segments that are decoded in parallel, and by read_frames() to fill the frames of fixed duration, which are split in runs.
+
+        :param nthreads: the number of threads.
+        """
+        self._nthreads = check_nthreads(nthreads)
+        return
+
+    def set_filter(
+        self,
+        roi: Optional[Union[tuple, list]] = None,
+        polarity: Optional[Union[int, tuple, list]] = None,
+    ) -> None:
+        """
+        Sets the filter applied while decoding the events in read(), read_chunk(), read_time_window() and read_range(): the events outside of the regions of interest or with another polarity are dropped by the decoders, and the chunks and time windows are made of the events kept. The Wizard is reset. Call it without arguments to remove the filter.
+        WARNING: with a filter, read() decodes the file twice (to count the events kept and to fill the array) and always by a single thread.
+
+        :param roi: the region of interest (x_min, x_max, y_min, y_max), with the maximum addresses excluded, or a list of them to keep the events in any of the regions.
+        :param polarity: the polarity to be kept, or a collection of them.
+        """
+        self._selection = check_filter(roi, polarity)
+        self.reset()
+        return
+
+    def set_transform(
+        self,
+        downscale: int = 1,
+        t_bin: int = 1,
+        refractory: int = 0,
+        dedup: bool = False,
+        sensor_size: Optional[tuple] = None,
+        background: int = 0,
+    ) -> None:
+        """
+        Sets the transforms applied while decoding the events, after the filter set by set_filter(), in read(), read_chunk(), read_time_window() and read_range(), so that the full resolution events are never stored. The Wizard is reset. Call it without arguments to remove the transforms.
+        The state of the refractory and background activity filters is carried across the calls of the read_chunk() and read_time_window() generators, and reset by reset() and seek().
+        WARNING: with the refractory filter, the deduplication or the background activity filter, the read_time_window() generator copies their state for each window.
+
+        :param downscale: the factor dividing the X and Y addresses.
+        :param t_bin: the width of the bins the timestamps are floored to [us].
+        :param refractory: the period following an event in which the events of the same pixel and polarity are dropped [us], after the addresses and timestamps have been transformed.
+        :param dedup: whether to drop the events identical to a previous one after the addresses and timestamps have been transformed.
+        :param sensor_size: the (width, height) of the sensor, needed by the refractory filter, the deduplication and the background activity filter. The events out of it are not dropped by them.
+        :param background: the background activity filter window [us]: an event is dropped unless one of the 8 neighbouring pixels has had an event, of any polarity, in the previous 'background' microseconds. Applied last, to the transformed events that pass the rest of the filter; 0 to disable it.
+        """
+        self._transform = check_transform(
+            downscale, t_bin, refractory, dedup, sensor_size, background
+        )
+        self.reset()
+        return
+
+    def set_hot_pixels(self, hot_pixels: Optional[ndarray] = None) -> None:
+        """
+        Sets the hot pixels whose events are dropped by the decoders, together with the filter set by set_filter(), so that they never reach the output. The Wizard is reset. Call it without arguments to keep all the pixels.
+        The mask can be found with profile_pixels() and expelliarmus.utils.find_hot_pixels(), and reused for the recordings of the same camera through expelliarmus.utils.save_hot_pixels() and load_hot_pixels().
+
+        :param hot_pixels: a boolean NumPy array of shape (height, width) of the sensor, True for the hot pixels; the events out of it are kept.
+        """
+        self._hot_pixels = check_hot_pixels(hot_pixels)
+        self.reset()
+        return
+
+    def profile_pixels(self, sensor_size: tuple) -> ndarray:
+        """
+        Counts the events of each pixel of the input file, of both polarities, in a single pass that does not store them and ignores the filters, so that the hot pixels can be found with expelliarmus.utils.find_hot_pixels().
+
+        :param sensor_size: the (width, height) of the sensor; the events out of it are not counted.
+
+        :returns: a uint32 NumPy array of shape (height, width) with the number of events of each pixel.
+        """
+        sensor_size = check_sensor_size(sensor_size)
+        if self.fpath is None:
+            raise ValueError("ERROR: An input file must be set.")
+        counts, status = c_profile_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+            sensor_size=sensor_size,
+        )
+        if status != 0:
+            raise RuntimeError("ERROR: Something went wrong while profiling the file.")
+        return counts
+
     def set_time_window(self, time_window: int, do_reset: bool = True) -> None:
         """
         Sets the time window length.
@@ -190,54 +377,355 @@ class Wizard:
         """
         if self.cargo:
             del self.cargo
+        self._filter = self._get_filter()
         self.cargo = self._get_cargo()
         return
 
+    def build_index(
+        self, step_events: Optional[int] = 65536, step_time: Optional[int] = None
+    ) -> pathlib.Path:
+        """
+        Builds the index of the input file in a single pass and saves it to a sidecar file, named as the input file followed by '.idx'. Each entry is a resume point, from which the file can be decoded without reading what precedes it; the sidecar is reused by any Wizard reading the same file, until the latter is modified.
+
+        :param step_events: an entry is added every 'step_events' events.
+        :param step_time: an entry is added every 'step_time' microseconds (with a resolution of about one thousand events).
+
+        :returns: the path to the sidecar file.
+        """
+        if self.fpath is None:
+            raise ValueError("ERROR: An input file must be set.")
+        step_events, step_time = check_index_steps(step_events, step_time)
+        entries = self._build_index(step_events, step_time)
+        return save_index(self.encoding, self.fpath, entries, step_events, step_time)
+
+    def load_index(self) -> Optional[ndarray]:
+        """
+        Loads the index of the input file from its sidecar file.
+
+        :returns: a structured NumPy array with an entry for each resume point ('ordinal', the number of events preceding it, 't', the timestamp of the first event following it, and 'cargo', the decoder state), or None if the sidecar does not exist or is out of date.
+        """
+        if self.fpath is None:
+            raise ValueError("ERROR: An input file must be set.")
+        return load_index(self.encoding, self.fpath)
+
+    def seek(self, t: int) -> Optional[int]:
+        """
+        Moves the read_chunk() and read_time_window() generators to the last resume point of the index whose first event has a timestamp not larger than 't'. Without an up to date sidecar file, DAT and EVT2 files are bisected on their timestamps, so that only a few buffers are read, while for EVT3 files the index is built with the default steps and kept in memory, without writing a sidecar file.
+
+        :param t: the timestamp to be reached [us].
+
+        :returns: the number of events preceding the resume point, or None if it is unknown because the file has been bisected.
+        """
+        if not isinstance(t, int):
+            raise TypeError("ERROR: The timestamp must be an integer value.")
+        self._filter = self._get_filter()
+        entries = self._get_index(bisectable=True)
+        if entries is None:
+            self.cargo = self._set_cargo_filter(self._seek_time(t))
+            return None
+        k = max(int(searchsorted(entries["t"], t, side="right")) - 1, 0)
+        self.cargo = self._set_cargo_filter(self._get_entry_cargo(entries, k))
+        return int(entries["ordinal"][k])
+
+    def read_range(self, t_start: int, t_end: int) -> ndarray:
+        """
+        Reads the events with a timestamp in [t_start, t_end), decoding the file from the last resume point of the index preceding t_start. The index is built with the default steps if no up to date sidecar file exists, and kept in memory without writing a sidecar file.
+
+        Without an up to date sidecar file, DAT and EVT2 files are bisected on their timestamps instead.
+
+        :param t_start: the first timestamp of the range [us].
+        :param t_end: the timestamp ending the range, excluded [us].
+
+        :returns: structured NumPy array of events.
+        """
+        if not isinstance(t_start, int) or not isinstance(t_end, int):
+            raise TypeError("ERROR: The range bounds must be integer values.")
+        if t_end <= t_start:
+            raise ValueError("ERROR: The range end must follow its start.")
+        c_range = range_t(skip=0, count=2**64 - 1, t_start=t_start, t_end=t_end, done=0)
+        # The generators are not affected by the range read.
+        c_filter = self._get_filter()
+        entries = self._get_index(bisectable=True)
+        if entries is None:
+            return self._read_range(
+                self._set_cargo_filter(self._seek_time(t_start), c_filter),
+                c_range,
+                None,
+            )
+        # All the events preceding an entry have a timestamp not larger than
+        # its one, hence the entry must have a timestamp smaller than t_start.
+        k = max(int(searchsorted(entries["t"], t_start, side="left")) - 1, 0)
+        k_end = int(searchsorted(entries["t"], t_end, side="left"))
+        capacity = (
+            int(entries["ordinal"][k_end] - entries["ordinal"][k])
+            if k_end < len(entries)
+            else None
+        )
+        return self._read_range(
+            self._set_cargo_filter(self._get_entry_cargo(entries, k), c_filter),
+            c_range,
+            capacity,
+        )
+
+    def read_events(self, first: int, count: int) -> ndarray:
+        """
+        Reads 'count' events starting from the one in position 'first', decoding the file from the last resume point of the index preceding it. The index is built with the default steps if no up to date sidecar file exists, and kept in memory without writing a sidecar file.
+
+        :param first: the position of the first event in the recording.
+        :param count: the number of events to be read.
+
+        :returns: structured NumPy array of events, shorter than 'count' if the file ends before.
+        """
+        if not isinstance(first, int) or not isinstance(count, int):
+            raise TypeError("ERROR: The first event and count must be integer values.")
+        if first < 0 or count <= 0:
+            raise ValueError(
+                "ERROR: The first event must be non negative and the count positive."
+            )
+        entries = self._get_index()
+        k = int(searchsorted(entries["ordinal"], first, side="right")) - 1
+        c_range = range_t(
+            skip=first - int(entries["ordinal"][k]),
+            count=count,
+            t_start=-(2**63),
+            t_end=2**63 - 1,
+            done=0,
+        )
+        return self._read_range(self._get_entry_cargo(entries, k), c_range, count)
+
+    def _get_index(self, bisectable: bool = False) -> Optional[ndarray]:
+        # The index built here is kept in memory only: the sidecar is written
+        # by build_index(), when it is explicitly requested.
+        key = self._get_index_key()
+        if self._index is not None and self._index[0] == key:
+            return self._index[1]
+        entries = self.load_index()
+        # The files that can be bisected do not need the index to be built.
+        if entries is None and not (bisectable and self.encoding in c_seek_time_fns):
+            entries = self._build_index(*check_index_steps(65536, None))
+        if entries is not None:
+            self._index = (key, entries)
+        return entries
+
+    def _get_index_key(self) -> tuple:
+        # An index is valid as long as the recording is not modified.
+        stat = os.stat(self.fpath)
+        return (self.encoding, str(self.fpath), stat.st_size, stat.st_mtime_ns)
+
+    def _build_index(self, step_events: int, step_time: int) -> ndarray:
+        entries, status = c_build_index_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+            step_events=step_events,
+            step_time=step_time,
+        )
+        if status != 0:
+            raise RuntimeError("ERROR: Something went wrong while indexing the file.")
+        self._index = (self._get_index_key(), entries)
+        return entries
+
+    def _get_entry_cargo(self, entries: ndarray, k: int) -> Structure:
+        cargo = c_cargos_t[self.encoding].from_buffer_copy(
+            entries["cargo"][k].tobytes()
+        )
+        # Only the decoder state and the byte to resume from are restored:
+        # the pointers and the read bookkeeping are those of this process.
+        start_byte = cargo.events_info.start_byte
+        cargo.events_info = events_cargo_t()
+        cargo.events_info.start_byte = start_byte
+        return cargo
+
+    def _locate(self, t: int) -> Structure:
+        # A cargo preceding the first event with timestamp t or larger.
+        entries = self._get_index(bisectable=True)
+        if entries is None:
+            return self._seek_time(t)
+        k = max(int(searchsorted(entries["t"], t, side="left")) - 1, 0)
+        return self._get_entry_cargo(entries, k)
+
+    def _seek_time(self, t: int) -> Structure:
+        cargo, status = c_seek_time_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+            t=t,
+        )
+        if status != 0:
+            raise RuntimeError("ERROR: Something went wrong while seeking the file.")
+        return cargo
+
+    def _read_range(
+        self,
+        cargo: Structure,
+        c_range: Structure,
+        capacity: Optional[int],
+    ) -> ndarray:
+        arr, status = c_read_range_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+            cargo=cargo,
+            c_range=c_range,
+            capacity=capacity or self.chunk_size,
+        )
+        if status != 0:
+            raise RuntimeError(
+                "ERROR: Something went wrong while reading the range from the file."
+            )
+        return arr
+
     def cut(
         self,
         fpath_out: Union[str, pathlib.Path],
-        new_duration: int,
+        new_duration: Optional[int] = None,
         fpath_in: Optional[Union[str, pathlib.Path]] = None,
+        t_start: Optional[int] = None,
+        t_end: Optional[int] = None,
     ) -> int:
         """
-        Cuts the duration of the recording contained in 'fpath_in' to 'new_duration' and saves the result to 'fpath_out'.
+        Cuts the recording contained in 'fpath_in' and saves the result to 'fpath_out', keeping either its first 'new_duration' microseconds or the events with a timestamp in [t_start, t_end). A span is located through the index, or by bisection for DAT and EVT2 files without one (see seek()), and its bytes are copied without being decoded after a few words restoring the decoder state, so that the cost does not depend on the length of the recording once it is located. EVT3 files cannot be bisected, since their timestamp overflows are only known decoding them from the beginning: without an up to date sidecar file, the first span cut decodes the whole recording to build the index, which is then kept in memory. Call build_index() beforehand to cut spans of large EVT3 recordings without this pass. The timestamp overflows are not encoded in DAT words and EVT3 state words, so the timestamps of a span following one are decoded modulo 2^32 for DAT files and shifted back by a multiple of 4096 for EVT3 files.
 
         :param fpath_in: path to input file.
         :param fpath_out: path to output file.
         :param new_duration: the desired duration, expressed in microseconds.
+        :param t_start: the first timestamp of the span [us].
+        :param t_end: the timestamp ending the span, excluded [us].
 
-        :returns: the number of events encoded in the output file.
+        :returns: the number of events encoded in the output file. The events of a span are counted on the output file, through the word counting used by read(), so that the cost stays proportional to the bytes copied.
         """
         fpath_in = check_external_file(fpath_in, self.fpath, self.encoding)
         fpath_out = check_output_file(fpath=fpath_out, encoding=self.encoding)
-        new_duration = check_new_duration(new_duration)
-        nevents = c_cut_wrapper(
+        if t_start is None and t_end is None:
+            new_duration = check_new_duration(new_duration)
+            nevents = c_cut_wrapper(
+                encoding=self.encoding,
+                fpath_in=fpath_in,
+                fpath_out=fpath_out,
+                new_duration=new_duration,
+                buff_size=self.buff_size,
+            )
+            return nevents
+        if new_duration is not None:
+            raise ValueError(
+                "ERROR: Either a new duration or a span must be provided, not both."
+            )
+        t_start, t_end = check_span(t_start, t_end)
+        # The index or the bisection are the ones of the input file.
+        wizard = self
+        if self.fpath is None or pathlib.Path(fpath_in) != pathlib.Path(self.fpath):
+            wizard = Wizard(
+                encoding=self.encoding,
+                fpath=fpath_in,
+                buff_size=self.buff_size,
+                io_mode=self.io_mode,
+            )
+        nevents, status = c_cut_span_wrapper(
             encoding=self.encoding,
             fpath_in=fpath_in,
             fpath_out=fpath_out,
-            new_duration=new_duration,
             buff_size=self.buff_size,
+            io_mode=self.io_mode,
+            start=wizard._locate(t_start),
+            end=wizard._locate(t_end),
+            t_start=t_start,
+            t_end=t_end,
         )
+        if status != 0:
+            raise RuntimeError("ERROR: Something went wrong while cutting the file.")
         return nevents
 
-    def read(self, fpath: Optional[Union[str, pathlib.Path]] = None) -> ndarray:
+    def split(
+        self,
+        out_pattern: Union[str, pathlib.Path],
+        duration: int,
+        fpath_in: Optional[Union[str, pathlib.Path]] = None,
+    ) -> list:
         """
-        Reads a binary file to a structured NumPy of events.
+        Splits the recording contained in 'fpath_in' in clips of 'duration' microseconds, the first one starting at the first event, in a single pass over the file. The bytes of each clip are copied without being decoded after the header and a few words restoring the decoder state, so that each clip can be read on its own; the clips without events are written as well. The timestamp overflows are not encoded in DAT words and EVT3 state words, so the timestamps of the clips following one are decoded modulo 2^32 for DAT files and shifted back by a multiple of 4096 for EVT3 files.
 
-        :param fpath: path to the input file.
+        :param fpath_in: path to input file.
+        :param out_pattern: the path of the output files, with a field formatted with the clip number, e.g. 'clip_{:04d}.raw'.
+        :param duration: the duration of each clip, expressed in microseconds.
 
-        :returns: the structured NumPy array.
+        :returns: the list of the paths of the clips.
         """
-        fpath = check_external_file(fpath, self.fpath, self.encoding)
-        arr, status = c_read_wrapper(
+        fpath_in = check_external_file(fpath_in, self.fpath, self.encoding)
+        out_pattern = check_out_pattern(out_pattern, self.encoding)
+        duration = check_new_duration(duration)
+        fpaths_out, status = c_split_wrapper(
             encoding=self.encoding,
-            fpath=fpath,
+            fpath_in=fpath_in,
+            out_pattern=out_pattern,
+            duration=duration,
             buff_size=self.buff_size,
+            io_mode=self.io_mode,
         )
+        if status != 0:
+            raise RuntimeError("ERROR: Something went wrong while splitting the file.")
+        return fpaths_out
+
+    def read(
+        self,
+        fpath: Optional[Union[str, pathlib.Path]] = None,
+        layout: str = "aos",
+        fields: Optional[tuple] = None,
+        triggers: bool = False,
+    ) -> Union[ndarray, dict, tuple]:
+        """
+        Reads a binary file to a structured NumPy of events.
+
+        :param fpath: path to the input file.
+        :param layout: "aos" to get a structured NumPy array, "soa" to get a dictionary with a contiguous NumPy array for each field ('t', 'x', 'y', 'p'), which takes less memory. "compact" narrows the 'soa' fields to int32 timestamps, relative to the first one (saved in the 't_base' key), and uint16 addresses, while "packed" returns the events as uint64 values (the 'events' key) with the relative timestamp in the lower 32 bits (the timestamps preceding the first one, if they are not monotonic, are clamped to it), followed by 14 bits of X address, 14 bits of Y address and 4 bits of polarity; see expelliarmus.utils.unpack_events(). Except "aos", the layouts are always decoded by a single thread.
+        :param fields: the fields to be returned, e.g. ('t',) or ('x', 'y'). This is an output projection: all the fields are still decoded, but the others are not stored, and a dictionary with an array for each field is returned, with the "soa" types unless the layout is "compact". Not available for the "packed" layout.
+        :param triggers: whether to collect the external trigger events in the same pass, decoding the file by a single thread. DAT files do not encode them.
+
+        :returns: the structured NumPy array, or the dictionary of arrays; if 'triggers' is set, a tuple with it and a structured NumPy array of trigger events ('t', 'id', the channel, and 'value', 1 for the rising edges and 0 for the falling ones).
+        """
+        if not isinstance(triggers, bool):
+            raise TypeError("ERROR: The triggers flag must be a boolean.")
+        fpath = check_external_file(fpath, self.fpath, self.encoding)
+        layout = check_layout(layout)
+        fields = check_fields(fields)
+        if fields is not None:
+            if layout == "packed":
+                raise ValueError(
+                    "ERROR: The fields cannot be selected with the 'packed' layout."
+                )
+            if layout == "aos":
+                layout = "soa"
+        c_triggers = c_triggers_wrapper() if triggers else None
+        if layout != "aos":
+            arr, status = c_read_columns_wrapper(
+                encoding=self.encoding,
+                fpath=fpath,
+                buff_size=self.buff_size,
+                io_mode=self.io_mode,
+                layout=layout,
+                fields=fields,
+                c_filter=self._get_filter(),
+                c_triggers=c_triggers,
+            )
+        else:
+            arr, status = c_read_wrapper(
+                encoding=self.encoding,
+                fpath=fpath,
+                buff_size=self.buff_size,
+                io_mode=self.io_mode,
+                nthreads=self.nthreads,
+                c_filter=self._get_filter(),
+                c_triggers=c_triggers,
+            )
         if status != 0:
             raise RuntimeError(
                 "ERROR: Something went wrong while creating the array from the file."
             )
+        if c_triggers is not None:
+            c_triggers.events.resize((c_triggers.num,), refcheck=False)
+            return arr, c_triggers.events
         return arr
 
     def save(
@@ -272,46 +760,184 @@ class Wizard:
             raise RuntimeError("ERROR: Something went wrong while saving the array.")
         return
 
-    def read_chunk(self) -> ndarray:
+    def read_chunk(self, fields: Optional[tuple] = None) -> Union[ndarray, dict]:
         """
         Generator used to read the file in chunks.
 
-        :returns: structured NumPy array of events.
+        :param fields: the fields to be returned, e.g. ('t',) or ('x', 'y'). If specified, the others are decoded but not stored (output projection) and a dictionary with an array for each field is returned.
+
+        :returns: structured NumPy array of events, or the dictionary of arrays.
         """
+        fields = check_fields(fields)
         if self.fpath is None:
             raise ValueError("ERROR: An input file must be set.")
         self.cargo.events_info.is_chunk = 1
         self.cargo.events_info.is_time_window = 0
-        while self.cargo.events_info.finished == 0:
-            self.cargo.events_info.dim = self.chunk_size
-            arr, self.cargo, status = c_read_chunk_wrapper(
-                encoding=self.encoding,
-                fpath=self.fpath,
-                cargo=self.cargo,
-                buff_size=self.buff_size,
-            )
-            if arr is None or status != 0:
-                break
-            yield arr
-
-    def read_time_window(self) -> ndarray:
+        # The file is kept open, with its read buffer, for the whole iteration.
+        with c_reader_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+        ) as reader:
+            while self.cargo.events_info.finished == 0:
+                self.cargo.events_info.dim = self.chunk_size
+                arr, self.cargo, status = c_read_chunk_wrapper(
+                    encoding=self.encoding,
+                    reader=reader,
+                    cargo=self.cargo,
+                    fields=fields,
+                )
+                if arr is None or status != 0:
+                    break
+                yield arr
+
+    def read_time_window(self, fields: Optional[tuple] = None) -> Union[ndarray, dict]:
         """
         Generator used to read the file in time windows.
 
-        :returns: structured NumPy array of events.
+        :param fields: the fields to be returned, e.g. ('t',) or ('x', 'y'). If specified, the others are decoded but not stored (output projection) and a dictionary with an array for each field is returned.
+
+        :returns: structured NumPy array of events, or the dictionary of arrays.
         """
+        fields = check_fields(fields)
         if self.fpath is None:
             raise ValueError("ERROR: An input file must be set.")
         self.cargo.events_info.is_chunk = 0
         self.cargo.events_info.is_time_window = 1
         self.cargo.events_info.time_window = self.time_window
-        while self.cargo.events_info.finished == 0:
-            arr, self.cargo, status = c_read_time_window_wrapper(
-                encoding=self.encoding,
-                fpath=self.fpath,
-                cargo=self.cargo,
-                buff_size=self.buff_size,
-            )
-            if arr is None or status != 0:
-                break
-            yield arr
+        # The file is kept open, with its read buffer, for the whole iteration.
+        with c_reader_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+        ) as reader:
+            while self.cargo.events_info.finished == 0:
+                arr, self.cargo, status = c_read_time_window_wrapper(
+                    encoding=self.encoding,
+                    reader=reader,
+                    cargo=self.cargo,
+                    fields=fields,
+                )
+                if arr is None or status != 0:
+                    break
+                yield arr
+
+    def read_frames(
+        self,
+        sensor_size: tuple,
+        mode: str = "count",
+        event_count: Optional[int] = None,
+        bins: int = 5,
+        tau: Optional[Union[int, float]] = None,
+    ) -> tuple:
+        """
+        Generator used to read the file as frames, the 2D histograms of the events in time windows of 'time_window' microseconds or, if specified, of 'event_count' events, or as voxel grids or time surfaces. The events are decoded in small blocks and accumulated to the frames in C, so that no event array is allocated and the memory used does not depend on the event rate. The time windows without events are read as empty frames. With 'nthreads' larger than 1 and no filter set, the frames of fixed duration are split among the threads, each decoding its run of frames from the index of the file (built if needed, as by read_range()) or, for DAT and EVT2 files without it, from a bisection.
+
+        :param sensor_size: the (width, height) of the frames; the events out of them are dropped. With set_transform(), the size of the downscaled sensor.
+        :param mode: "count" for the number of events of each pixel, "binary" for 1 if the pixel has events, both with a channel for each polarity, and "signed" for the number of events of polarity 1 minus the ones of polarity 0 of each pixel, in a single channel. "voxel" spreads the latter over 'bins' channels, splitting each event between the two bins closest to its timestamp with a linear weight, and "surface" gives, for each polarity, exp(-(t_end - t)/tau) where t is the timestamp of the last event of the pixel up to the end of the frame, t_end, or 0 if the pixel has no events yet.
+        :param event_count: the number of events of a frame (at most 12 more for EVT3 vectorized events, as in read_chunk()); if None, the frames last 'time_window' microseconds. Not available for voxel grids.
+        :param bins: the number of bins of the voxel grids.
+        :param tau: the decay constant of the time surfaces, in microseconds; if None, 'time_window'.
+
+        :returns: a tuple with the start timestamp of the frame and the frame, a NumPy array of shape (channels, height, width), of int32 values or, for voxel grids and time surfaces, of float32 ones.
+        """
+        sensor_size = check_sensor_size(sensor_size)
+        mode = check_frame_mode(mode)
+        if event_count is not None:
+            event_count = check_chunk_size(event_count, self.encoding)
+            if mode == "voxel":
+                raise ValueError(
+                    "ERROR: The voxel grids require frames of fixed duration."
+                )
+        bins = check_bins(bins)
+        tau = check_tau(tau if tau is not None else self.time_window)
+        if self.fpath is None:
+            raise ValueError("ERROR: An input file must be set.")
+        c_frames = c_frames_wrapper(
+            mode, sensor_size, self.time_window, event_count, bins, tau
+        )
+        # The threads decode the file from states without the filter.
+        parallel = self._filter is None
+        # The file is kept open, with its read buffer, for the whole iteration.
+        with c_reader_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+        ) as reader:
+            while self.cargo.events_info.finished == 0:
+                frames, t_start, self.cargo, status = c_read_frames_wrapper(
+                    encoding=self.encoding,
+                    reader=reader,
+                    cargo=self.cargo,
+                    c_frames=c_frames,
+                    nthreads=self.nthreads if parallel else 1,
+                    locate=self._locate,
+                )
+                if status != 0:
+                    break
+                for k in range(len(frames)):
+                    yield int(t_start[k]), frames[k]
+
+    def read_trigger_windows(
+        self, channel: Optional[int] = None, value: Optional[int] = None
+    ) -> tuple:
+        """
+        Generator used to read the file in windows delimited by the external trigger events: a window holds the events with a timestamp in [t_k, t_k+1), where t_k and t_k+1 are the timestamps of two consecutive trigger events. The file is decoded in chunks of 'chunk_size' events, collecting the trigger events in the same pass, and the events preceding the first trigger event or following the last one are dropped. DAT files do not encode the trigger events, hence no window is read from them.
+
+        :param channel: the channel of the trigger events delimiting the windows; all of them if None.
+        :param value: the edge of the trigger events delimiting the windows, 1 for rising and 0 for falling; both if None.
+
+        :returns: a tuple with the timestamps of the trigger events delimiting the window and the structured NumPy array of its events, possibly empty.
+        """
+        channel, value = check_trigger(channel, value)
+        if self.fpath is None:
+            raise ValueError("ERROR: An input file must be set.")
+        self.cargo.events_info.is_chunk = 1
+        self.cargo.events_info.is_time_window = 0
+        c_triggers = c_triggers_wrapper()
+        # The events of the open window, or the ones with the last timestamp
+        # read before the first trigger event, which could share it.
+        t_open, pending = None, []
+        with c_reader_wrapper(
+            encoding=self.encoding,
+            fpath=self.fpath,
+            buff_size=self.buff_size,
+            io_mode=self.io_mode,
+        ) as reader:
+            while self.cargo.events_info.finished == 0:
+                self.cargo.events_info.dim = self.chunk_size
+                # The trigger events are collected only by this generator.
+                c_triggers.num = 0
+                self.cargo.events_info.triggers = addressof(c_triggers)
+                arr, self.cargo, status = c_read_chunk_wrapper(
+                    encoding=self.encoding,
+                    reader=reader,
+                    cargo=self.cargo,
+                )
+                self.cargo.events_info.triggers = None
+                if status != 0:
+                    break
+                if arr is not None:
+                    pending.append(arr)
+                trig = c_triggers.events[: c_triggers.num]
+                if channel is not None:
+                    trig = trig[trig["id"] == channel]
+                if value is not None:
+                    trig = trig[trig["value"] == value]
+                for t in trig["t"].tolist():
+                    events = (
+                        concatenate(pending) if pending else empty((0,), dtype=event_t)
+                    )
+                    k = int(searchsorted(events["t"], t, side="left"))
+                    if t_open is not None:
+                        yield t_open, t, events[:k]
+                    pending, t_open = [events[k:]], t
+                if t_open is None and pending:
+                    events = concatenate(pending)
+                    if len(events) > 0:
+                        k = int(searchsorted(events["t"], events["t"][-1], side="left"))
+                        events = events[k:]
+                    pending = [events]
@@ -1,37 +1,399 @@
-from ctypes import byref, c_char_p, c_size_t
+import os
+import struct
+from contextlib import contextmanager
+from ctypes import addressof, byref, c_char_p, c_size_t, c_uint8, c_uint64, c_void_p
 from pathlib import Path
-from typing import Optional, Union
+from typing import Callable, Optional, Union
 
-from numpy import empty, ndarray
+from numpy import dtype as np_dtype
+from numpy import (
+    empty,
+    float32,
+    fromfile,
+    iinfo,
+    int32,
+    int64,
+    ndarray,
+    packbits,
+    uint32,
+    uint64,
+    zeros,
+)
 
-from expelliarmus.utils import _SUPPORTED_ENCODINGS
+from expelliarmus.utils import (
+    _COMPACT_DTYPES,
+    _DTYPES,
+    _FIELDS,
+    _FLOAT_FRAME_MODES,
+    _FRAME_CHANNELS,
+    _FRAME_MODES,
+    _FRAMES_BUFF_SIZE,
+    _GROWTH_FACTOR,
+    _INDEX_MAGIC,
+    _INDEX_SUFFIX,
+    _INDEX_VERSION,
+    _IO_MODES,
+    _LAYOUTS,
+    _MAX_CAPACITY_GUESS,
+    _SUPPORTED_ENCODINGS,
+    _TRIGGERS_SIZE,
+    _VECT_SLACK,
+    _WORD_SIZES,
+)
 from expelliarmus.wizard.clib import (
+    box_t,
     c_cargos_t,
+    c_close_reader,
     c_cut_fns,
+    c_cut_span_fns,
     c_get_time_window_fns,
+    c_index_fns,
     c_measure_fns,
+    c_open_reader,
+    c_profile_fns,
+    c_read_columns_fns,
     c_read_fns,
+    c_read_frames_fns,
+    c_read_frames_parallel_fns,
+    c_read_parallel_fns,
+    c_read_range_fns,
     c_save_fns,
+    c_seek_time_fns,
+    c_split_fns,
+    columns_t,
     dat_cargo_t,
     event_t,
     events_cargo_t,
     evt2_cargo_t,
     evt3_cargo_t,
+    filter_t,
+    frames_t,
+    index_t,
+    range_t,
+    split_t,
+    trigger_t,
+    triggers_t,
 )
 
+# Header of the sidecar index files: magic bytes, version, encoding, entry
+# size, then size and modification time of the recording, steps of the index
+# and number of entries.
+_INDEX_HEADER = struct.Struct("<8sBBxxIQqQqQ")
 
-def c_read_wrapper(encoding: str, fpath: Union[str, Path], buff_size: int):
+
+@contextmanager
+def c_reader_wrapper(
+    encoding: str, fpath: Union[str, Path], buff_size: int, io_mode: str
+):
     c_fpath = c_char_p(bytes(str(fpath), "utf-8"))
-    c_buff_size = c_size_t(buff_size)
+    c_buff_size = c_size_t(buff_size * _WORD_SIZES[encoding])
+    c_io_mode = c_uint8(_IO_MODES[io_mode])
+    reader = c_open_reader(c_fpath, c_buff_size, c_io_mode)
+    if not reader:
+        raise RuntimeError("ERROR: The input file could not be opened.")
+    try:
+        yield reader
+    finally:
+        c_close_reader(reader)
+
+
+def c_filter_wrapper(
+    selection: Optional[tuple],
+    transform: Optional[tuple],
+    hot_pixels: Optional[ndarray] = None,
+) -> filter_t:
+    boxes, p_mask = selection if selection is not None else ((), 0xFFFF)
+    scale, t_bin, refractory, background, width, height = (
+        transform if transform is not None else (1, 1, 0, 0, 0, 0)
+    )
+    c_boxes = (box_t * max(len(boxes), 1))(*[box_t(*box) for box in boxes])
+    # One bit for each pixel, from the lowest one of each byte.
+    hot_mask = None
+    if hot_pixels is not None:
+        hot_mask = packbits(hot_pixels, axis=None, bitorder="little")
+    # No event has been kept yet by the refractory filter, nor has supported
+    # its neighbours in the background activity one.
+    state, support = None, None
+    if refractory > 0:
+        state = empty((height * width * 2,), dtype=int64)
+        state.fill(iinfo(int64).min)
+    if background > 0:
+        support = empty((height * width,), dtype=int64)
+        support.fill(iinfo(int64).min)
+    c_filter = filter_t(
+        p_mask=p_mask,
+        num_boxes=len(boxes),
+        boxes=c_boxes,
+        hot_pixels=hot_mask.ctypes.data if hot_mask is not None else None,
+        mask_width=hot_pixels.shape[1] if hot_pixels is not None else 0,
+        mask_height=hot_pixels.shape[0] if hot_pixels is not None else 0,
+        scale=scale,
+        t_bin=t_bin,
+        refractory=refractory,
+        background=background,
+        width=width,
+        height=height,
+        last_t=state.ctypes.data if state is not None else None,
+        support_t=support.ctypes.data if support is not None else None,
+    )
+    # The boxes array is kept alive by the structure it is assigned to, the
+    # states of the filters and the hot pixels mask by these references.
+    c_filter.state = state
+    c_filter.support = support
+    c_filter.hot_mask = hot_mask
+    return c_filter
+
+
+def c_triggers_wrapper(capacity: int = _TRIGGERS_SIZE) -> triggers_t:
+    events = empty((capacity,), dtype=trigger_t)
+    c_triggers = triggers_t(arr=events.ctypes.data, dim=capacity, num=0)
+    # The trigger events array is kept alive by this reference.
+    c_triggers.events = events
+    return c_triggers
+
+
+def _grow_triggers(c_triggers: triggers_t) -> None:
+    capacity = int(c_triggers.dim * _GROWTH_FACTOR) + 1
+    c_triggers.events.resize((capacity,), refcheck=False)
+    c_triggers.arr = c_triggers.events.ctypes.data
+    c_triggers.dim = capacity
+    return
+
+
+def _get_capacity(
+    encoding: str,
+    fpath: Union[str, Path],
+    reader: c_void_p,
+    cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    c_filter: Optional[filter_t],
+) -> int:
+    if c_filter is None:
+        # The file is decoded in a single pass: the array is allocated using
+        # the number of words in the file as a guess of the number of events,
+        # and it is grown if the EVT3 vectorized events make the guess too
+        # small. The guess is bounded, since it takes several times the file
+        # size for EVT2 and EVT3 files: the array of a large recording is grown
+        # while it is decoded instead.
+        guess = Path(fpath).stat().st_size // _WORD_SIZES[encoding]
+        return max(min(guess, _MAX_CAPACITY_GUESS), 1)
+    # The events passing the filter are counted first, so that the array is
+    # not far larger than needed.
+    cargo.events_info.filter = addressof(c_filter)
+    c_measure_fns[encoding](reader, byref(cargo))
+    cargo.events_info.finished = 0
+    return max(cargo.events_info.dim, 1)
+
+
+def c_read_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    nthreads: int = 1,
+    c_filter: Optional[filter_t] = None,
+    c_triggers: Optional[triggers_t] = None,
+):
     cargo = c_cargos_t[encoding](events_info=events_cargo_t())
-    c_measure_fns[encoding](c_fpath, byref(cargo), c_buff_size)
-    status = 0
-    if cargo.events_info.dim > 0:
-        arr = empty((cargo.events_info.dim,), dtype=event_t)
-        status = c_read_fns[encoding](c_fpath, arr, byref(cargo), c_buff_size)
-    return (
-        (arr, status) if cargo.events_info.dim > 0 and status == 0 else (None, status)
+    if c_triggers is not None:
+        cargo.events_info.triggers = addressof(c_triggers)
+    slack = _VECT_SLACK if encoding == "evt3" else 0
+    nevents, status = 0, 0
+    # The parallel decoders do not apply the filters, nor collect the trigger
+    # events.
+    parallel = (
+        nthreads > 1
+        and encoding in c_read_parallel_fns
+        and c_filter is None
+        and c_triggers is None
+    )
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        capacity = _get_capacity(encoding, fpath, reader, cargo, c_filter)
+        arr = empty((capacity + slack,), dtype=event_t)
+        while True:
+            if parallel:
+                # The parallel decoders count the events before decoding them:
+                # if the array is too small, the number needed is returned.
+                cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+                cargo.events_info.dim = capacity
+                status = c_read_parallel_fns[encoding](
+                    reader, arr, byref(cargo), c_size_t(nthreads)
+                )
+                nevents = cargo.events_info.dim if cargo.events_info.finished else 0
+                if status != 0 or cargo.events_info.finished:
+                    break
+                capacity = cargo.events_info.dim
+            else:
+                cargo.events_info.dim = capacity - nevents
+                status = c_read_fns[encoding](reader, arr[nevents:], byref(cargo))
+                nevents += cargo.events_info.dim
+                if status != 0 or cargo.events_info.finished:
+                    break
+                # The decoder stops early when the trigger events array is full.
+                if c_triggers is not None and c_triggers.num == c_triggers.dim:
+                    _grow_triggers(c_triggers)
+                if nevents < capacity:
+                    continue
+                capacity = max(int(capacity * _GROWTH_FACTOR), nevents + 1)
+            arr.resize((capacity + slack,), refcheck=False)
+    if status != 0 or nevents == 0:
+        return None, status
+    arr.resize((nevents,), refcheck=False)
+    return arr, status
+
+
+def _empty_columns(layout: str, fields: Optional[tuple], dim: int) -> dict:
+    if layout == "packed":
+        return dict(packed=empty((dim,), dtype=c_uint64))
+    dtypes = _COMPACT_DTYPES if layout == "compact" else _DTYPES
+    return {field: empty((dim,), dtype=dtypes[field]) for field in fields or _FIELDS}
+
+
+def _set_columns(c_cols: columns_t, cols: dict, offset: int) -> None:
+    # The fields without an array stay NULL and are not filled.
+    for field, arr in cols.items():
+        setattr(c_cols, field, arr.ctypes.data + offset * arr.itemsize)
+    return
+
+
+def c_read_columns_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    layout: str,
+    fields: Optional[tuple] = None,
+    c_filter: Optional[filter_t] = None,
+    c_triggers: Optional[triggers_t] = None,
+):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    if c_triggers is not None:
+        cargo.events_info.triggers = addressof(c_triggers)
+    slack = _VECT_SLACK if encoding == "evt3" else 0
+    # The base timestamp is set by the first call and kept by the next ones.
+    c_cols = columns_t(layout=_LAYOUTS[layout], has_t_base=0)
+    nevents, status = 0, 0
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        # Same allocation strategy of c_read_wrapper(), with one array per
+        # field.
+        capacity = _get_capacity(encoding, fpath, reader, cargo, c_filter)
+        cols = _empty_columns(layout, fields, capacity + slack)
+        while True:
+            cargo.events_info.dim = capacity - nevents
+            _set_columns(c_cols, cols, nevents)
+            status = c_read_columns_fns[encoding](reader, byref(c_cols), byref(cargo))
+            nevents += cargo.events_info.dim
+            if status != 0 or cargo.events_info.finished:
+                break
+            if c_triggers is not None and c_triggers.num == c_triggers.dim:
+                _grow_triggers(c_triggers)
+            if nevents < capacity:
+                continue
+            capacity = max(int(capacity * _GROWTH_FACTOR), nevents + 1)
+            for arr in cols.values():
+                arr.resize((capacity + slack,), refcheck=False)
+    if status != 0 or nevents == 0:
+        return None, status
+    for arr in cols.values():
+        arr.resize((nevents,), refcheck=False)
+    if layout == "packed":
+        return dict(events=cols["packed"], t_base=c_cols.t_base), status
+    if layout == "compact" and "t" in cols:
+        cols["t_base"] = c_cols.t_base
+    return cols, status
+
+
+def c_read_chunk_columns_wrapper(
+    encoding: str,
+    reader: c_void_p,
+    cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    fields: tuple,
+):
+    slack = _VECT_SLACK if encoding == "evt3" else 0
+    cols = _empty_columns("soa", fields, cargo.events_info.dim + slack)
+    c_cols = columns_t(layout=_LAYOUTS["soa"])
+    _set_columns(c_cols, cols, 0)
+    status = c_read_columns_fns[encoding](reader, byref(c_cols), byref(cargo))
+    if cargo.events_info.dim == 0 or status != 0:
+        return None, cargo, status
+    for arr in cols.values():
+        arr.resize((cargo.events_info.dim,), refcheck=False)
+    return cols, cargo, status
+
+
+def c_frames_wrapper(
+    mode: str,
+    sensor_size: tuple,
+    time_window: int,
+    event_count: Optional[int],
+    bins: int = 1,
+    tau: float = 0.0,
+) -> frames_t:
+    # No pixel has fired yet for the time surfaces.
+    state = None
+    if mode == "surface":
+        state = empty((sensor_size[1] * sensor_size[0] * 2,), dtype=int64)
+        state.fill(iinfo(int64).min)
+    c_frames = frames_t(
+        mode=_FRAME_MODES[mode],
+        width=sensor_size[0],
+        height=sensor_size[1],
+        time_window=time_window if event_count is None else 0,
+        event_count=event_count or 0,
+        has_t_next=0,
+        bins=bins,
+        tau=tau,
+        last_t=state.ctypes.data if state is not None else None,
+    )
+    # The last timestamps of the pixels are kept alive by this reference.
+    c_frames.state = state
+    return c_frames
+
+
+def c_read_frames_wrapper(
+    encoding: str,
+    reader: c_void_p,
+    cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    c_frames: frames_t,
+    nthreads: int = 1,
+    locate: Optional[Callable] = None,
+):
+    mode = [k for k, v in _FRAME_MODES.items() if v == c_frames.mode][0]
+    channels = c_frames.bins if mode == "voxel" else _FRAME_CHANNELS[mode]
+    shape = (channels, c_frames.height, c_frames.width)
+    # The frames filled by a call take at most _FRAMES_BUFF_SIZE bytes, unless
+    # each thread needs one.
+    nframes = max(_FRAMES_BUFF_SIZE // (shape[0] * shape[1] * shape[2] * 4), nthreads)
+    frames = empty(
+        (nframes,) + shape, dtype=float32 if mode in _FLOAT_FRAME_MODES else int32
     )
+    t_start = empty((nframes,), dtype=int64)
+    c_frames.arr = frames.ctypes.data
+    c_frames.t_start = t_start.ctypes.data
+    c_frames.dim = nframes
+    # The frames of fixed duration following the first ones can be split in
+    # runs, each decoded by a thread from the state located before it.
+    if (
+        nthreads > 1
+        and locate is not None
+        and c_frames.time_window > 0
+        and c_frames.has_t_next
+    ):
+        cargos = (type(cargo) * nthreads)(
+            cargo,
+            *[
+                locate(
+                    c_frames.t_next + (nframes * k // nthreads) * c_frames.time_window
+                )
+                for k in range(1, nthreads)
+            ],
+        )
+        status = c_read_frames_parallel_fns[encoding](
+            reader, byref(c_frames), cargos, c_size_t(nthreads)
+        )
+        cargo = type(cargo).from_buffer_copy(cargos[0])
+    else:
+        status = c_read_frames_fns[encoding](reader, byref(c_frames), byref(cargo))
+    return frames[: c_frames.dim], t_start[: c_frames.dim], cargo, status
 
 
 def c_save_wrapper(
@@ -55,20 +417,23 @@ def c_save_wrapper(
 
 def c_read_time_window_wrapper(
     encoding: str,
-    fpath: Union[str, Path],
+    reader: c_void_p,
     cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
-    buff_size: int,
+    fields: Optional[tuple] = None,
 ):
-    c_fpath = c_char_p(bytes(str(fpath), "utf-8"))
-    c_buff_size = c_size_t(buff_size)
-
-    c_get_time_window_fns[encoding](c_fpath, byref(cargo), c_buff_size)
+    c_get_time_window_fns[encoding](reader, byref(cargo))
     status = 0
+    if cargo.events_info.dim > 0 and fields is not None:
+        return c_read_chunk_columns_wrapper(encoding, reader, cargo, fields)
     if cargo.events_info.dim > 0:
-        arr = empty((cargo.events_info.dim,), dtype=event_t)
-        status = c_read_fns[encoding](c_fpath, arr, byref(cargo), c_buff_size)
+        # The last EVT3 vector of the window can be cut by a filter.
+        arr = empty(
+            (cargo.events_info.dim + (_VECT_SLACK if encoding == "evt3" else 0),),
+            dtype=event_t,
+        )
+        status = c_read_fns[encoding](reader, arr, byref(cargo))
     return (
-        (arr, cargo, status)
+        (arr[: cargo.events_info.dim], cargo, status)
         if cargo.events_info.dim > 0 and status == 0
         else (None, cargo, status)
     )
@@ -76,16 +441,17 @@ def c_read_time_window_wrapper(
 
 def c_read_chunk_wrapper(
     encoding: str,
-    fpath: Union[str, Path],
+    reader: c_void_p,
     cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
-    buff_size: int,
+    fields: Optional[tuple] = None,
 ):
-    c_fpath = c_char_p(bytes(str(fpath), "utf-8"))
-    c_buff_size = c_size_t(buff_size)
+    if fields is not None:
+        return c_read_chunk_columns_wrapper(encoding, reader, cargo, fields)
     arr = empty(
-        (cargo.events_info.dim + (12 if encoding == "evt3" else 0),), dtype=event_t
+        (cargo.events_info.dim + (_VECT_SLACK if encoding == "evt3" else 0),),
+        dtype=event_t,
     )
-    status = c_read_fns[encoding](c_fpath, arr, byref(cargo), c_buff_size)
+    status = c_read_fns[encoding](reader, arr, byref(cargo))
     return (
         (arr[: cargo.events_info.dim], cargo, status)
         if cargo.events_info.dim > 0 and status == 0
@@ -105,3 +471,213 @@ def c_cut_wrapper(
     c_new_duration = c_size_t(new_duration)
     c_buff_size = c_size_t(buff_size)
     return c_cut_fns[encoding](c_fpath_in, c_fpath_out, c_new_duration, c_buff_size)
+
+
+def c_cut_span_wrapper(
+    encoding: str,
+    fpath_in: Union[str, Path],
+    fpath_out: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    start: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    end: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    t_start: int,
+    t_end: int,
+):
+    c_fpath_out = c_char_p(bytes(str(fpath_out), "utf-8"))
+    with c_reader_wrapper(encoding, fpath_in, buff_size, io_mode) as reader:
+        status = c_cut_span_fns[encoding](
+            reader, c_fpath_out, byref(start), byref(end), t_start, t_end
+        )
+    if status != 0:
+        return 0, status
+    # The events of the span are counted on the output file, without decoding
+    # them, as they are not decoded while being copied.
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    with c_reader_wrapper(encoding, fpath_out, buff_size, io_mode) as reader:
+        c_measure_fns[encoding](reader, byref(cargo))
+    return cargo.events_info.dim, status
+
+
+def c_split_wrapper(
+    encoding: str,
+    fpath_in: Union[str, Path],
+    out_pattern: str,
+    duration: int,
+    buff_size: int,
+    io_mode: str,
+):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    split = split_t(duration=duration, has_t_next=0)
+    # The output paths are provided in batches, since the number of clips is
+    # known only at the end of the file.
+    batch = 64
+    fpaths_out, status = [], 0
+    with c_reader_wrapper(encoding, fpath_in, buff_size, io_mode) as reader:
+        while True:
+            names = [out_pattern.format(len(fpaths_out) + k) for k in range(batch)]
+            c_names = (c_char_p * batch)(*[bytes(name, "utf-8") for name in names])
+            split.fpaths = c_names
+            split.dim = batch
+            status = c_split_fns[encoding](reader, byref(split), byref(cargo))
+            fpaths_out += [Path(name) for name in names[: split.dim]]
+            if status != 0 or cargo.events_info.finished:
+                break
+    return fpaths_out, status
+
+
+def index_dtype(encoding: str) -> np_dtype:
+    # Same layout of an "index_entry_t" structure followed by the cargo.
+    return np_dtype(
+        [("ordinal", uint64), ("t", int64), ("cargo", c_cargos_t[encoding])]
+    )
+
+
+def c_build_index_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    step_events: int,
+    step_time: int,
+):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    index = index_t(step_events=step_events, step_time=step_time, has_entry=0)
+    capacity = 64
+    if step_events > 0:
+        nwords = Path(fpath).stat().st_size // _WORD_SIZES[encoding]
+        capacity = max(nwords // step_events + 2, capacity)
+    entries = empty((capacity,), dtype=index_dtype(encoding))
+    nentries, status = 0, 0
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        while True:
+            index.entries = entries.ctypes.data + nentries * entries.itemsize
+            index.dim = capacity - nentries
+            status = c_index_fns[encoding](reader, byref(index), byref(cargo))
+            nentries += index.dim
+            if status != 0 or cargo.events_info.finished or nentries < capacity:
+                break
+            capacity = int(capacity * _GROWTH_FACTOR) + 1
+            entries.resize((capacity,), refcheck=False)
+    entries.resize((nentries,), refcheck=False)
+    return entries, status
+
+
+def c_profile_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    sensor_size: tuple,
+):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    counts = zeros((sensor_size[1], sensor_size[0]), dtype=uint32)
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        status = c_profile_fns[encoding](
+            reader, counts.ctypes.data, sensor_size[0], sensor_size[1], byref(cargo)
+        )
+    return counts, status
+
+
+def c_seek_time_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    t: int,
+):
+    cargo = c_cargos_t[encoding](events_info=events_cargo_t())
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        status = c_seek_time_fns[encoding](reader, byref(cargo), t)
+    return cargo, status
+
+
+def get_index_path(fpath: Union[str, Path]) -> Path:
+    return Path(str(fpath) + _INDEX_SUFFIX)
+
+
+def save_index(
+    encoding: str,
+    fpath: Union[str, Path],
+    entries: ndarray,
+    step_events: int,
+    step_time: int,
+) -> Path:
+    stat = os.stat(fpath)
+    header = _INDEX_HEADER.pack(
+        _INDEX_MAGIC,
+        _INDEX_VERSION,
+        _SUPPORTED_ENCODINGS.index(encoding),
+        entries.itemsize,
+        stat.st_size,
+        stat.st_mtime_ns,
+        step_events,
+        step_time,
+        len(entries),
+    )
+    index_fpath = get_index_path(fpath)
+    with open(index_fpath, "wb") as fp:
+        fp.write(header)
+        entries.tofile(fp)
+    return index_fpath
+
+
+def load_index(encoding: str, fpath: Union[str, Path]) -> Optional[ndarray]:
+    # The index is discarded if it does not belong to this recording, or if the
+    # recording has been modified after the index was built.
+    index_fpath = get_index_path(fpath)
+    if not index_fpath.is_file():
+        return None
+    dtype = index_dtype(encoding)
+    with open(index_fpath, "rb") as fp:
+        header = fp.read(_INDEX_HEADER.size)
+        if len(header) != _INDEX_HEADER.size:
+            return None
+        magic, version, enc, entry_size, size, mtime, _, _, nentries = (
+            _INDEX_HEADER.unpack(header)
+        )
+        stat = os.stat(fpath)
+        if (
+            magic != _INDEX_MAGIC
+            or version != _INDEX_VERSION
+            or enc != _SUPPORTED_ENCODINGS.index(encoding)
+            or entry_size != dtype.itemsize
+            or size != stat.st_size
+            or mtime != stat.st_mtime_ns
+        ):
+            return None
+        entries = fromfile(fp, dtype=dtype, count=nentries)
+    if len(entries) != nentries:
+        return None
+    return entries
+
+
+def c_read_range_wrapper(
+    encoding: str,
+    fpath: Union[str, Path],
+    buff_size: int,
+    io_mode: str,
+    cargo: Union[dat_cargo_t, evt2_cargo_t, evt3_cargo_t],
+    c_range: range_t,
+    capacity: int,
+):
+    slack = _VECT_SLACK if encoding == "evt3" else 0
+    capacity = max(capacity, 1)
+    arr = empty((capacity + slack,), dtype=event_t)
+    nevents, status = 0, 0
+    with c_reader_wrapper(encoding, fpath, buff_size, io_mode) as reader:
+        while True:
+            cargo.events_info.dim = capacity - nevents
+            status = c_read_range_fns[encoding](
+                reader,
+                arr.ctypes.data + nevents * arr.itemsize,
+                byref(c_range),
+                byref(cargo),
+            )
+            nevents += cargo.events_info.dim
+            if status != 0 or c_range.done:
+                break
+            capacity = max(int(capacity * _GROWTH_FACTOR), nevents + 1)
+            arr.resize((capacity + slack,), refcheck=False)
+    arr.resize((nevents,), refcheck=False)
+    return arr, status
@@ -1,5 +1,6 @@
 # Inspired by https://github.com/himbeles/ctypes-example.
 import pathlib
+import sys
 from distutils.command.build_ext import build_ext as build_ext_orig
 
 from setuptools import Extension, setup
@@ -46,10 +47,20 @@ setup(
             "expelliarmus",
             [
                 str(pathlib.Path("expelliarmus", "src", "wizard.c")),
+                str(pathlib.Path("expelliarmus", "src", "reader.c")),
+                str(pathlib.Path("expelliarmus", "src", "threads.c")),
+                str(pathlib.Path("expelliarmus", "src", "simd.c")),
+                str(pathlib.Path("expelliarmus", "src", "output.c")),
+                str(pathlib.Path("expelliarmus", "src", "index.c")),
+                str(pathlib.Path("expelliarmus", "src", "filter.c")),
+                str(pathlib.Path("expelliarmus", "src", "frame.c")),
                 str(pathlib.Path("expelliarmus", "src", "dat.c")),
                 str(pathlib.Path("expelliarmus", "src", "evt2.c")),
                 str(pathlib.Path("expelliarmus", "src", "evt3.c")),
             ],
+            extra_compile_args=[] if sys.platform == "win32" else ["-pthread"],
+            extra_link_args=[] if sys.platform == "win32" else ["-pthread"],
+            libraries=[] if sys.platform == "win32" else ["m"],
         ),
     ],
     cmdclass={"build_ext": build_ext},
@@ -35,3 +35,30 @@ def test_evt3_cutting():
         sensor_size=(1280, 720),
     )
     return
+
+
+def test_dat_span_cutting():
+    utils.test_cut_span(
+        encoding="dat",
+        fname_in="dat_sample.dat",
+        fname_out="span_out_dat.dat",
+    )
+    return
+
+
+def test_evt2_span_cutting():
+    utils.test_cut_span(
+        encoding="evt2",
+        fname_in="evt2_sample.raw",
+        fname_out="span_out_evt2.raw",
+    )
+    return
+
+
+def test_evt3_span_cutting():
+    utils.test_cut_span(
+        encoding="evt3",
+        fname_in="evt3_sample.raw",
+        fname_out="span_out_evt3.raw",
+    )
+    return
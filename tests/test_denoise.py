@@ -0,0 +1,18 @@
+from .utils import utils
+
+
+def test_dat_denoise():
+    utils.test_denoise(encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480))
+    return
+
+
+def test_evt2_denoise():
+    utils.test_denoise(encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480))
+    return
+
+
+def test_evt3_denoise():
+    utils.test_denoise(
+        encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720)
+    )
+    return
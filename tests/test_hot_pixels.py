@@ -0,0 +1,22 @@
+from .utils import utils
+
+
+def test_dat_hot_pixels():
+    utils.test_hot_pixels(
+        encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480)
+    )
+    return
+
+
+def test_evt2_hot_pixels():
+    utils.test_hot_pixels(
+        encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480)
+    )
+    return
+
+
+def test_evt3_hot_pixels():
+    utils.test_hot_pixels(
+        encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720)
+    )
+    return
@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_index():
+    utils.test_index(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_index():
+    utils.test_index(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_evt3_index():
+    utils.test_index(encoding="evt3", fname="evt3_sample.raw")
+    return
@@ -0,0 +1,18 @@
+from .utils import utils
+
+
+def test_dat_io_mode():
+    utils.test_io_mode(encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480))
+    return
+
+
+def test_evt2_io_mode():
+    utils.test_io_mode(encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480))
+    return
+
+
+def test_evt3_io_mode():
+    utils.test_io_mode(
+        encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720)
+    )
+    return
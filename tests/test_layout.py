@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_layout():
+    utils.test_layout(encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480))
+    return
+
+
+def test_evt2_layout():
+    utils.test_layout(encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480))
+    return
+
+
+def test_evt3_layout():
+    utils.test_layout(encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720))
+    return
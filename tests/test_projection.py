@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_projection():
+    utils.test_projection(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_projection():
+    utils.test_projection(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_evt3_projection():
+    utils.test_projection(encoding="evt3", fname="evt3_sample.raw")
+    return
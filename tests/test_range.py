@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_range():
+    utils.test_range(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_range():
+    utils.test_range(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_evt3_range():
+    utils.test_range(encoding="evt3", fname="evt3_sample.raw")
+    return
@@ -0,0 +1,22 @@
+from .utils import utils
+
+
+def test_dat_representations():
+    utils.test_representations(
+        encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480)
+    )
+    return
+
+
+def test_evt2_representations():
+    utils.test_representations(
+        encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480)
+    )
+    return
+
+
+def test_evt3_representations():
+    utils.test_representations(
+        encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720)
+    )
+    return
@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_seek():
+    utils.test_seek(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_seek():
+    utils.test_seek(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_dat_seek_overflows():
+    utils.test_dat_seek_overflows()
+    return
@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_simd():
+    utils.test_simd(encoding="dat", fname="dat_sample.dat", sensor_size=(640, 480))
+    return
+
+
+def test_evt2_simd():
+    utils.test_simd(encoding="evt2", fname="evt2_sample.raw", sensor_size=(640, 480))
+    return
+
+
+def test_evt3_simd():
+    utils.test_simd(encoding="evt3", fname="evt3_sample.raw", sensor_size=(1280, 720))
+    return
@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_split():
+    utils.test_split(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_split():
+    utils.test_split(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_evt3_split():
+    utils.test_split(encoding="evt3", fname="evt3_sample.raw")
+    return
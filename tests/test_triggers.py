@@ -0,0 +1,16 @@
+from .utils import utils
+
+
+def test_dat_triggers():
+    utils.test_no_triggers(encoding="dat", fname="dat_sample.dat")
+    return
+
+
+def test_evt2_triggers():
+    utils.test_triggers(encoding="evt2", fname="evt2_sample.raw")
+    return
+
+
+def test_evt3_triggers():
+    utils.test_triggers(encoding="evt3", fname="evt3_sample.raw")
+    return
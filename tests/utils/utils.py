@@ -8,6 +8,16 @@ import numpy as np
 from pytest import raises
 
 from expelliarmus import Wizard
+from expelliarmus.utils import (
+    _SIMD_LEVELS,
+    _VECT_SLACK,
+    find_hot_pixels,
+    load_hot_pixels,
+    save_hot_pixels,
+    unpack_events,
+)
+from expelliarmus.wizard import wizard_wrapper
+from expelliarmus.wizard.clib import c_set_simd
 
 if platform.system() in ("Linux", "Darwin"):  # Unix system.
     TMPDIR = pathlib.Path("/tmp")
@@ -114,6 +124,65 @@ def test_cut(
     return
 
 
+def test_cut_span(
+    encoding: str,
+    fname_in: Union[str, pathlib.Path],
+    fname_out: Union[str, pathlib.Path],
+):
+    assert isinstance(fname_in, str) or isinstance(fname_in, pathlib.Path)
+    assert isinstance(fname_out, str) or isinstance(fname_out, pathlib.Path)
+    fpath_in = pathlib.Path("tests", "sample-files", fname_in).resolve()
+    ref_arr = np.load(
+        pathlib.Path("tests", "sample-files", fname_in.split(".")[0] + ".npy")
+    )
+
+    # The spans of EVT3 recordings are located through an index, that is kept
+    # in memory: no sidecar is written next to the copy.
+    tmp_fpath = pathlib.Path(TMPDIR, fname_in)
+    shutil.copy(fpath_in, tmp_fpath)
+    fpath_out = pathlib.Path(TMPDIR, fname_out)
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath)
+
+    # Error checking on the span.
+    with raises(TypeError):
+        wizard.cut(fpath_out=fpath_out, t_start=0)
+    with raises(ValueError):
+        wizard.cut(fpath_out=fpath_out, t_start=10, t_end=10)
+    with raises(ValueError):
+        wizard.cut(fpath_out=fpath_out, new_duration=10, t_start=0, t_end=10)
+
+    t_first, t_last = int(ref_arr["t"][0]), int(ref_arr["t"][-1])
+    t_mid = int(ref_arr["t"][len(ref_arr) // 2])
+    for t_start, t_end in (
+        (t_first, t_last + 1),
+        (t_first - 100, t_mid),
+        (t_mid, t_mid + 1),
+        (t_mid - 5000, t_mid + 5000),
+        (t_mid, t_last + 100),
+        (t_last + 1, t_last + 100),
+    ):
+        nevents = wizard.cut(fpath_out=fpath_out, t_start=t_start, t_end=t_end)
+        arr = wizard.read(fpath=fpath_out)
+        ref = ref_arr[(ref_arr["t"] >= t_start) & (ref_arr["t"] < t_end)]
+        assert nevents == len(ref)
+        # An empty recording is read as None.
+        if len(ref) == 0:
+            assert arr is None
+            continue
+        assert len(arr) == len(ref)
+        for field in ("x", "y", "p"):
+            assert (arr[field] == ref[field]).all()
+        # The EVT3 timestamp overflows are not restored.
+        t_shift = int(ref["t"][0] - arr["t"][0])
+        assert t_shift == 0 or (encoding == "evt3" and t_shift % 4096 == 0)
+        assert (arr["t"] + t_shift == ref["t"]).all()
+
+    os.remove(fpath_out)
+    assert not pathlib.Path(str(tmp_fpath) + ".idx").exists()
+    os.remove(tmp_fpath)
+    return
+
+
 def test_read(
     encoding: str,
     fname: Union[str, pathlib.Path],
@@ -173,6 +242,21 @@ def test_read(
         len(arr) == expected_nevents
     ), "ERROR: the number of events in the array does not coincide with the expected one."
     _test_fields(ref_arr, arr, sensor_size)
+
+    # A bounded first allocation is grown while the file is decoded.
+    capacity_guess = wizard_wrapper._MAX_CAPACITY_GUESS
+    wizard_wrapper._MAX_CAPACITY_GUESS = 1000
+    try:
+        arr = wizard.read()
+        cols = wizard.read(layout="soa")
+        wizard.set_nthreads(4)
+        parallel_arr = wizard.read()
+        wizard.set_nthreads(1)
+    finally:
+        wizard_wrapper._MAX_CAPACITY_GUESS = capacity_guess
+    assert len(arr) == expected_nevents and (parallel_arr == arr).all()
+    _test_fields(ref_arr, arr, sensor_size)
+    assert all((cols[field] == ref_arr[field]).all() for field in cols)
     return
 
 
@@ -347,3 +431,1194 @@ def test_chunk_read(
             )
             wizard.reset()
     return
+
+
+def test_io_mode(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple = (640, 480),
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # Error checking in constructor.
+    with raises(ValueError):
+        wizard = Wizard(encoding=encoding, fpath=fpath, io_mode="peppapig")
+    with raises(TypeError):
+        wizard = Wizard(encoding=encoding, fpath=fpath, io_mode=1)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, io_mode="mmap")
+
+    # Error checking on setting private attribute.
+    with raises(AttributeError):
+        wizard.io_mode = "fread"
+
+    # Error checking in set_io_mode.
+    with raises(ValueError):
+        wizard.set_io_mode("peppapig")
+    with raises(TypeError):
+        wizard.set_io_mode(1.2123)
+
+    # A small buffer makes the prefetch thread cycle through its whole ring.
+    for io_mode, buff_size in (
+        ("mmap", 4096),
+        ("fread", 4096),
+        ("prefetch", 4096),
+        ("prefetch", 64),
+    ):
+        wizard.set_io_mode(io_mode)
+        wizard.set_buff_size(buff_size)
+        _test_fields(ref_arr, wizard.read(), sensor_size)
+        wizard.set_chunk_size(8192)
+        _test_fields(
+            ref_arr,
+            np.concatenate([chunk for chunk in wizard.read_chunk()]),
+            sensor_size,
+        )
+        wizard.set_time_window(1000)
+        _test_fields(
+            ref_arr,
+            np.concatenate([window for window in wizard.read_time_window()]),
+            sensor_size,
+        )
+    return
+
+
+def test_parallel_read(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple = (640, 480),
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # Error checking in constructor.
+    with raises(ValueError):
+        wizard = Wizard(encoding=encoding, fpath=fpath, nthreads=0)
+    with raises(TypeError):
+        wizard = Wizard(encoding=encoding, fpath=fpath, nthreads=2.5)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath)
+
+    # Error checking on setting private attribute.
+    with raises(AttributeError):
+        wizard.nthreads = 4
+
+    # Error checking in set_nthreads.
+    with raises(ValueError):
+        wizard.set_nthreads(-1)
+    with raises(TypeError):
+        wizard.set_nthreads(1.2123)
+
+    for io_mode in ("fread", "mmap", "prefetch"):
+        wizard.set_io_mode(io_mode)
+        for nthreads in (2, 3, 8, 64):
+            wizard.set_nthreads(nthreads)
+            arr = wizard.read()
+            assert len(arr) == len(
+                ref_arr
+            ), f"ERROR: {len(arr)} events read with {nthreads} threads instead of {len(ref_arr)}."
+            _test_fields(ref_arr, arr, sensor_size)
+    return
+
+
+def test_simd(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple = (640, 480),
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath)
+    best = c_set_simd(max(_SIMD_LEVELS.values()))
+    windows = dict()
+    try:
+        # Every kernel supported by the CPU, down to the scalar one.
+        for simd in range(best, -1, -1):
+            assert c_set_simd(simd) == simd
+            _test_fields(ref_arr, wizard.read(), sensor_size)
+            wizard.set_chunk_size(8192)
+            _test_fields(
+                ref_arr,
+                np.concatenate([chunk for chunk in wizard.read_chunk()]),
+                sensor_size,
+            )
+            # The time windows boundaries have to be the same for all kernels.
+            for time_window in (7, 100):
+                wizard.set_time_window(time_window)
+                arrs = [window for window in wizard.read_time_window()]
+                _test_fields(ref_arr, np.concatenate(arrs), sensor_size)
+                lengths = [len(arr) for arr in arrs]
+                if time_window in windows:
+                    assert windows[time_window] == lengths
+                windows[time_window] = lengths
+    finally:
+        c_set_simd(best)
+    return
+
+
+def test_layout(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple = (640, 480),
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath)
+
+    # Error checking in read.
+    with raises(ValueError):
+        wizard.read(layout="peppapig")
+    with raises(TypeError):
+        wizard.read(layout=1)
+
+    for io_mode in ("fread", "mmap"):
+        wizard.set_io_mode(io_mode)
+        cols = wizard.read(layout="soa")
+        assert isinstance(cols, dict) and tuple(cols.keys()) == ("t", "x", "y", "p")
+        arr = np.empty((len(cols["t"]),), dtype=ref_arr.dtype)
+        for field, col in cols.items():
+            assert col.flags["C_CONTIGUOUS"]
+            assert len(col) == len(ref_arr)
+            assert col.dtype == ref_arr.dtype[field]
+            arr[field] = col
+        _test_fields(ref_arr, arr, sensor_size)
+
+        # Narrowed layouts.
+        cols = wizard.read(layout="compact")
+        assert tuple(cols.keys()) == ("t", "x", "y", "p", "t_base")
+        assert cols["t_base"] == ref_arr["t"][0]
+        assert cols["t"].dtype == np.int32
+        assert cols["x"].dtype == cols["y"].dtype == np.uint16
+        arr = np.empty((len(cols["t"]),), dtype=ref_arr.dtype)
+        for field in ("t", "x", "y", "p"):
+            arr[field] = cols[field]
+        arr["t"] += cols["t_base"]
+        _test_fields(ref_arr, arr, sensor_size)
+
+        packed = wizard.read(layout="packed")
+        assert packed["events"].dtype == np.uint64
+        assert packed["t_base"] == ref_arr["t"][0]
+        arr = unpack_events(packed["events"], packed["t_base"])
+        assert arr.dtype == ref_arr.dtype
+        _test_fields(ref_arr, arr, sensor_size)
+
+    # The timestamps preceding the first one, after a backward jump, are
+    # clamped to it. DAT and EVT3 files take the jump as a timestamp overflow.
+    if encoding == "evt2":
+        nonmono = ref_arr[:2000].copy()
+        nonmono["t"][:1000] += 50000
+        nonmono_fpath = pathlib.Path(TMPDIR, "test_layout_nonmono_" + fname)
+        wizard.save(nonmono_fpath, nonmono)
+        wizard.set_file(nonmono_fpath)
+        packed = wizard.read(layout="packed")
+        arr = unpack_events(packed["events"], packed["t_base"])
+        assert (arr["t"] == np.maximum(nonmono["t"], nonmono["t"][0])).all()
+        assert all((arr[field] == nonmono[field]).all() for field in ("x", "y", "p"))
+        cols = wizard.read(layout="compact")
+        assert (cols["t"] + cols["t_base"] == nonmono["t"]).all()
+        os.remove(nonmono_fpath)
+    return
+
+
+def test_projection(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, chunk_size=8192, time_window=20)
+
+    # Error checking in read.
+    with raises(TypeError):
+        wizard.read(fields="t")
+    with raises(ValueError):
+        wizard.read(fields=("t", "t"))
+    with raises(ValueError):
+        wizard.read(fields=("t", "peppapig"))
+    with raises(ValueError):
+        wizard.read(fields=())
+    with raises(ValueError):
+        wizard.read(fields=("t",), layout="packed")
+
+    for fields in (("t",), ("x", "y"), ("p", "t", "y")):
+        cols = wizard.read(fields=fields)
+        assert tuple(cols.keys()) == fields
+        for field in fields:
+            assert cols[field].dtype == ref_arr.dtype[field]
+            assert (cols[field] == ref_arr[field]).all()
+
+        cols = wizard.read(fields=fields, layout="compact")
+        assert tuple(cols.keys()) == fields + (("t_base",) if "t" in fields else ())
+        for field in fields:
+            ref_col = ref_arr[field] - (cols["t_base"] if field == "t" else 0)
+            assert (cols[field] == ref_col).all()
+
+        # The last window spans many blocks of the C staging array.
+        for read_fn, time_window in (
+            (wizard.read_chunk, 20),
+            (wizard.read_time_window, 20),
+            (wizard.read_time_window, 10**6),
+        ):
+            wizard.set_time_window(time_window)
+            chunks = [chunk for chunk in read_fn(fields)]
+            assert all(tuple(chunk.keys()) == fields for chunk in chunks)
+            for field in fields:
+                col = np.concatenate([chunk[field] for chunk in chunks])
+                assert (col == ref_arr[field]).all()
+    return
+
+
+def test_index(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # The sidecar is written next to the recording, so a copy is used.
+    tmp_fpath = pathlib.Path(TMPDIR, fname)
+    shutil.copy(fpath, tmp_fpath)
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath, chunk_size=5000)
+
+    # Error checking in build_index.
+    with raises(ValueError):
+        wizard.build_index(step_events=None, step_time=None)
+    with raises(ValueError):
+        wizard.build_index(step_events=0)
+    with raises(TypeError):
+        wizard.build_index(step_time=1.5)
+
+    for step_events, step_time in ((4096, None), (None, 1000), (10000, 500)):
+        index_fpath = wizard.build_index(step_events=step_events, step_time=step_time)
+        assert index_fpath.is_file()
+        # Any Wizard reading the file reuses the sidecar.
+        entries = Wizard(encoding=encoding, fpath=tmp_fpath).load_index()
+        assert entries is not None and entries["ordinal"][0] == 0
+        assert (np.diff(entries["ordinal"].astype(np.int64)) > 0).all()
+        if step_events is not None:
+            assert (
+                np.diff(entries["ordinal"].astype(np.int64)) <= step_events + 12
+            ).all()
+        assert (ref_arr["t"][entries["ordinal"]] == entries["t"]).all()
+        # Only the byte to resume from is kept in the events information.
+        events_info = entries["cargo"]["events_info"]
+        for name in events_info.dtype.names:
+            if name != "start_byte":
+                assert (events_info[name] == 0).all()
+
+        # Resuming from the entries.
+        for k in (0, len(entries) // 2, len(entries) - 1):
+            ordinal = wizard.seek(int(entries["t"][k]) + 1)
+            assert ordinal == entries["ordinal"][k]
+            arr = np.concatenate([chunk for chunk in wizard.read_chunk()])
+            assert (arr == ref_arr[ordinal:]).all()
+            wizard.seek(int(entries["t"][k]))
+            arr = np.concatenate([window for window in wizard.read_time_window()])
+            assert (arr == ref_arr[ordinal:]).all()
+
+    # The index is out of date when the recording is modified: it is built
+    # again in memory, without writing the sidecar.
+    os.utime(tmp_fpath, ns=(0, 0))
+    assert wizard.load_index() is None
+    assert (wizard.read_events(1000, 10) == ref_arr[1000:1010]).all()
+    assert wizard.load_index() is None
+    os.remove(index_fpath)
+    # The recording can be read from a directory without write permissions.
+    read_only = pathlib.Path(TMPDIR, "read_only")
+    read_only.mkdir(exist_ok=True)
+    shutil.copy(fpath, read_only.joinpath(fname))
+    read_only.chmod(0o555)
+    try:
+        wizard = Wizard(encoding=encoding, fpath=read_only.joinpath(fname))
+        assert (wizard.read_events(1000, 10) == ref_arr[1000:1010]).all()
+        t_mid = int(ref_arr["t"][len(ref_arr) // 2])
+        ref = ref_arr[(ref_arr["t"] >= t_mid) & (ref_arr["t"] < t_mid + 1000)]
+        assert (wizard.read_range(t_mid, t_mid + 1000) == ref).all()
+        assert list(read_only.iterdir()) == [read_only.joinpath(fname)]
+    finally:
+        read_only.chmod(0o755)
+        shutil.rmtree(read_only)
+    os.remove(tmp_fpath)
+    return
+
+
+def test_range(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # The sidecar is written next to the recording, so a copy is used.
+    tmp_fpath = pathlib.Path(TMPDIR, fname)
+    shutil.copy(fpath, tmp_fpath)
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath)
+
+    # Error checking.
+    with raises(TypeError):
+        wizard.read_range(0, 1.5)
+    with raises(ValueError):
+        wizard.read_range(10, 10)
+    with raises(TypeError):
+        wizard.read_events("0", 10)
+    with raises(ValueError):
+        wizard.read_events(-1, 10)
+    with raises(ValueError):
+        wizard.read_events(0, 0)
+
+    wizard.build_index(step_events=4096)
+    t_first, t_last = int(ref_arr["t"][0]), int(ref_arr["t"][-1])
+    t_mid = int(ref_arr["t"][len(ref_arr) // 2])
+    for t_start, t_end in (
+        (t_first, t_last + 1),
+        (t_first - 100, t_first + 1),
+        (t_mid, t_mid + 1),
+        (t_mid - 5000, t_mid + 5000),
+        (t_last, t_last + 100),
+        (t_last + 1, t_last + 100),
+    ):
+        arr = wizard.read_range(t_start, t_end)
+        ref = ref_arr[(ref_arr["t"] >= t_start) & (ref_arr["t"] < t_end)]
+        assert len(arr) == len(ref) and (arr == ref).all()
+
+    for first, count in (
+        (0, 10),
+        (4095, 3),
+        (len(ref_arr) // 2, 50000),
+        (len(ref_arr) - 5, 100),
+        (len(ref_arr), 1),
+    ):
+        arr = wizard.read_events(first, count)
+        ref = ref_arr[first : first + count]
+        assert len(arr) == len(ref) and (arr == ref).all()
+
+    os.remove(pathlib.Path(str(tmp_fpath) + ".idx"))
+    os.remove(tmp_fpath)
+    return
+
+
+def test_seek(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # Without a sidecar, the file is bisected and no index is built.
+    tmp_fpath = pathlib.Path(TMPDIR, fname)
+    shutil.copy(fpath, tmp_fpath)
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath, chunk_size=8192)
+    t_first, t_last = int(ref_arr["t"][0]), int(ref_arr["t"][-1])
+    t_mid = int(ref_arr["t"][len(ref_arr) // 2])
+    for t_start, t_end in (
+        (t_first, t_last + 1),
+        (t_first - 100, t_first + 1),
+        (t_mid, t_mid + 1),
+        (t_mid - 5000, t_mid + 5000),
+        (t_last, t_last + 100),
+        (t_last + 1, t_last + 100),
+    ):
+        arr = wizard.read_range(t_start, t_end)
+        ref = ref_arr[(ref_arr["t"] >= t_start) & (ref_arr["t"] < t_end)]
+        assert len(arr) == len(ref) and (arr == ref).all()
+
+    # The generators resume before the first event with timestamp t.
+    for t in (t_first, t_mid, t_last):
+        assert wizard.seek(t) is None
+        arr = np.concatenate([chunk for chunk in wizard.read_chunk()])
+        ref = ref_arr[ref_arr["t"] >= t]
+        assert (arr[arr["t"] >= t] == ref).all()
+        assert len(arr) - len(ref) <= len(ref_arr[ref_arr["t"] > t - 128]) - len(ref)
+    assert wizard.load_index() is None
+    os.remove(tmp_fpath)
+    return
+
+
+def test_dat_seek_overflows():
+    # A DAT recording spanning several overflows of the 32 bits timestamps,
+    # with long gaps and bursts of events with the same timestamp.
+    fpath = pathlib.Path("tests", "sample-files", "dat_sample.dat").resolve()
+    with open(fpath, "rb") as fp:
+        data = fp.read()
+    start = 0
+    while data[start : start + 1] == b"%":
+        start = data.index(b"\n", start) + 1
+    header = data[: start + 2]
+
+    rng = np.random.default_rng(42)
+    nevents = 60000
+    steps = rng.exponential(350000, nevents).astype(np.int64)
+    steps[20000] = 3 * 2**30
+    steps[30000] = 2**31 + 12345
+    steps[40000:45000] = rng.integers(0, 2, 5000)
+    ref_arr = np.empty((nevents,), dtype=np.load(fpath.with_suffix(".npy")).dtype)
+    ref_arr["t"] = np.cumsum(steps)
+    ref_arr["x"] = rng.integers(0, 640, nevents)
+    ref_arr["y"] = rng.integers(0, 480, nevents)
+    ref_arr["p"] = rng.integers(0, 2, nevents)
+    assert ref_arr["t"][-1] > 4 * 2**32
+    words = (
+        (ref_arr["t"].astype(np.uint64) & np.uint64(0xFFFFFFFF))
+        | (ref_arr["x"].astype(np.uint64) << np.uint64(32))
+        | (ref_arr["y"].astype(np.uint64) << np.uint64(46))
+        | (ref_arr["p"].astype(np.uint64) << np.uint64(60))
+    )
+    tmp_fpath = pathlib.Path(TMPDIR, "overflows.dat")
+    with open(tmp_fpath, "wb") as fp:
+        fp.write(header)
+        words.tofile(fp)
+
+    wizard = Wizard(encoding="dat", fpath=tmp_fpath, chunk_size=8192)
+    assert (wizard.read() == ref_arr).all()
+    for k in (0, 1, 15000, 20000, 20001, 30000, 41234, 44999, nevents - 1):
+        t = int(ref_arr["t"][k])
+        for t_start, t_end in ((t, t + 1), (t - 2**31, t + 2**30), (t + 1, t + 2**33)):
+            arr = wizard.read_range(t_start, t_end)
+            ref = ref_arr[(ref_arr["t"] >= t_start) & (ref_arr["t"] < t_end)]
+            assert len(arr) == len(ref) and (arr == ref).all()
+        assert wizard.seek(t) is None
+        arr = np.concatenate([chunk for chunk in wizard.read_chunk()])
+        assert (arr == ref_arr[ref_arr["t"] >= t]).all()
+    os.remove(tmp_fpath)
+    return
+
+
+def test_split(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+    fpath_out = TMPDIR.joinpath("test_split" + encoding)
+    fpath_out.mkdir(exist_ok=True)
+    out_pattern = fpath_out.joinpath("clip_{:04d}." + fname.split(".")[1])
+    wizard = Wizard(encoding=encoding, fpath=fpath)
+
+    # Error checking on the pattern and the duration.
+    with raises(TypeError):
+        wizard.split(out_pattern=12, duration=1000)
+    with raises(ValueError):
+        wizard.split(out_pattern=fpath_out.joinpath("clip.raw"), duration=1000)
+    with raises(ValueError):
+        wizard.split(out_pattern=fpath_out.joinpath("clip_{}.txt"), duration=1000)
+    with raises(ValueError):
+        wizard.split(out_pattern=out_pattern, duration=0)
+
+    # More clips than the paths provided to each C call.
+    t_first = int(ref_arr["t"][0])
+    for duration in (500, 7000):
+        fpaths = wizard.split(out_pattern=out_pattern, duration=duration)
+        assert len(fpaths) == (int(ref_arr["t"][-1]) - t_first) // duration + 1
+        nevents = 0
+        for k, clip_fpath in enumerate(fpaths):
+            arr = wizard.read(fpath=clip_fpath)
+            ref = ref_arr[
+                (ref_arr["t"] >= t_first + k * duration)
+                & (ref_arr["t"] < t_first + (k + 1) * duration)
+            ]
+            # An empty recording is read as None.
+            if len(ref) == 0:
+                assert arr is None
+                continue
+            assert len(arr) == len(ref)
+            for field in ("x", "y", "p"):
+                assert (arr[field] == ref[field]).all()
+            # The EVT3 timestamp overflows are not restored.
+            t_shift = int(ref["t"][0] - arr["t"][0])
+            assert t_shift == 0 or (encoding == "evt3" and t_shift % 4096 == 0)
+            assert (arr["t"] + t_shift == ref["t"]).all()
+            nevents += len(arr)
+        assert nevents == len(ref_arr)
+        for clip_fpath in fpaths:
+            os.remove(clip_fpath)
+    shutil.rmtree(fpath_out)
+    return
+
+
+def test_filter(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    # The EVT3 range reads build an index, that is not written next to the copy.
+    tmp_fpath = pathlib.Path(TMPDIR, "filter_" + fname)
+    shutil.copy(fpath, tmp_fpath)
+    wizard = Wizard(
+        encoding=encoding, fpath=tmp_fpath, chunk_size=4096, time_window=500
+    )
+
+    # Error checking in set_filter.
+    with raises(TypeError):
+        wizard.set_filter(roi=(0, 10, 0))
+    with raises(TypeError):
+        wizard.set_filter(roi=[(0, 10, 0, 1.5)])
+    with raises(ValueError):
+        wizard.set_filter(roi=(10, 10, 0, 10))
+    with raises(TypeError):
+        wizard.set_filter(polarity="on")
+    with raises(ValueError):
+        wizard.set_filter(polarity=(16,))
+
+    x_q = [int(q) for q in np.quantile(ref_arr["x"], (0.2, 0.5, 0.7))]
+    y_q = [int(q) for q in np.quantile(ref_arr["y"], (0.3, 0.6, 0.9))]
+    # Overlapping boxes, with bounds not aligned to the EVT3 vectors.
+    boxes = [
+        (x_q[0] + 3, x_q[2] + 5, y_q[0], y_q[1]),
+        (x_q[1], x_q[2] + 29, y_q[1] - 7, y_q[2]),
+    ]
+    for roi, polarity in (
+        (boxes[0], None),
+        (boxes, None),
+        (None, 1),
+        (boxes, (0,)),
+    ):
+        mask = np.zeros((len(ref_arr),), dtype=bool)
+        for x_min, x_max, y_min, y_max in (
+            boxes if isinstance(roi, list) else ([roi] if roi is not None else [])
+        ):
+            mask |= (
+                (ref_arr["x"] >= x_min)
+                & (ref_arr["x"] < x_max)
+                & (ref_arr["y"] >= y_min)
+                & (ref_arr["y"] < y_max)
+            )
+        if roi is None:
+            mask[:] = True
+        if polarity is not None:
+            polarities = (polarity,) if isinstance(polarity, int) else polarity
+            mask &= np.isin(ref_arr["p"], polarities)
+        filt_arr = ref_arr[mask]
+        assert 0 < len(filt_arr) < len(ref_arr)
+
+        wizard.set_filter(roi=roi, polarity=polarity)
+        arr = wizard.read()
+        assert len(arr) == len(filt_arr) and (arr == filt_arr).all()
+        cols = wizard.read(fields=("t", "x"))
+        assert (cols["t"] == filt_arr["t"]).all() and (cols["x"] == filt_arr["x"]).all()
+
+        chunks = [chunk for chunk in wizard.read_chunk()]
+        assert all(len(chunk) >= wizard.chunk_size for chunk in chunks[:-1])
+        assert (np.concatenate(chunks) == filt_arr).all()
+
+        wizard.reset()
+        windows = [window for window in wizard.read_time_window()]
+        assert all(
+            window["t"][-1] - window["t"][0] >= wizard.time_window
+            for window in windows[:-1]
+        )
+        assert (np.concatenate(windows) == filt_arr).all()
+
+        t_start, t_end = int(filt_arr["t"][len(filt_arr) // 3]), int(filt_arr["t"][-1])
+        arr = wizard.read_range(t_start, t_end)
+        ref_range = filt_arr[(filt_arr["t"] >= t_start) & (filt_arr["t"] < t_end)]
+        assert len(arr) == len(ref_range) and (arr == ref_range).all()
+
+    # Removing the filter.
+    wizard.set_filter()
+    assert len(wizard.read()) == len(ref_arr)
+    assert not pathlib.Path(str(tmp_fpath) + ".idx").exists()
+    os.remove(tmp_fpath)
+    return
+
+
+def _transform_events(
+    arr: np.ndarray, downscale: int, t_bin: int, refractory: int, dedup: bool
+) -> np.ndarray:
+    arr = arr.copy()
+    arr["x"] //= downscale
+    arr["y"] //= downscale
+    arr["t"] -= arr["t"] % t_bin
+    if refractory == 0 and dedup:
+        # The timestamps are sorted, so the first copy of each event is kept.
+        _, first = np.unique(arr[["t", "x", "y", "p"]], return_index=True)
+        return arr[np.sort(first)]
+    if refractory > 0:
+        last_t, keep = {}, np.zeros((len(arr),), dtype=bool)
+        for k, (t, x, y, p) in enumerate(
+            zip(arr["t"].tolist(), arr["x"].tolist(), arr["y"].tolist(), arr["p"])
+        ):
+            key = (x, y, p & 1)
+            if key not in last_t or t >= last_t[key] + refractory:
+                last_t[key] = t
+                keep[k] = True
+        return arr[keep]
+    return arr
+
+
+def test_transform(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple,
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, chunk_size=4096, time_window=500)
+
+    # Error checking in set_transform.
+    with raises(ValueError):
+        wizard.set_transform(downscale=0)
+    with raises(TypeError):
+        wizard.set_transform(t_bin=1.5)
+    with raises(TypeError):
+        wizard.set_transform(dedup=1)
+    with raises(ValueError):
+        wizard.set_transform(refractory=100)
+    with raises(TypeError):
+        wizard.set_transform(dedup=True, sensor_size=[640, 480])
+
+    roi = (sensor_size[0] // 4, sensor_size[0] // 2 + 3, 0, sensor_size[1] // 2)
+    for downscale, t_bin, refractory, dedup, box in (
+        (2, 1, 0, False, None),
+        (1, 100, 0, True, None),
+        (4, 50, 0, True, roi),
+        (2, 1, 1000, False, roi),
+    ):
+        ref_sel = ref_arr
+        if box is not None:
+            ref_sel = ref_arr[
+                (ref_arr["x"] >= box[0])
+                & (ref_arr["x"] < box[1])
+                & (ref_arr["y"] >= box[2])
+                & (ref_arr["y"] < box[3])
+            ]
+        ref = _transform_events(ref_sel, downscale, t_bin, refractory, dedup)
+        assert 0 < len(ref)
+
+        wizard.set_filter(roi=box)
+        wizard.set_transform(
+            downscale=downscale,
+            t_bin=t_bin,
+            refractory=refractory,
+            dedup=dedup,
+            sensor_size=sensor_size,
+        )
+        arr = wizard.read()
+        assert len(arr) == len(ref) and (arr == ref).all()
+        cols = wizard.read(layout="compact")
+        assert (cols["t"] + cols["t_base"] == ref["t"]).all()
+        assert (cols["x"] == ref["x"]).all()
+
+        chunks = [chunk for chunk in wizard.read_chunk()]
+        assert (np.concatenate(chunks) == ref).all()
+        wizard.reset()
+        windows = [window for window in wizard.read_time_window()]
+        assert (np.concatenate(windows) == ref).all()
+
+    # Removing the transforms.
+    wizard.set_filter()
+    wizard.set_transform()
+    assert (wizard.read() == ref_arr).all()
+    return
+
+
+def _add_triggers(
+    encoding: str, fpath: pathlib.Path, fpath_out: pathlib.Path, step: int
+):
+    # The trigger events are put before one CD word out of 'step', and they
+    # share its timestamp.
+    data = fpath.read_bytes()
+    start = 0
+    while data[start : start + 1] == b"%":
+        start = data.index(b"\n", start) + 1
+    word_dtype = np.dtype("<u4") if encoding == "evt2" else np.dtype("<u2")
+    words = np.frombuffer(data[start:], dtype=word_dtype)
+    types = words >> (28 if encoding == "evt2" else 12)
+    if encoding == "evt2":
+        nevents = (types <= 1).astype(np.int64)
+        positions = np.flatnonzero(types <= 1)[::step]
+    else:
+        mask_bits = np.zeros((len(words),), dtype=np.int64)
+        for word_type, nbits in ((4, 12), (5, 8)):
+            sel = types == word_type
+            masks = words[sel].astype(np.int64) & ((1 << nbits) - 1)
+            mask_bits[sel] = [bin(mask).count("1") for mask in masks.tolist()]
+        nevents = (types == 2).astype(np.int64) + mask_bits
+        positions = np.flatnonzero(types == 2)[::step]
+    # Number of events preceding each position.
+    ordinals = np.concatenate(([0], np.cumsum(nevents)))[positions]
+    ids = np.arange(len(positions)) % 3
+    values = (np.arange(len(positions)) // 3 + 1) % 2
+    if encoding == "evt2":
+        trig_words = (
+            (np.uint32(0xA) << np.uint32(28))
+            | (words[positions] & np.uint32(0x3F << 22))
+            | (ids.astype(np.uint32) << np.uint32(8))
+            | values.astype(np.uint32)
+        ).astype(word_dtype)
+    else:
+        trig_words = ((0xC << 12) | (ids << 8) | values).astype(word_dtype)
+    out_words = np.insert(words, positions, trig_words)
+    fpath_out.write_bytes(data[:start] + out_words.tobytes())
+    return ordinals, ids, values
+
+
+def test_triggers(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    tmp_fpath = pathlib.Path(TMPDIR, "triggers_" + fname)
+    ordinals, ids, values = _add_triggers(encoding, fpath, tmp_fpath, step=150)
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath, chunk_size=1000)
+
+    # Error checking.
+    with raises(TypeError):
+        wizard.read(triggers=1)
+    with raises(ValueError):
+        next(wizard.read_trigger_windows(value=2))
+    with raises(TypeError):
+        next(wizard.read_trigger_windows(channel="0"))
+
+    # The trigger events do not change the CD events.
+    assert (wizard.read() == ref_arr).all()
+    for layout in ("aos", "soa"):
+        arr, trig = wizard.read(layout=layout, triggers=True)
+        assert (arr["t"] == ref_arr["t"]).all()
+        assert len(trig) == len(ordinals)
+        assert (trig["t"] == ref_arr["t"][ordinals]).all()
+        assert (trig["id"] == ids).all() and (trig["value"] == values).all()
+
+    for channel, value in ((None, None), (1, None), (2, 0)):
+        sel = np.ones((len(ordinals),), dtype=bool)
+        if channel is not None:
+            sel &= ids == channel
+        if value is not None:
+            sel &= values == value
+        t_trig = ref_arr["t"][ordinals[sel]].tolist()
+        wizard.reset()
+        windows = [w for w in wizard.read_trigger_windows(channel, value)]
+        assert len(windows) == len(t_trig) - 1
+        for (t_start, t_end, window), t_a, t_b in zip(windows, t_trig, t_trig[1:]):
+            assert (t_start, t_end) == (t_a, t_b)
+            ref_window = ref_arr[
+                np.searchsorted(ref_arr["t"], t_a) : np.searchsorted(ref_arr["t"], t_b)
+            ]
+            assert len(window) == len(ref_window) and (window == ref_window).all()
+    os.remove(tmp_fpath)
+    return
+
+
+def test_no_triggers(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+):
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    wizard = Wizard(encoding=encoding, fpath=fpath)
+    arr, trig = wizard.read(triggers=True)
+    assert len(arr) > 0 and len(trig) == 0
+    assert len([w for w in wizard.read_trigger_windows()]) == 0
+    return
+
+
+def _accumulate(arr: np.ndarray, mode: str, sensor_size: tuple) -> np.ndarray:
+    width, height = sensor_size
+    p = arr["p"].astype(np.int64) & 1
+    if mode == "signed":
+        frame = np.zeros((1, height, width), dtype=np.int32)
+        np.add.at(frame, (0, arr["y"], arr["x"]), 2 * p - 1)
+    else:
+        frame = np.zeros((2, height, width), dtype=np.int32)
+        np.add.at(frame, (p, arr["y"], arr["x"]), 1)
+        if mode == "binary":
+            frame = (frame > 0).astype(np.int32)
+    return frame
+
+
+def test_frames(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple,
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, chunk_size=20000)
+
+    # Error checking in read_frames.
+    with raises(TypeError):
+        next(wizard.read_frames(sensor_size=[640, 480]))
+    with raises(ValueError):
+        next(wizard.read_frames(sensor_size=sensor_size, mode="peppapig"))
+    with raises(ValueError):
+        next(wizard.read_frames(sensor_size=sensor_size, event_count=0))
+
+    # Many frames are filled by each call, the last one not in full.
+    for mode, time_window in (("count", 997), ("binary", 4000), ("signed", 1500)):
+        wizard.set_time_window(time_window)
+        t_first = int(ref_arr["t"][0])
+        nframes = (int(ref_arr["t"][-1]) - t_first) // time_window + 1
+        k = 0
+        for k, (t_start, frame) in enumerate(wizard.read_frames(sensor_size, mode)):
+            assert t_start == t_first + k * time_window
+            first, last = np.searchsorted(
+                ref_arr["t"], (t_start, t_start + time_window)
+            )
+            assert (frame == _accumulate(ref_arr[first:last], mode, sensor_size)).all()
+        assert k + 1 == nframes
+
+    # The frames of a fixed number of events hold the same events of the chunks.
+    wizard.reset()
+    chunks = [chunk for chunk in wizard.read_chunk()]
+    wizard.reset()
+    frames = [frame for frame in wizard.read_frames(sensor_size, event_count=20000)]
+    assert len(frames) == len(chunks)
+    for (t_start, frame), chunk in zip(frames, chunks):
+        assert t_start == chunk["t"][0]
+        assert (frame == _accumulate(chunk, "count", sensor_size)).all()
+
+    # Only the events kept by the filters are accumulated.
+    wizard.reset()
+    wizard.set_transform(downscale=4)
+    small_size = tuple((size + 3) // 4 for size in sensor_size)
+    arr = wizard.read()
+    frame = sum(frame for _, frame in wizard.read_frames(small_size))
+    assert (frame == _accumulate(arr, "count", small_size)).all()
+    return
+
+
+def _voxelize(
+    arr: np.ndarray, t_start: int, time_window: int, bins: int, sensor_size: tuple
+) -> np.ndarray:
+    width, height = sensor_size
+    voxel = np.zeros((bins, height, width), dtype=np.float32)
+    pos = np.clip((arr["t"] - t_start) * (bins - 1) / time_window, 0, bins - 1)
+    b = pos.astype(np.int64)
+    weight = pos - b
+    sign = 2 * (arr["p"].astype(np.int64) & 1) - 1
+    np.add.at(voxel, (b, arr["y"], arr["x"]), sign * (1 - weight))
+    upper = weight > 0
+    np.add.at(
+        voxel,
+        (b[upper] + 1, arr["y"][upper], arr["x"][upper]),
+        sign[upper] * weight[upper],
+    )
+    return voxel
+
+
+def _surface(last_t: np.ndarray, t_end: int, tau: float) -> np.ndarray:
+    fired = last_t != np.iinfo(np.int64).min
+    surface = np.zeros(last_t.shape, dtype=np.float32)
+    surface[fired] = np.exp(-(t_end - last_t[fired]) / tau)
+    return surface
+
+
+def test_representations(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple,
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+    # The threads locate their frames through the index, that is built in
+    # memory without writing a sidecar next to the copy of the file.
+    tmp_fpath = pathlib.Path(TMPDIR, "test_representations_" + fname)
+    shutil.copy(fpath, tmp_fpath)
+
+    time_window, bins, tau = 2000, 5, 3000.0
+    wizard = Wizard(encoding=encoding, fpath=tmp_fpath, time_window=time_window)
+
+    # Error checking in read_frames.
+    with raises(TypeError):
+        next(wizard.read_frames(sensor_size, mode="voxel", bins=2.5))
+    with raises(ValueError):
+        next(wizard.read_frames(sensor_size, mode="voxel", bins=0))
+    with raises(ValueError):
+        next(wizard.read_frames(sensor_size, mode="voxel", event_count=1000))
+    with raises(ValueError):
+        next(wizard.read_frames(sensor_size, mode="surface", tau=-1))
+
+    t_first = int(ref_arr["t"][0])
+    nframes = (int(ref_arr["t"][-1]) - t_first) // time_window + 1
+    width, height = sensor_size
+    for nthreads in (1, 4):
+        wizard.set_nthreads(nthreads)
+        # Voxel grids.
+        wizard.reset()
+        k = 0
+        for k, (t_start, voxel) in enumerate(
+            wizard.read_frames(sensor_size, mode="voxel", bins=bins)
+        ):
+            assert t_start == t_first + k * time_window
+            assert voxel.shape == (bins, height, width)
+            first, last = np.searchsorted(
+                ref_arr["t"], (t_start, t_start + time_window)
+            )
+            ref_voxel = _voxelize(
+                ref_arr[first:last], t_start, time_window, bins, sensor_size
+            )
+            assert np.allclose(voxel, ref_voxel, atol=1e-5)
+        assert k + 1 == nframes
+
+        # Time surfaces, computed at the end of each frame.
+        wizard.reset()
+        last_t = np.full((2, height, width), np.iinfo(np.int64).min, dtype=np.int64)
+        k = 0
+        for k, (t_start, surface) in enumerate(
+            wizard.read_frames(sensor_size, mode="surface", tau=tau)
+        ):
+            assert t_start == t_first + k * time_window
+            first, last = np.searchsorted(
+                ref_arr["t"], (t_start, t_start + time_window)
+            )
+            events = ref_arr[first:last]
+            np.maximum.at(
+                last_t, (events["p"] & 1, events["y"], events["x"]), events["t"]
+            )
+            ref_surface = _surface(last_t, t_start + time_window, tau)
+            assert np.allclose(surface, ref_surface, rtol=1e-5, atol=1e-7)
+        assert k + 1 == nframes
+
+    # The time surfaces of a fixed number of events are computed at their last
+    # event.
+    wizard.reset()
+    chunks = [chunk for chunk in wizard.read_chunk()]
+    wizard.reset()
+    last_t = np.full((2, height, width), np.iinfo(np.int64).min, dtype=np.int64)
+    surfaces = [
+        surface
+        for _, surface in wizard.read_frames(
+            sensor_size, mode="surface", event_count=wizard.chunk_size, tau=tau
+        )
+    ]
+    assert len(surfaces) == len(chunks)
+    for surface, chunk in zip(surfaces, chunks):
+        np.maximum.at(last_t, (chunk["p"] & 1, chunk["y"], chunk["x"]), chunk["t"])
+        ref_surface = _surface(last_t, int(chunk["t"][-1]), tau)
+        assert np.allclose(surface, ref_surface, rtol=1e-5, atol=1e-7)
+
+    assert not pathlib.Path(str(tmp_fpath) + ".idx").exists()
+    os.remove(tmp_fpath)
+
+    # The events older than their frame, after a backward jump of the
+    # timestamps, are put in the first bin of the voxel grid. DAT files take
+    # the jump as a timestamp overflow instead, as EVT3 ones do.
+    if encoding == "evt2":
+        nonmono = ref_arr[:2000].copy()
+        nonmono["t"][:1000] += 50000
+        nonmono_fpath = pathlib.Path(TMPDIR, "test_nonmono_" + fname)
+        wizard = Wizard(encoding=encoding, time_window=time_window)
+        wizard.save(nonmono_fpath, nonmono)
+        wizard.set_file(nonmono_fpath)
+        voxels = [
+            (t_start, voxel)
+            for t_start, voxel in wizard.read_frames(
+                sensor_size, mode="voxel", bins=bins
+            )
+        ]
+        t_start, voxel = voxels[-1]
+        # The frame holding the jump gets the older events too.
+        first = np.searchsorted(nonmono["t"][:1000], t_start)
+        ref_voxel = _voxelize(nonmono[first:], t_start, time_window, bins, sensor_size)
+        assert np.allclose(voxel, ref_voxel, atol=1e-4)
+        sign = 2 * (nonmono["p"].astype(np.int64) & 1) - 1
+        assert np.isclose(sum(v.sum() for _, v in voxels), sign.sum(), atol=1e-2)
+        os.remove(nonmono_fpath)
+    return
+
+
+def test_hot_pixels(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple,
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+    width, height = sensor_size
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, chunk_size=8192)
+
+    # Error checking.
+    with raises(TypeError):
+        wizard.profile_pixels(sensor_size=[width, height])
+    with raises(TypeError):
+        wizard.set_hot_pixels(np.zeros((height, width), dtype=np.uint8))
+    with raises(TypeError):
+        find_hot_pixels(np.zeros((width,)))
+    with raises(ValueError):
+        find_hot_pixels(np.zeros((height, width)), ratio=0)
+
+    # The profile counts the events of each pixel of the sensor.
+    counts = wizard.profile_pixels(sensor_size)
+    ref_counts = np.zeros((height, width), dtype=np.uint32)
+    np.add.at(ref_counts, (ref_arr["y"], ref_arr["x"]), 1)
+    assert counts.dtype == np.uint32 and (counts == ref_counts).all()
+    # The events out of a smaller profile are not counted.
+    small_counts = wizard.profile_pixels((width // 2, height // 2))
+    assert (small_counts == ref_counts[: height // 2, : width // 2]).all()
+
+    # The busiest pixels are taken as the hot ones.
+    threshold = int(np.sort(counts, axis=None)[-20])
+    hot_pixels = find_hot_pixels(counts, threshold=threshold)
+    assert hot_pixels.sum() > 0
+    assert (find_hot_pixels(counts, ratio=1e9) == False).all()
+    hot = hot_pixels[ref_arr["y"], ref_arr["x"]]
+    ref_kept = ref_arr[~hot]
+
+    # The mask is saved and loaded back.
+    mask_fpath = pathlib.Path(TMPDIR, "test_hot_pixels_" + encoding + ".txt")
+    save_hot_pixels(mask_fpath, hot_pixels)
+    loaded = load_hot_pixels(mask_fpath)
+    os.remove(mask_fpath)
+    assert loaded.shape == hot_pixels.shape and (loaded == hot_pixels).all()
+
+    # The events of the hot pixels never reach the output.
+    wizard.set_hot_pixels(loaded)
+    arr = wizard.read()
+    assert len(arr) == len(ref_kept)
+    for field in ("t", "x", "y", "p"):
+        assert (arr[field] == ref_kept[field]).all()
+    chunks = [chunk for chunk in wizard.read_chunk()]
+    assert all(len(chunk) <= wizard.chunk_size + _VECT_SLACK for chunk in chunks)
+    assert (np.concatenate(chunks)["t"] == ref_kept["t"]).all()
+    wizard.set_time_window(5000)
+    windows = [window for window in wizard.read_time_window()]
+    assert sum(len(window) for window in windows) == len(ref_kept)
+    # The profile ignores the mask.
+    assert (wizard.profile_pixels(sensor_size) == counts).all()
+
+    # Combined with the other filters.
+    wizard.set_filter(polarity=1)
+    arr = wizard.read()
+    assert (arr["t"] == ref_kept[ref_kept["p"] == 1]["t"]).all()
+
+    # Removing the mask.
+    wizard.set_filter()
+    wizard.set_hot_pixels()
+    assert len(wizard.read()) == len(ref_arr)
+    return
+
+
+def _denoise_events(arr: np.ndarray, background: int, sensor_size: tuple) -> np.ndarray:
+    # An event is kept if a previous one of a neighbouring pixel has a
+    # timestamp not older than 'background': for each neighbour offset, the
+    # events and their neighbours are sorted by pixel and position, so that
+    # the last event of each neighbour is found by a running maximum.
+    width, height = sensor_size
+    n = len(arr)
+    x, y = arr["x"].astype(np.int64), arr["y"].astype(np.int64)
+    t = arr["t"].astype(np.int64) - int(arr["t"].min()) + 1
+    pixel, position = y * width + x, np.arange(n)
+    support = np.zeros((n,), dtype=np.int64)
+    for dx, dy in [(i, j) for i in (-1, 0, 1) for j in (-1, 0, 1) if i or j]:
+        valid = (x + dx >= 0) & (x + dx < width) & (y + dy >= 0) & (y + dy < height)
+        keys = np.concatenate((pixel, ((y + dy) * width + x + dx)[valid]))
+        positions = np.concatenate((position, position[valid]))
+        is_query = np.concatenate((np.zeros((n,), bool), np.ones(valid.sum(), bool)))
+        order = np.lexsort((is_query, positions, keys))
+        # The pixel in the upper bits resets the running maximum.
+        values = np.where(is_query, 0, np.concatenate((t, t[valid])))[order]
+        values = np.maximum.accumulate(values + (keys[order] << 40)) - (
+            keys[order] << 40
+        )
+        queries = is_query[order]
+        found = np.zeros((n,), dtype=np.int64)
+        found[positions[order][queries]] = values[queries]
+        support = np.maximum(support, found)
+    return arr[(support > 0) & (support >= t - background)]
+
+
+def test_denoise(
+    encoding: str,
+    fname: Union[str, pathlib.Path],
+    sensor_size: tuple,
+):
+    assert isinstance(fname, str) or isinstance(fname, pathlib.Path)
+    fpath = pathlib.Path("tests", "sample-files", fname).resolve()
+    assert fpath.is_file()
+    ref_fpath = pathlib.Path("tests", "sample-files", fname.split(".")[0] + ".npy")
+    ref_arr = np.load(ref_fpath)
+
+    wizard = Wizard(encoding=encoding, fpath=fpath, chunk_size=4096, time_window=500)
+
+    # Error checking in set_transform.
+    with raises(TypeError):
+        wizard.set_transform(background=1.5, sensor_size=sensor_size)
+    with raises(ValueError):
+        wizard.set_transform(background=-1, sensor_size=sensor_size)
+    with raises(ValueError):
+        wizard.set_transform(background=1000)
+
+    for downscale, refractory, background in (
+        (1, 0, 1000),
+        (1, 0, 50),
+        (2, 500, 2000),
+    ):
+        small_size = tuple((size + downscale - 1) // downscale for size in sensor_size)
+        ref = _transform_events(ref_arr, downscale, 1, refractory, False)
+        ref = _denoise_events(ref, background, small_size)
+        assert 0 < len(ref) < len(ref_arr)
+
+        wizard.set_transform(
+            downscale=downscale,
+            refractory=refractory,
+            sensor_size=sensor_size,
+            background=background,
+        )
+        arr = wizard.read()
+        assert len(arr) == len(ref) and (arr == ref).all()
+
+        # The map of the neighbours is carried across the chunks and windows.
+        chunks = [chunk for chunk in wizard.read_chunk()]
+        assert (np.concatenate(chunks) == ref).all()
+        wizard.reset()
+        windows = [window for window in wizard.read_time_window()]
+        assert (np.concatenate(windows) == ref).all()
+
+    # Removing the filter.
+    wizard.set_transform()
+    assert (wizard.read() == ref_arr).all()
+    return